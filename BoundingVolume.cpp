@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolume.cpp
+// ============
+// bounding spheres and axis-aligned boxes for meshes and scene objects
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolume.h"
+
+#include <algorithm>
+#include <cmath>
+
+/***********************************************************
+ *  CalculateBoundingVolume()
+ *
+ *  This function is used for calculating the box around the
+ *  vertex positions, and a sphere centered on that box that
+ *  reaches the farthest vertex.
+ ***********************************************************/
+BOUNDING_VOLUME CalculateBoundingVolume(
+	const float* vertices,
+	int vertexCount,
+	int stride)
+{
+	BOUNDING_VOLUME bounds;
+	bounds.aabbMin = glm::vec3(0.0f);
+	bounds.aabbMax = glm::vec3(0.0f);
+	bounds.sphereCenter = glm::vec3(0.0f);
+	bounds.sphereRadius = 0.0f;
+
+	if ((vertices == nullptr) || (vertexCount <= 0))
+	{
+		return(bounds);
+	}
+
+	bounds.aabbMin = glm::vec3(vertices[0], vertices[1], vertices[2]);
+	bounds.aabbMax = bounds.aabbMin;
+	for (int i = 1; i < vertexCount; i++)
+	{
+		const float* position = vertices + i * stride;
+		glm::vec3 point(position[0], position[1], position[2]);
+		bounds.aabbMin = glm::min(bounds.aabbMin, point);
+		bounds.aabbMax = glm::max(bounds.aabbMax, point);
+	}
+
+	bounds.sphereCenter = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (int i = 0; i < vertexCount; i++)
+	{
+		const float* position = vertices + i * stride;
+		glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - bounds.sphereCenter;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.sphereRadius = sqrtf(radiusSquared);
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  TransformBoundingVolume()
+ *
+ *  This function is used for moving a local bounding volume
+ *  into world space.  The box is rebuilt from the absolute
+ *  values of the rotation and scale, which gives the box
+ *  around the transformed box without visiting its corners,
+ *  and the sphere radius is grown by the largest axis scale.
+ ***********************************************************/
+BOUNDING_VOLUME TransformBoundingVolume(
+	const BOUNDING_VOLUME& localBounds,
+	const glm::mat4& modelMatrix)
+{
+	BOUNDING_VOLUME bounds;
+
+	glm::vec3 center = (localBounds.aabbMin + localBounds.aabbMax) * 0.5f;
+	glm::vec3 extent = (localBounds.aabbMax - localBounds.aabbMin) * 0.5f;
+
+	glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent(0.0f);
+	for (int column = 0; column < 3; column++)
+	{
+		worldExtent += glm::abs(glm::vec3(modelMatrix[column])) * extent[column];
+	}
+	bounds.aabbMin = worldCenter - worldExtent;
+	bounds.aabbMax = worldCenter + worldExtent;
+
+	float maxScale = std::max(
+		glm::length(glm::vec3(modelMatrix[0])),
+		std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+	bounds.sphereCenter = glm::vec3(modelMatrix * glm::vec4(localBounds.sphereCenter, 1.0f));
+	bounds.sphereRadius = localBounds.sphereRadius * maxScale;
+
+	return(bounds);
+}
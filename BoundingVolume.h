@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolume.h
+// ============
+// bounding spheres and axis-aligned boxes for meshes and scene objects
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  BOUNDING_VOLUME
+ *
+ *  An axis-aligned bounding box and a bounding sphere around
+ *  the same geometry.  The sphere is the cheaper test and the
+ *  box is the tighter one, so both are kept.
+ ***********************************************************/
+struct BOUNDING_VOLUME
+{
+	glm::vec3 aabbMin;
+	glm::vec3 aabbMax;
+	glm::vec3 sphereCenter;
+	float sphereRadius;
+};
+
+// calculate the bounding volume around a list of interleaved
+// vertex positions, stride is the number of floats per vertex
+BOUNDING_VOLUME CalculateBoundingVolume(
+	const float* vertices,
+	int vertexCount,
+	int stride);
+
+// transform a local bounding volume into the space of the
+// passed in model matrix, keeping it conservative
+BOUNDING_VOLUME TransformBoundingVolume(
+	const BOUNDING_VOLUME& localBounds,
+	const glm::mat4& modelMatrix);
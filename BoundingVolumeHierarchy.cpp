@@ -0,0 +1,758 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// bounding volume hierarchy over the scene objects for culling and queries
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+// declaration of the global variables and defines
+namespace
+{
+	// centroid bins tested for every split axis
+	const int SAH_BIN_COUNT = 16;
+	// nodes with this many objects or fewer are never split
+	const int MIN_SPLIT_COUNT = 2;
+	// deepest tree that is built, which bounds the size of
+	// the traversal stack every query uses
+	const int MAX_TREE_DEPTH = 60;
+	const int MAX_STACK_DEPTH = MAX_TREE_DEPTH + 2;
+
+	/***********************************************************
+	 *  HalfSurfaceArea()
+	 *
+	 *  Half the surface area of a box, which is all the surface
+	 *  area heuristic needs to compare splits.
+	 ***********************************************************/
+	float HalfSurfaceArea(const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+	{
+		glm::vec3 extent = aabbMax - aabbMin;
+		if ((extent.x < 0.0f) || (extent.y < 0.0f) || (extent.z < 0.0f))
+		{
+			return(0.0f);
+		}
+		return(extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	/***********************************************************
+	 *  IntersectRayBox()
+	 *
+	 *  Slab test of a ray against a box, returning the distance
+	 *  where the ray enters the box, or a negative value when
+	 *  the box is missed or lies behind the origin.
+	 ***********************************************************/
+	float IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& aabbMin,
+		const glm::vec3& aabbMax,
+		float maxDistance)
+	{
+		float nearDistance = 0.0f;
+		float farDistance = maxDistance;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (aabbMin[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (aabbMax[axis] - origin[axis]) * inverseDirection[axis];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			nearDistance = std::max(nearDistance, t0);
+			farDistance = std::min(farDistance, t1);
+			if (nearDistance > farDistance)
+			{
+				return(-1.0f);
+			}
+		}
+
+		return(nearDistance);
+	}
+
+	/***********************************************************
+	 *  IsBoxNearPoint()
+	 *
+	 *  True when any part of a box is within radius of a point.
+	 ***********************************************************/
+	bool IsBoxNearPoint(
+		const glm::vec3& aabbMin,
+		const glm::vec3& aabbMax,
+		const glm::vec3& center,
+		float radius)
+	{
+		glm::vec3 closest = glm::min(glm::max(center, aabbMin), aabbMax);
+		glm::vec3 offset = closest - center;
+		return(glm::dot(offset, offset) <= radius * radius);
+	}
+
+	/***********************************************************
+	 *  ElapsedMilliseconds()
+	 *
+	 *  Milliseconds since a benchmark start time.
+	 ***********************************************************/
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  ~BoundingVolumeHierarchy()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_objectIndices.clear();
+	m_objectBounds.clear();
+	m_objectLeaves.clear();
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree from scratch.
+ *  Nodes are split from the root down, with an explicit
+ *  stack instead of recursion, and every child is stored
+ *  after its parent so a reverse sweep visits children first.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const std::vector<BOUNDING_VOLUME>& objectBounds)
+{
+	const int objectCount = (int)objectBounds.size();
+
+	m_objectBounds = objectBounds;
+	m_nodes.clear();
+	m_parents.clear();
+	m_objectIndices.resize(objectCount);
+	m_objectLeaves.assign(objectCount, 0);
+
+	if (objectCount == 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centroids(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		m_objectIndices[i] = i;
+		centroids[i] = (objectBounds[i].aabbMin + objectBounds[i].aabbMax) * 0.5f;
+	}
+
+	// a binary tree over N leaves has fewer than 2N nodes
+	m_nodes.reserve(objectCount * 2);
+	m_parents.reserve(objectCount * 2);
+
+	BVH_NODE root;
+	root.leftOrFirst = 0;
+	root.count = objectCount;
+	m_nodes.push_back(root);
+	m_parents.push_back(-1);
+	UpdateNodeBounds(0);
+
+	// node index and depth of the nodes still to be split
+	std::vector<std::pair<int, int>> stack;
+	stack.push_back(std::make_pair(0, 0));
+	while (stack.empty() == false)
+	{
+		int nodeIndex = stack.back().first;
+		int depth = stack.back().second;
+		stack.pop_back();
+
+		if ((depth < MAX_TREE_DEPTH) && (Subdivide(nodeIndex, centroids)))
+		{
+			stack.push_back(std::make_pair(m_nodes[nodeIndex].leftOrFirst, depth + 1));
+			stack.push_back(std::make_pair(m_nodes[nodeIndex].leftOrFirst + 1, depth + 1));
+		}
+	}
+
+	// remember the leaf of every object for refitting
+	for (int nodeIndex = 0; nodeIndex < (int)m_nodes.size(); nodeIndex++)
+	{
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		for (int i = 0; i < node.count; i++)
+		{
+			m_objectLeaves[m_objectIndices[node.leftOrFirst + i]] = nodeIndex;
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateNodeBounds()
+ *
+ *  This method is used for setting the box of a leaf around
+ *  its objects, or the box of an inner node around its two
+ *  children.
+ ***********************************************************/
+void BoundingVolumeHierarchy::UpdateNodeBounds(int nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+
+	if (node.count == 0)
+	{
+		const BVH_NODE& left = m_nodes[node.leftOrFirst];
+		const BVH_NODE& right = m_nodes[node.leftOrFirst + 1];
+		node.aabbMin = glm::min(left.aabbMin, right.aabbMin);
+		node.aabbMax = glm::max(left.aabbMax, right.aabbMax);
+		return;
+	}
+
+	const BOUNDING_VOLUME& first = m_objectBounds[m_objectIndices[node.leftOrFirst]];
+	node.aabbMin = first.aabbMin;
+	node.aabbMax = first.aabbMax;
+	for (int i = 1; i < node.count; i++)
+	{
+		const BOUNDING_VOLUME& bounds = m_objectBounds[m_objectIndices[node.leftOrFirst + i]];
+		node.aabbMin = glm::min(node.aabbMin, bounds.aabbMin);
+		node.aabbMax = glm::max(node.aabbMax, bounds.aabbMax);
+	}
+}
+
+/***********************************************************
+ *  Subdivide()
+ *
+ *  This method is used for splitting a leaf in two.  The
+ *  object centroids are dropped into bins along each axis,
+ *  and every plane between two bins is priced by the surface
+ *  area heuristic - the area of each side times its object
+ *  count.  The cheapest plane is used only when it costs
+ *  less than keeping the node as a leaf.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::Subdivide(int nodeIndex, std::vector<glm::vec3>& centroids)
+{
+	const int first = m_nodes[nodeIndex].leftOrFirst;
+	const int count = m_nodes[nodeIndex].count;
+
+	if (count <= MIN_SPLIT_COUNT)
+	{
+		return(false);
+	}
+
+	// the bins are spread over the centroids, not the boxes
+	glm::vec3 centroidMin = centroids[m_objectIndices[first]];
+	glm::vec3 centroidMax = centroidMin;
+	for (int i = 1; i < count; i++)
+	{
+		const glm::vec3& centroid = centroids[m_objectIndices[first + i]];
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	struct SAH_BIN
+	{
+		glm::vec3 aabbMin;
+		glm::vec3 aabbMax;
+		int count;
+	};
+
+	float bestCost = HalfSurfaceArea(m_nodes[nodeIndex].aabbMin, m_nodes[nodeIndex].aabbMax) * count;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		SAH_BIN bins[SAH_BIN_COUNT];
+		for (SAH_BIN& bin : bins)
+		{
+			bin.aabbMin = glm::vec3(INFINITY);
+			bin.aabbMax = glm::vec3(-INFINITY);
+			bin.count = 0;
+		}
+
+		float scale = SAH_BIN_COUNT / extent;
+		for (int i = 0; i < count; i++)
+		{
+			int objectIndex = m_objectIndices[first + i];
+			int binIndex = std::min(SAH_BIN_COUNT - 1, (int)((centroids[objectIndex][axis] - centroidMin[axis]) * scale));
+			bins[binIndex].aabbMin = glm::min(bins[binIndex].aabbMin, m_objectBounds[objectIndex].aabbMin);
+			bins[binIndex].aabbMax = glm::max(bins[binIndex].aabbMax, m_objectBounds[objectIndex].aabbMax);
+			bins[binIndex].count++;
+		}
+
+		// sweep from both ends to get the area and count on
+		// each side of every plane between two bins
+		float leftCost[SAH_BIN_COUNT - 1];
+		glm::vec3 sweepMin(INFINITY);
+		glm::vec3 sweepMax(-INFINITY);
+		int sweepCount = 0;
+		for (int plane = 0; plane < SAH_BIN_COUNT - 1; plane++)
+		{
+			sweepMin = glm::min(sweepMin, bins[plane].aabbMin);
+			sweepMax = glm::max(sweepMax, bins[plane].aabbMax);
+			sweepCount += bins[plane].count;
+			leftCost[plane] = HalfSurfaceArea(sweepMin, sweepMax) * sweepCount;
+		}
+
+		sweepMin = glm::vec3(INFINITY);
+		sweepMax = glm::vec3(-INFINITY);
+		sweepCount = 0;
+		for (int plane = SAH_BIN_COUNT - 2; plane >= 0; plane--)
+		{
+			sweepMin = glm::min(sweepMin, bins[plane + 1].aabbMin);
+			sweepMax = glm::max(sweepMax, bins[plane + 1].aabbMax);
+			sweepCount += bins[plane + 1].count;
+
+			float cost = leftCost[plane] + HalfSurfaceArea(sweepMin, sweepMax) * sweepCount;
+			if ((sweepCount > 0) && (sweepCount < count) && (cost < bestCost))
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = plane;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		return(false);
+	}
+
+	// move the objects left of the plane to the front of the range
+	float scale = SAH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	int* begin = &m_objectIndices[first];
+	int* middle = std::partition(begin, begin + count,
+		[&](int objectIndex)
+		{
+			int binIndex = std::min(SAH_BIN_COUNT - 1, (int)((centroids[objectIndex][bestAxis] - centroidMin[bestAxis]) * scale));
+			return(binIndex <= bestSplit);
+		});
+	int leftCount = (int)(middle - begin);
+	if ((leftCount == 0) || (leftCount == count))
+	{
+		return(false);
+	}
+
+	int leftIndex = (int)m_nodes.size();
+
+	BVH_NODE left;
+	left.leftOrFirst = first;
+	left.count = leftCount;
+	BVH_NODE right;
+	right.leftOrFirst = first + leftCount;
+	right.count = count - leftCount;
+
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+	m_parents.push_back(nodeIndex);
+	m_parents.push_back(nodeIndex);
+	UpdateNodeBounds(leftIndex);
+	UpdateNodeBounds(leftIndex + 1);
+
+	m_nodes[nodeIndex].leftOrFirst = leftIndex;
+	m_nodes[nodeIndex].count = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  RefitObject()
+ *
+ *  This method is used for refitting the tree after one
+ *  object has moved.  The box of its leaf is rebuilt, then
+ *  the boxes of the nodes above it, stopping as soon as a
+ *  node's box does not change.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RefitObject(int objectIndex, const BOUNDING_VOLUME& bounds)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objectBounds.size()))
+	{
+		return;
+	}
+
+	m_objectBounds[objectIndex] = bounds;
+
+	int nodeIndex = m_objectLeaves[objectIndex];
+	while (nodeIndex >= 0)
+	{
+		glm::vec3 oldMin = m_nodes[nodeIndex].aabbMin;
+		glm::vec3 oldMax = m_nodes[nodeIndex].aabbMax;
+
+		UpdateNodeBounds(nodeIndex);
+		if ((m_nodes[nodeIndex].aabbMin == oldMin) && (m_nodes[nodeIndex].aabbMax == oldMax))
+		{
+			break;
+		}
+
+		nodeIndex = m_parents[nodeIndex];
+	}
+}
+
+/***********************************************************
+ *  RefitAll()
+ *
+ *  This method is used for refitting every node after many
+ *  objects have moved.  Children are always stored after
+ *  their parent, so one reverse sweep refits bottom up.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RefitAll(const std::vector<BOUNDING_VOLUME>& objectBounds)
+{
+	if (objectBounds.size() != m_objectBounds.size())
+	{
+		Build(objectBounds);
+		return;
+	}
+
+	m_objectBounds = objectBounds;
+	for (int nodeIndex = (int)m_nodes.size() - 1; nodeIndex >= 0; nodeIndex--)
+	{
+		UpdateNodeBounds(nodeIndex);
+	}
+}
+
+/***********************************************************
+ *  CollectObjects()
+ *
+ *  This method is used for adding every object below a node
+ *  to a list without testing any of them.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CollectObjects(int nodeIndex, std::vector<int>& objectIndices) const
+{
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = nodeIndex;
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (node.count > 0)
+		{
+			objectIndices.insert(
+				objectIndices.end(),
+				m_objectIndices.begin() + node.leftOrFirst,
+				m_objectIndices.begin() + node.leftOrFirst + node.count);
+		}
+		else
+		{
+			stack[stackSize++] = node.leftOrFirst + 1;
+			stack[stackSize++] = node.leftOrFirst;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the objects that may be
+ *  visible.  A subtree whose box is outside the frustum is
+ *  skipped, and a subtree whose box is fully inside it is
+ *  taken whole without testing anything below it.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<int>& objectIndices) const
+{
+	objectIndices.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		Frustum::TEST_RESULT result = frustum.TestBox(node.aabbMin, node.aabbMax);
+		if (result == Frustum::OUTSIDE)
+		{
+			continue;
+		}
+		if (result == Frustum::INSIDE)
+		{
+			CollectObjects(nodeIndex, objectIndices);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = 0; i < node.count; i++)
+			{
+				int objectIndex = m_objectIndices[node.leftOrFirst + i];
+				if (frustum.IsVisible(m_objectBounds[objectIndex]))
+				{
+					objectIndices.push_back(objectIndex);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.leftOrFirst + 1;
+			stack[stackSize++] = node.leftOrFirst;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for picking the nearest object whose
+ *  box is hit by a ray.  The nearer child is visited first,
+ *  and subtrees that start beyond the nearest hit so far are
+ *  skipped.
+ ***********************************************************/
+int BoundingVolumeHierarchy::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& hitDistance) const
+{
+	int hitObject = -1;
+	hitDistance = INFINITY;
+
+	if (m_nodes.empty())
+	{
+		return(hitObject);
+	}
+
+	// a zero direction component gives an infinite slab scale,
+	// so the slab test only passes when the origin is inside it
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	if (IntersectRayBox(origin, inverseDirection, m_nodes[0].aabbMin, m_nodes[0].aabbMax, hitDistance) >= 0.0f)
+	{
+		stack[stackSize++] = 0;
+	}
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+
+		if (node.count > 0)
+		{
+			for (int i = 0; i < node.count; i++)
+			{
+				int objectIndex = m_objectIndices[node.leftOrFirst + i];
+				const BOUNDING_VOLUME& bounds = m_objectBounds[objectIndex];
+				float distance = IntersectRayBox(origin, inverseDirection, bounds.aabbMin, bounds.aabbMax, hitDistance);
+				if ((distance >= 0.0f) && (distance < hitDistance))
+				{
+					hitDistance = distance;
+					hitObject = objectIndex;
+				}
+			}
+			continue;
+		}
+
+		int nearChild = node.leftOrFirst;
+		int farChild = node.leftOrFirst + 1;
+		float nearDistance = IntersectRayBox(origin, inverseDirection, m_nodes[nearChild].aabbMin, m_nodes[nearChild].aabbMax, hitDistance);
+		float farDistance = IntersectRayBox(origin, inverseDirection, m_nodes[farChild].aabbMin, m_nodes[farChild].aabbMax, hitDistance);
+		if ((farDistance >= 0.0f) && ((nearDistance < 0.0f) || (farDistance < nearDistance)))
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+
+		// push the far child first so the near one is popped first
+		if (farDistance >= 0.0f)
+		{
+			stack[stackSize++] = farChild;
+		}
+		if (nearDistance >= 0.0f)
+		{
+			stack[stackSize++] = nearChild;
+		}
+	}
+
+	return(hitObject);
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for finding the objects whose box is
+ *  within a radius of a point.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QuerySphere(
+	const glm::vec3& center,
+	float radius,
+	std::vector<int>& objectIndices) const
+{
+	objectIndices.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (IsBoxNearPoint(node.aabbMin, node.aabbMax, center, radius) == false)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = 0; i < node.count; i++)
+			{
+				int objectIndex = m_objectIndices[node.leftOrFirst + i];
+				const BOUNDING_VOLUME& bounds = m_objectBounds[objectIndex];
+				if (IsBoxNearPoint(bounds.aabbMin, bounds.aabbMax, center, radius))
+				{
+					objectIndices.push_back(objectIndex);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.leftOrFirst + 1;
+			stack[stackSize++] = node.leftOrFirst;
+		}
+	}
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the tree over randomly
+ *  placed unit boxes spread at a constant density.  It times
+ *  the build, a refit after every object moved, incremental
+ *  refits of one percent of the objects, and frustum, ray and
+ *  proximity queries, compared with a brute force frustum
+ *  test of every object.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RunBenchmark(int objectCount)
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BOUNDING_VOLUME> objectBounds(objectCount);
+	std::vector<int> results;
+
+	// keep roughly one object per 8 cubic units
+	float worldSize = 2.0f * cbrtf((float)objectCount);
+	srand(1);
+
+	for (BOUNDING_VOLUME& bounds : objectBounds)
+	{
+		glm::vec3 center(
+			worldSize * ((float)rand() / RAND_MAX - 0.5f),
+			worldSize * ((float)rand() / RAND_MAX - 0.5f),
+			worldSize * ((float)rand() / RAND_MAX - 0.5f));
+		bounds.aabbMin = center - glm::vec3(0.5f);
+		bounds.aabbMax = center + glm::vec3(0.5f);
+		bounds.sphereCenter = center;
+		bounds.sphereRadius = 0.87f;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bvh.Build(objectBounds);
+	double buildTime = ElapsedMilliseconds(start);
+
+	for (BOUNDING_VOLUME& bounds : objectBounds)
+	{
+		bounds.aabbMin.y += 0.25f;
+		bounds.aabbMax.y += 0.25f;
+		bounds.sphereCenter.y += 0.25f;
+	}
+	start = std::chrono::steady_clock::now();
+	bvh.RefitAll(objectBounds);
+	double refitAllTime = ElapsedMilliseconds(start);
+
+	int movedCount = std::max(1, objectCount / 100);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < movedCount; i++)
+	{
+		int objectIndex = rand() % objectCount;
+		BOUNDING_VOLUME bounds = objectBounds[objectIndex];
+		bounds.aabbMin.x += 0.25f;
+		bounds.aabbMax.x += 0.25f;
+		bounds.sphereCenter.x += 0.25f;
+		bvh.RefitObject(objectIndex, bounds);
+	}
+	double refitObjectsTime = ElapsedMilliseconds(start);
+
+	// a camera at the edge of the world looking at its center
+	glm::mat4 view = glm::lookAt(
+		glm::vec3(0.0f, 0.0f, worldSize * 0.5f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, worldSize * 0.5f);
+	Frustum frustum;
+	frustum.ExtractPlanes(projection * view);
+
+	start = std::chrono::steady_clock::now();
+	bvh.QueryFrustum(frustum, results);
+	double frustumTime = ElapsedMilliseconds(start);
+	size_t visibleCount = results.size();
+
+	start = std::chrono::steady_clock::now();
+	size_t bruteForceCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		if (frustum.IsVisible(bvh.m_objectBounds[i]))
+		{
+			bruteForceCount++;
+		}
+	}
+	double bruteForceTime = ElapsedMilliseconds(start);
+
+	const int rayCount = 1000;
+	int rayHits = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rayCount; i++)
+	{
+		glm::vec3 direction(
+			(float)rand() / RAND_MAX - 0.5f,
+			(float)rand() / RAND_MAX - 0.5f,
+			-1.0f);
+		float hitDistance = 0.0f;
+		if (bvh.QueryRay(glm::vec3(0.0f, 0.0f, worldSize * 0.5f), glm::normalize(direction), hitDistance) >= 0)
+		{
+			rayHits++;
+		}
+	}
+	double rayTime = ElapsedMilliseconds(start);
+
+	const int sphereCount = 1000;
+	size_t nearCount = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < sphereCount; i++)
+	{
+		bvh.QuerySphere(objectBounds[rand() % objectCount].sphereCenter, 2.0f, results);
+		nearCount += results.size();
+	}
+	double sphereTime = ElapsedMilliseconds(start);
+
+	std::cout << "INFO: BVH benchmark, " << objectCount << " objects, " << bvh.GetNodeCount() << " nodes" << std::endl;
+	std::cout << "INFO:   build " << buildTime << " ms, refit all " << refitAllTime << " ms, refit "
+		<< movedCount << " moved objects " << refitObjectsTime << " ms" << std::endl;
+	std::cout << "INFO:   frustum query " << frustumTime << " ms (" << visibleCount << " visible), brute force "
+		<< bruteForceTime << " ms (" << bruteForceCount << " visible)" << std::endl;
+	std::cout << "INFO:   " << rayCount << " ray queries " << rayTime << " ms (" << rayHits << " hits), "
+		<< sphereCount << " proximity queries " << sphereTime << " ms (" << nearCount << " found)" << std::endl;
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// bounding volume hierarchy over the scene objects for culling and queries
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolume.h"
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class builds a binary tree of axis-aligned boxes over
+ *  the bounding volumes of a list of objects, splitting each
+ *  node with the binned surface area heuristic.  When objects
+ *  move, the boxes of their leaves and of every node above
+ *  them are refit without rebuilding the tree.  Frustum,
+ *  ray and proximity queries skip whole subtrees whose box
+ *  can not contain a match.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+	// destructor
+	~BoundingVolumeHierarchy();
+
+	// build the tree over the bounding volumes of the objects,
+	// the index of a bounding volume is the object index
+	void Build(const std::vector<BOUNDING_VOLUME>& objectBounds);
+	// refit the tree after a single object has moved
+	void RefitObject(int objectIndex, const BOUNDING_VOLUME& bounds);
+	// refit the whole tree after many objects have moved
+	void RefitAll(const std::vector<BOUNDING_VOLUME>& objectBounds);
+
+	// find the objects that may be visible in the frustum
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& objectIndices) const;
+	// find the nearest object whose box is hit by the ray,
+	// -1 when nothing is hit
+	int QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& hitDistance) const;
+	// find the objects whose box is within radius of a point
+	void QuerySphere(
+		const glm::vec3& center,
+		float radius,
+		std::vector<int>& objectIndices) const;
+
+	// number of objects and nodes in the tree
+	int GetObjectCount() const { return((int)m_objectBounds.size()); }
+	int GetNodeCount() const { return((int)m_nodes.size()); }
+
+	// time building, refitting and querying trees over random
+	// objects and print the results
+	static void RunBenchmark(int objectCount);
+
+private:
+	// one node of the tree, a leaf when count is not zero
+	struct BVH_NODE
+	{
+		glm::vec3 aabbMin;
+		// first child for an inner node, the right child
+		// follows it - first object index for a leaf
+		int leftOrFirst;
+		glm::vec3 aabbMax;
+		// number of objects in a leaf, 0 for an inner node
+		int count;
+	};
+
+	// tree nodes, the root is the first node
+	std::vector<BVH_NODE> m_nodes;
+	// parent of every node, -1 for the root
+	std::vector<int> m_parents;
+	// object indices, grouped so each leaf owns a range
+	std::vector<int> m_objectIndices;
+	// bounding volume of every object
+	std::vector<BOUNDING_VOLUME> m_objectBounds;
+	// leaf that holds every object
+	std::vector<int> m_objectLeaves;
+
+	// set the box of a node around the objects or children
+	void UpdateNodeBounds(int nodeIndex);
+	// split a node when the split is cheaper than a leaf,
+	// returning true when children were added
+	bool Subdivide(int nodeIndex, std::vector<glm::vec3>& centroids);
+	// add every object below a node to the list
+	void CollectObjects(int nodeIndex, std::vector<int>& objectIndices) const;
+};
@@ -0,0 +1,839 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedtexturecache.cpp
+// ============
+// encode texture images into block compressed mipmap chains, kept in KTX2
+// files next to the source images
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CompressedTextureCache.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// first bytes of every KTX2 file
+	const unsigned char KTX2_IDENTIFIER[12] =
+		{ 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	// Vulkan format numbers KTX2 names the block formats by
+	const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+	// keys of the source image hash, size and modification
+	// time, and of the time the cache was written, in the
+	// key/value data
+	const char* const SOURCE_HASH_KEY = "sourceHash";
+	const char* const SOURCE_SIZE_KEY = "sourceSize";
+	const char* const SOURCE_TIME_KEY = "sourceModifiedTime";
+	const char* const WRITTEN_TIME_KEY = "cacheWrittenTime";
+	// longest key/value data read from a cache file
+	const uint32_t MAX_KEY_VALUE_BYTES = 4096;
+	// most mipmap levels, enough for a 32768 texel image
+	const uint32_t MAX_LEVELS = 16;
+
+	// KTX2 header and index, which are laid out without any
+	// padding by the natural alignment of their fields
+	struct KTX2_HEADER
+	{
+		unsigned char identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+
+	// KTX2 level index entry, one per mipmap level
+	struct KTX2_LEVEL
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	/***********************************************************
+	 *  FormatHash()
+	 *
+	 *  Write a hash as sixteen hexadecimal digits.
+	 ***********************************************************/
+	std::string FormatHash(uint64_t hash)
+	{
+		char text[17];
+		snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+		return(std::string(text));
+	}
+
+	/***********************************************************
+	 *  GetFullLevelCount()
+	 *
+	 *  Mipmap levels from the full size image down to a single
+	 *  texel, the same count the texture arrays are made with.
+	 ***********************************************************/
+	int GetFullLevelCount(int width, int height)
+	{
+		int levels = 1;
+		while (((width >> levels) > 0) || ((height >> levels) > 0))
+		{
+			levels++;
+		}
+		return(levels);
+	}
+
+	/***********************************************************
+	 *  PackColor565()
+	 *
+	 *  Round an 8-bit color to the 5:6:5 bits of a BC endpoint.
+	 ***********************************************************/
+	uint16_t PackColor565(int red, int green, int blue)
+	{
+		return((uint16_t)((((red * 31 + 127) / 255) << 11) | (((green * 63 + 127) / 255) << 5) | ((blue * 31 + 127) / 255)));
+	}
+
+	/***********************************************************
+	 *  UnpackColor565()
+	 *
+	 *  Expand a 5:6:5 endpoint back to 8 bits per channel.
+	 ***********************************************************/
+	void UnpackColor565(uint16_t color, int rgb[3])
+	{
+		int red = (color >> 11) & 31;
+		int green = (color >> 5) & 63;
+		int blue = color & 31;
+		rgb[0] = (red << 3) | (red >> 2);
+		rgb[1] = (green << 2) | (green >> 4);
+		rgb[2] = (blue << 3) | (blue >> 2);
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  Encode the colors of 4x4 RGBA texels into an 8 byte BC1
+	 *  block.  The endpoints are the corners of the box around
+	 *  the colors, pulled in a little so the two in-between
+	 *  colors of the palette fall closer to the texels, and
+	 *  kept in the order that selects the four color mode.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char texels[16][4], unsigned char* block)
+	{
+		int minColor[3] = { 255, 255, 255 };
+		int maxColor[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				minColor[c] = (texels[i][c] < minColor[c]) ? texels[i][c] : minColor[c];
+				maxColor[c] = (texels[i][c] > maxColor[c]) ? texels[i][c] : maxColor[c];
+			}
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			int inset = (maxColor[c] - minColor[c]) / 16;
+			minColor[c] += inset;
+			maxColor[c] -= inset;
+		}
+
+		uint16_t color0 = PackColor565(maxColor[0], maxColor[1], maxColor[2]);
+		uint16_t color1 = PackColor565(minColor[0], minColor[1], minColor[2]);
+		if (color0 < color1)
+		{
+			uint16_t swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			UnpackColor565(color0, palette[0]);
+			UnpackColor565(color1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 0x7FFFFFFF;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+					{
+						int delta = texels[i][c] - palette[p][c];
+						distance += delta * delta;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (2 * i);
+			}
+		}
+
+		block[0] = (unsigned char)(color0 & 0xFF);
+		block[1] = (unsigned char)(color0 >> 8);
+		block[2] = (unsigned char)(color1 & 0xFF);
+		block[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			block[4 + i] = (unsigned char)(indices >> (8 * i));
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  Encode the alpha of 4x4 RGBA texels into the 8 byte
+	 *  alpha half of a BC3 block, with the endpoints ordered to
+	 *  select the mode with six in-between values.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char texels[16][4], unsigned char* block)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = (texels[i][3] > alpha0) ? texels[i][3] : alpha0;
+			alpha1 = (texels[i][3] < alpha1) ? texels[i][3] : alpha1;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8];
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+			for (int p = 1; p < 7; p++)
+			{
+				palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					int distance = texels[i][3] - palette[p];
+					distance = (distance < 0) ? -distance : distance;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint64_t)bestIndex << (3 * i);
+			}
+		}
+
+		block[0] = (unsigned char)alpha0;
+		block[1] = (unsigned char)alpha1;
+		for (int i = 0; i < 6; i++)
+		{
+			block[2 + i] = (unsigned char)(indices >> (8 * i));
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeLevel()
+	 *
+	 *  Encode a whole RGBA image into BC1 or BC3 blocks, row of
+	 *  blocks by row of blocks.  Blocks hanging over the right
+	 *  or bottom edge repeat the edge texels.
+	 ***********************************************************/
+	void EncodeLevel(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		bool bAlpha,
+		std::vector<unsigned char>& blocks)
+	{
+		int blocksWide = (width + 3) / 4;
+		int blocksHigh = (height + 3) / 4;
+		size_t blockBytes = bAlpha ? 16 : 8;
+		blocks.resize(blocksWide * blocksHigh * blockBytes);
+
+		unsigned char* block = blocks.data();
+		unsigned char texels[16][4];
+		for (int blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				for (int i = 0; i < 16; i++)
+				{
+					int x = blockX * 4 + (i % 4);
+					int y = blockY * 4 + (i / 4);
+					x = (x < width) ? x : width - 1;
+					y = (y < height) ? y : height - 1;
+					memcpy(texels[i], pixels + ((size_t)y * width + x) * 4, 4);
+				}
+
+				if (bAlpha)
+				{
+					EncodeAlphaBlock(texels, block);
+					EncodeColorBlock(texels, block + 8);
+				}
+				else
+				{
+					EncodeColorBlock(texels, block);
+				}
+				block += blockBytes;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  AppendUint32()
+	 *
+	 *  Append a little-endian 32-bit value to a byte buffer.
+	 ***********************************************************/
+	void AppendUint32(std::vector<unsigned char>& bytes, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			bytes.push_back((unsigned char)(value >> (8 * i)));
+		}
+	}
+
+	/***********************************************************
+	 *  AppendKeyValue()
+	 *
+	 *  Append one key/value pair of text to the key/value data,
+	 *  padded to four bytes.
+	 ***********************************************************/
+	void AppendKeyValue(std::vector<unsigned char>& keyValues, const char* key, const std::string& value)
+	{
+		AppendUint32(keyValues, (uint32_t)(strlen(key) + 1 + value.size() + 1));
+		keyValues.insert(keyValues.end(), key, key + strlen(key) + 1);
+		keyValues.insert(keyValues.end(), value.c_str(), value.c_str() + value.size() + 1);
+		while ((keyValues.size() % 4) != 0)
+		{
+			keyValues.push_back(0);
+		}
+	}
+
+	/***********************************************************
+	 *  BuildDataFormatDescriptor()
+	 *
+	 *  Build the data format descriptor KTX2 requires, a basic
+	 *  descriptor block for linear BC1 or BC3 with one sample
+	 *  for the color blocks and, for BC3, one for the alpha.
+	 ***********************************************************/
+	void BuildDataFormatDescriptor(bool bAlpha, std::vector<unsigned char>& dfd)
+	{
+		const uint32_t KHR_DF_MODEL_BC1A = 128;
+		const uint32_t KHR_DF_MODEL_BC3 = 130;
+		const uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+		const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+		const uint32_t KHR_DF_CHANNEL_COLOR = 0;
+		const uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+
+		uint32_t sampleCount = bAlpha ? 2 : 1;
+		uint32_t blockSize = 24 + 16 * sampleCount;
+
+		dfd.clear();
+		AppendUint32(dfd, 4 + blockSize);
+		// vendor and descriptor type, version and block size
+		AppendUint32(dfd, 0);
+		AppendUint32(dfd, 2 | (blockSize << 16));
+		// color model, primaries, transfer function, flags
+		AppendUint32(dfd, (bAlpha ? KHR_DF_MODEL_BC3 : KHR_DF_MODEL_BC1A) | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+		// 4x4 texel blocks, less one in each dimension
+		AppendUint32(dfd, 3 | (3 << 8));
+		// bytes in each block
+		AppendUint32(dfd, bAlpha ? 16 : 8);
+		AppendUint32(dfd, 0);
+
+		for (uint32_t sample = 0; sample < sampleCount; sample++)
+		{
+			bool bAlphaSample = (bAlpha == true) && (sample == 0);
+			uint32_t bitOffset = ((bAlpha == true) && (sample == 1)) ? 64 : 0;
+			uint32_t channel = bAlphaSample ? KHR_DF_CHANNEL_ALPHA : KHR_DF_CHANNEL_COLOR;
+
+			// bit offset, bit length less one, channel
+			AppendUint32(dfd, bitOffset | (63 << 16) | (channel << 24));
+			AppendUint32(dfd, 0);
+			AppendUint32(dfd, 0);
+			AppendUint32(dfd, 0xFFFFFFFF);
+		}
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that the driver can
+ *  sample the BC1 and BC3 formats, which come from the S3TC
+ *  extension rather than the core profile.
+ ***********************************************************/
+bool CompressedTextureCache::IsSupported()
+{
+	return(GLEW_EXT_texture_compression_s3tc ? true : false);
+}
+
+/***********************************************************
+ *  FindCache()
+ *
+ *  This method is used for checking the cache file beside a
+ *  source image, named after the source with .ktx2 added.
+ *  The cache is only valid when it holds a full mipmap chain
+ *  in one of the formats written here and was encoded from
+ *  the same source contents.
+ *
+ *  The modification time only counts to the second, so an
+ *  edit in the same second the cache was encoded from would
+ *  keep its old time.  The size and time the cache recorded
+ *  are trusted when they match and the source was last
+ *  changed well before the cache was written, otherwise the
+ *  source is hashed and compared with the recorded hash.
+ ***********************************************************/
+bool CompressedTextureCache::FindCache(const char* sourceFile, CACHE_INFO& info)
+{
+	info.cacheFile = std::string(sourceFile) + ".ktx2";
+	info.sourceFile = sourceFile;
+	info.sourceSize = 0;
+	info.modifiedTime = 0;
+	info.bValid = false;
+	info.format = 0;
+	info.width = 0;
+	info.height = 0;
+	info.levels.clear();
+
+	if (GetFileStatus(sourceFile, info.sourceSize, info.modifiedTime) == false)
+	{
+		return(false);
+	}
+
+	std::ifstream cacheFile(info.cacheFile, std::ios::binary);
+	if (cacheFile.is_open() == false)
+	{
+		return(false);
+	}
+
+	KTX2_HEADER header;
+	cacheFile.read((char*)&header, sizeof(header));
+	if ((cacheFile.good() == false) ||
+		(memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) ||
+		((header.vkFormat != VK_FORMAT_BC1_RGB_UNORM_BLOCK) && (header.vkFormat != VK_FORMAT_BC3_UNORM_BLOCK)) ||
+		(header.pixelWidth == 0) || (header.pixelHeight == 0) ||
+		(header.pixelDepth != 0) || (header.layerCount != 0) || (header.faceCount != 1) ||
+		(header.supercompressionScheme != 0) ||
+		(header.levelCount != (uint32_t)GetFullLevelCount(header.pixelWidth, header.pixelHeight)) ||
+		(header.levelCount > MAX_LEVELS) ||
+		(header.kvdByteLength > MAX_KEY_VALUE_BYTES))
+	{
+		return(false);
+	}
+
+	KTX2_LEVEL levels[MAX_LEVELS];
+	cacheFile.read((char*)levels, sizeof(KTX2_LEVEL) * header.levelCount);
+
+	// find what was recorded of the source among the key/value
+	// pairs, whose key and value each end with a zero inside
+	// the length of the pair unless the file is damaged
+	std::vector<char> keyValues(header.kvdByteLength);
+	cacheFile.seekg(header.kvdByteOffset);
+	cacheFile.read(keyValues.data(), keyValues.size());
+	if (cacheFile.good() == false)
+	{
+		return(false);
+	}
+
+	std::string cachedHash;
+	std::string cachedSize;
+	std::string cachedTime;
+	std::string writtenTime;
+	size_t position = 0;
+	while (position + 4 <= keyValues.size())
+	{
+		uint32_t length = 0;
+		memcpy(&length, &keyValues[position], 4);
+		position += 4;
+		if (length > keyValues.size() - position)
+		{
+			break;
+		}
+
+		size_t keyLength = strnlen(&keyValues[position], length);
+		if (keyLength < length)
+		{
+			std::string key(&keyValues[position], keyLength);
+			size_t valueStart = position + keyLength + 1;
+			std::string value(&keyValues[valueStart], strnlen(&keyValues[valueStart], length - keyLength - 1));
+			if (key == SOURCE_HASH_KEY)
+			{
+				cachedHash = value;
+			}
+			else if (key == SOURCE_SIZE_KEY)
+			{
+				cachedSize = value;
+			}
+			else if (key == SOURCE_TIME_KEY)
+			{
+				cachedTime = value;
+			}
+			else if (key == WRITTEN_TIME_KEY)
+			{
+				writtenTime = value;
+			}
+		}
+		position += ((size_t)length + 3) & ~(size_t)3;
+	}
+
+	bool bTrustTime =
+		(cachedSize.empty() == false) && (cachedTime.empty() == false) && (writtenTime.empty() == false) &&
+		(strtoull(cachedSize.c_str(), NULL, 10) == info.sourceSize) &&
+		(strtoll(cachedTime.c_str(), NULL, 10) == info.modifiedTime) &&
+		(info.modifiedTime + 1 < strtoll(writtenTime.c_str(), NULL, 10));
+	if (bTrustTime == false)
+	{
+		uint64_t sourceHash = 0;
+		if ((HashFile(sourceFile, sourceHash) == false) || (cachedHash != FormatHash(sourceHash)))
+		{
+			std::cout << "INFO: compressed texture " << info.cacheFile << " is out of date" << std::endl;
+			return(false);
+		}
+	}
+
+	GLenum format = (header.vkFormat == VK_FORMAT_BC3_UNORM_BLOCK) ?
+		GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	for (uint32_t level = 0; level < header.levelCount; level++)
+	{
+		int levelWidth = (header.pixelWidth >> level) > 0 ? (header.pixelWidth >> level) : 1;
+		int levelHeight = (header.pixelHeight >> level) > 0 ? (header.pixelHeight >> level) : 1;
+		if (levels[level].byteLength != GetLevelBytes(format, levelWidth, levelHeight))
+		{
+			return(false);
+		}
+
+		CACHE_LEVEL cacheLevel;
+		cacheLevel.fileOffset = levels[level].byteOffset;
+		cacheLevel.bytes = (size_t)levels[level].byteLength;
+		info.levels.push_back(cacheLevel);
+	}
+
+	info.format = format;
+	info.width = (int)header.pixelWidth;
+	info.height = (int)header.pixelHeight;
+	info.bValid = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReadLevels()
+ *
+ *  This method is used for reading the blocks of every
+ *  mipmap level of a valid cache into one buffer, from the
+ *  full size image down, ready to upload.
+ ***********************************************************/
+unsigned char* CompressedTextureCache::ReadLevels(const CACHE_INFO& info)
+{
+	if (info.bValid == false)
+	{
+		return(NULL);
+	}
+
+	std::ifstream cacheFile(info.cacheFile, std::ios::binary);
+	if (cacheFile.is_open() == false)
+	{
+		return(NULL);
+	}
+
+	size_t totalBytes = 0;
+	for (const CACHE_LEVEL& level : info.levels)
+	{
+		totalBytes += level.bytes;
+	}
+
+	unsigned char* blocks = new unsigned char[totalBytes];
+	size_t position = 0;
+	for (const CACHE_LEVEL& level : info.levels)
+	{
+		cacheFile.seekg(level.fileOffset);
+		cacheFile.read((char*)blocks + position, level.bytes);
+		position += level.bytes;
+	}
+
+	if (cacheFile.good() == false)
+	{
+		std::cout << "WARNING: compressed texture " << info.cacheFile << " is truncated" << std::endl;
+		delete[] blocks;
+		return(NULL);
+	}
+
+	return(blocks);
+}
+
+/***********************************************************
+ *  EncodeLevels()
+ *
+ *  This method is used for encoding every mipmap level of an
+ *  RGBA chain, as made by DecodedTextureCache::BuildChain(),
+ *  into the blocks of each level from the full size down.
+ ***********************************************************/
+void CompressedTextureCache::EncodeLevels(
+	const unsigned char* chain,
+	int width,
+	int height,
+	bool bAlpha,
+	std::vector<std::vector<unsigned char>>& levelBlocks)
+{
+	int levelCount = GetFullLevelCount(width, height);
+	levelBlocks.assign(levelCount, std::vector<unsigned char>());
+
+	const unsigned char* image = chain;
+	for (int level = 0; level < levelCount; level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		EncodeLevel(image, levelWidth, levelHeight, bAlpha, levelBlocks[level]);
+		image += (size_t)levelWidth * levelHeight * 4;
+	}
+}
+
+/***********************************************************
+ *  WriteCache()
+ *
+ *  This method is used for encoding every mipmap level of an
+ *  RGBA chain and writing them to a KTX2 file, with the
+ *  hash, size and modification time of the source image and
+ *  the time of writing.  The hash is the one of the bytes
+ *  the chain was decoded from, so an edit made since then
+ *  cannot be stored with the old pixels.  As the format asks, the smallest
+ *  level is stored first.  The file is written under a
+ *  temporary name and then renamed, so a run that stops part
+ *  way through never leaves a cache file that looks complete.
+ ***********************************************************/
+bool CompressedTextureCache::WriteCache(
+	const CACHE_INFO& info,
+	const unsigned char* chain,
+	int width,
+	int height,
+	bool bAlpha,
+	uint64_t sourceHash)
+{
+	if ((NULL == chain) || (width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	std::vector<std::vector<unsigned char>> levelBlocks;
+	EncodeLevels(chain, width, height, bAlpha, levelBlocks);
+	int levelCount = (int)levelBlocks.size();
+
+	std::vector<unsigned char> dfd;
+	BuildDataFormatDescriptor(bAlpha, dfd);
+
+	// the pairs are sorted by key, as the format asks
+	std::vector<unsigned char> keyValues;
+	AppendKeyValue(keyValues, WRITTEN_TIME_KEY, std::to_string((long long)time(NULL)));
+	AppendKeyValue(keyValues, SOURCE_HASH_KEY, FormatHash(sourceHash));
+	AppendKeyValue(keyValues, SOURCE_TIME_KEY, std::to_string((long long)info.modifiedTime));
+	AppendKeyValue(keyValues, SOURCE_SIZE_KEY, std::to_string((unsigned long long)info.sourceSize));
+
+	KTX2_HEADER header = {};
+	memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.vkFormat = bAlpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	header.typeSize = 1;
+	header.pixelWidth = width;
+	header.pixelHeight = height;
+	header.faceCount = 1;
+	header.levelCount = levelCount;
+	header.dfdByteOffset = (uint32_t)(sizeof(KTX2_HEADER) + sizeof(KTX2_LEVEL) * levelCount);
+	header.dfdByteLength = (uint32_t)dfd.size();
+	header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+	header.kvdByteLength = (uint32_t)keyValues.size();
+
+	// lay out the levels smallest first, each aligned to the
+	// block size, which is a multiple of four
+	uint64_t alignment = bAlpha ? 16 : 8;
+	uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+	std::vector<KTX2_LEVEL> levels(levelCount);
+	for (int level = levelCount - 1; level >= 0; level--)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levels[level].byteOffset = offset;
+		levels[level].byteLength = levelBlocks[level].size();
+		levels[level].uncompressedByteLength = levelBlocks[level].size();
+		offset += levelBlocks[level].size();
+	}
+
+	std::string temporaryFile = info.cacheFile + ".tmp";
+	{
+		std::ofstream cacheFile(temporaryFile, std::ios::binary | std::ios::trunc);
+		if (cacheFile.is_open() == false)
+		{
+			std::cout << "WARNING: could not write the compressed texture " << info.cacheFile << std::endl;
+			return(false);
+		}
+
+		cacheFile.write((const char*)&header, sizeof(header));
+		cacheFile.write((const char*)levels.data(), sizeof(KTX2_LEVEL) * levelCount);
+		cacheFile.write((const char*)dfd.data(), dfd.size());
+		cacheFile.write((const char*)keyValues.data(), keyValues.size());
+		for (int level = levelCount - 1; level >= 0; level--)
+		{
+			while ((uint64_t)cacheFile.tellp() < levels[level].byteOffset)
+			{
+				cacheFile.put(0);
+			}
+			cacheFile.write((const char*)levelBlocks[level].data(), levelBlocks[level].size());
+		}
+
+		if (cacheFile.good() == false)
+		{
+			std::cout << "WARNING: could not write the compressed texture " << info.cacheFile << std::endl;
+			cacheFile.close();
+			std::remove(temporaryFile.c_str());
+			return(false);
+		}
+	}
+
+	// renaming over an existing file fails on Windows
+	std::remove(info.cacheFile.c_str());
+	if (std::rename(temporaryFile.c_str(), info.cacheFile.c_str()) != 0)
+	{
+		std::remove(temporaryFile.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetLevelBytes()
+ *
+ *  This method is used for getting the bytes of the 4x4
+ *  blocks covering a mipmap level, 8 per block for BC1 and
+ *  16 for BC3.
+ ***********************************************************/
+size_t CompressedTextureCache::GetLevelBytes(GLenum format, int width, int height)
+{
+	size_t blockBytes = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+	return((size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes);
+}
+
+/***********************************************************
+ *  HashFile()
+ *
+ *  This method is used for hashing the whole contents of a
+ *  file with 64-bit FNV-1a.
+ ***********************************************************/
+bool CompressedTextureCache::HashFile(const char* filename, uint64_t& hash)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (file.is_open() == false)
+	{
+		return(false);
+	}
+
+	hash = HASH_START;
+	char buffer[65536];
+	while (file)
+	{
+		file.read(buffer, sizeof(buffer));
+		hash = HashBytes((const unsigned char*)buffer, (size_t)file.gcount(), hash);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  HashBytes()
+ *
+ *  This method is used for hashing a block of bytes with
+ *  64-bit FNV-1a, carrying on from the hash of the bytes
+ *  before it, so a file hashed in one block or in many gets
+ *  the same hash.
+ ***********************************************************/
+uint64_t CompressedTextureCache::HashBytes(const unsigned char* data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  GetFileStatus()
+ *
+ *  This method is used for getting the size and modification
+ *  time of a file, without reading it.
+ ***********************************************************/
+bool CompressedTextureCache::GetFileStatus(const char* filename, uint64_t& size, int64_t& modifiedTime)
+{
+	struct stat fileStatus;
+	if (stat(filename, &fileStatus) != 0)
+	{
+		return(false);
+	}
+
+	size = (uint64_t)fileStatus.st_size;
+	modifiedTime = (int64_t)fileStatus.st_mtime;
+	return(true);
+}
+
+/***********************************************************
+ *  MakeSolidLevel()
+ *
+ *  This method is used for encoding one block of a solid
+ *  color and repeating it over a whole mipmap level.
+ ***********************************************************/
+void CompressedTextureCache::MakeSolidLevel(
+	GLenum format,
+	const unsigned char rgba[4],
+	int width,
+	int height,
+	std::vector<unsigned char>& blocks)
+{
+	unsigned char texels[16][4];
+	for (int i = 0; i < 16; i++)
+	{
+		memcpy(texels[i], rgba, 4);
+	}
+
+	bool bAlpha = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	unsigned char block[16];
+	if (bAlpha)
+	{
+		EncodeAlphaBlock(texels, block);
+		EncodeColorBlock(texels, block + 8);
+	}
+	else
+	{
+		EncodeColorBlock(texels, block);
+	}
+
+	size_t blockBytes = bAlpha ? 16 : 8;
+	size_t levelBytes = GetLevelBytes(format, width, height);
+	blocks.resize(levelBytes);
+	for (size_t offset = 0; offset < levelBytes; offset += blockBytes)
+	{
+		memcpy(&blocks[offset], block, blockBytes);
+	}
+}
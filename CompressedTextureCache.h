@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedtexturecache.h
+// ============
+// encode texture images into block compressed mipmap chains, kept in KTX2
+// files next to the source images
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CompressedTextureCache
+ *
+ *  This class converts decoded RGBA images into BC1 blocks,
+ *  or BC3 blocks when the image has an alpha channel, with
+ *  every mipmap level worked out ahead of time, and writes
+ *  them to a KTX2 file beside the source image.  The file
+ *  records the size, modification time and a hash of the
+ *  source file, so an edited image is noticed and encoded
+ *  again without hashing every image on every run.  The next
+ *  run can upload the blocks as they are without decoding
+ *  the image or generating its mipmaps.
+ *
+ *  Reading and writing touch no GL state, so both can run on
+ *  the texture decoding threads.
+ ***********************************************************/
+class CompressedTextureCache
+{
+public:
+	// one mipmap level in a cache file
+	struct CACHE_LEVEL
+	{
+		uint64_t fileOffset;
+		size_t bytes;
+	};
+
+	// what is known of the cache file of a source image
+	struct CACHE_INFO
+	{
+		std::string cacheFile;
+		std::string sourceFile;
+		// size and modification time of the source image file
+		uint64_t sourceSize;
+		int64_t modifiedTime;
+		// the cache file exists and was encoded from the
+		// source image as it is now
+		bool bValid;
+		// compressed GL format and size of the full image,
+		// set when the cache is valid
+		GLenum format;
+		int width;
+		int height;
+		// mipmap levels from the full size image down
+		std::vector<CACHE_LEVEL> levels;
+	};
+
+	// true when the GL driver can sample the block formats
+	static bool IsSupported();
+
+	// read the header of the cache file beside a source image,
+	// true when the cache can be used - the source is only
+	// hashed when its size and time cannot be trusted
+	static bool FindCache(const char* sourceFile, CACHE_INFO& info);
+	// read every mipmap level of a valid cache, one after the
+	// other from the full size image down, NULL on failure -
+	// free the blocks with delete[]
+	static unsigned char* ReadLevels(const CACHE_INFO& info);
+	// encode every mipmap level of an RGBA chain into the
+	// blocks of each level, from the full size image down
+	static void EncodeLevels(
+		const unsigned char* chain,
+		int width,
+		int height,
+		bool bAlpha,
+		std::vector<std::vector<unsigned char>>& levelBlocks);
+	// encode every mipmap level of an RGBA chain and write them
+	// to the cache file under the hash of the source bytes the
+	// chain was decoded from
+	static bool WriteCache(
+		const CACHE_INFO& info,
+		const unsigned char* chain,
+		int width,
+		int height,
+		bool bAlpha,
+		uint64_t sourceHash);
+
+	// hash of no bytes, which HashBytes() carries on from
+	static const uint64_t HASH_START = 14695981039346656037ull;
+	// hash the whole contents of a file
+	static bool HashFile(const char* filename, uint64_t& hash);
+	// hash a block of bytes the same way, carrying on from the
+	// hash of the bytes before it
+	static uint64_t HashBytes(const unsigned char* data, size_t size, uint64_t hash = HASH_START);
+	// size and modification time of a file
+	static bool GetFileStatus(const char* filename, uint64_t& size, int64_t& modifiedTime);
+
+	// bytes of the blocks covering one mipmap level
+	static size_t GetLevelBytes(GLenum format, int width, int height);
+	// blocks of one solid color covering a mipmap level, for
+	// the placeholder shown until the real blocks are read
+	static void MakeSolidLevel(
+		GLenum format,
+		const unsigned char rgba[4],
+		int width,
+		int height,
+		std::vector<unsigned char>& blocks);
+};
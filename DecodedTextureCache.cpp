@@ -0,0 +1,584 @@
+///////////////////////////////////////////////////////////////////////////////
+// decodedtexturecache.cpp
+// ============
+// keep the decoded texture images and their mipmaps in one memory mapped
+// file, so later runs upload them without decoding anything
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DecodedTextureCache.h"
+#include "CompressedTextureCache.h"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char CACHE_MAGIC[4] = { 'T', 'E', 'X', 'C' };
+	const int32_t CACHE_VERSION = 1;
+	// the pixels of each entry start on a cache line
+	const uint64_t DATA_ALIGNMENT = 64;
+
+	struct CACHE_HEADER
+	{
+		char magic[4];
+		int32_t version;
+		uint32_t entryCount;
+		// bytes of the source paths following the entries
+		uint32_t pathBytes;
+		// time the cache file was written, in seconds
+		int64_t writtenTime;
+	};
+
+	// fixed size record of one cached image
+	struct CACHE_RECORD
+	{
+		uint64_t sourceSize;
+		int64_t modifiedTime;
+		uint64_t contentHash;
+		uint64_t dataOffset;
+		uint64_t dataBytes;
+		// source path within the path bytes, without the
+		// terminating zero
+		uint32_t pathOffset;
+		uint32_t pathLength;
+		int32_t width;
+		int32_t height;
+	};
+}
+
+/***********************************************************
+ *  DecodedTextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DecodedTextureCache::DecodedTextureCache()
+{
+	m_pMapped = NULL;
+	m_mappedBytes = 0;
+#ifdef _WIN32
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+#else
+	m_fileDescriptor = -1;
+#endif
+}
+
+/***********************************************************
+ *  ~DecodedTextureCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DecodedTextureCache::~DecodedTextureCache()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole cache file
+ *  read-only and checking that its header and records fit
+ *  inside it.  The pages are only read from the disk as the
+ *  uploads touch them.
+ ***********************************************************/
+bool DecodedTextureCache::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+	LARGE_INTEGER fileSize;
+	if ((GetFileSizeEx(file, &fileSize) == FALSE) || (fileSize.QuadPart < (LONGLONG)sizeof(CACHE_HEADER)))
+	{
+		CloseHandle(file);
+		return(false);
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		return(false);
+	}
+	m_pMapped = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == m_pMapped)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return(false);
+	}
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_mappedBytes = (size_t)fileSize.QuadPart;
+#else
+	int fileDescriptor = open(filename, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return(false);
+	}
+	struct stat fileStatus;
+	if ((fstat(fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size < (off_t)sizeof(CACHE_HEADER)))
+	{
+		close(fileDescriptor);
+		return(false);
+	}
+	void* pView = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (pView == MAP_FAILED)
+	{
+		close(fileDescriptor);
+		return(false);
+	}
+	m_fileDescriptor = fileDescriptor;
+	m_pMapped = (const unsigned char*)pView;
+	m_mappedBytes = (size_t)fileStatus.st_size;
+#endif
+
+	const CACHE_HEADER* pHeader = (const CACHE_HEADER*)m_pMapped;
+	size_t tableBytes = sizeof(CACHE_HEADER) + sizeof(CACHE_RECORD) * (size_t)pHeader->entryCount + pHeader->pathBytes;
+	if ((memcmp(pHeader->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+		(pHeader->version != CACHE_VERSION) ||
+		(tableBytes > m_mappedBytes))
+	{
+		std::cout << "INFO: decoded texture cache " << filename << " is out of date" << std::endl;
+		Close();
+		return(false);
+	}
+
+	const CACHE_RECORD* pRecords = (const CACHE_RECORD*)(m_pMapped + sizeof(CACHE_HEADER));
+	for (uint32_t i = 0; i < pHeader->entryCount; i++)
+	{
+		const CACHE_RECORD& record = pRecords[i];
+		if ((record.width <= 0) || (record.height <= 0) ||
+			(record.dataBytes != GetChainBytes(record.width, record.height)) ||
+			(record.dataOffset + record.dataBytes > m_mappedBytes) ||
+			((uint64_t)record.pathOffset + record.pathLength > pHeader->pathBytes))
+		{
+			std::cout << "WARNING: decoded texture cache " << filename << " is damaged" << std::endl;
+			Close();
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the cache file.
+ ***********************************************************/
+void DecodedTextureCache::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pMapped)
+	{
+		UnmapViewOfFile(m_pMapped);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+		m_fileHandle = NULL;
+	}
+#else
+	if (NULL != m_pMapped)
+	{
+		munmap((void*)m_pMapped, m_mappedBytes);
+	}
+	if (m_fileDescriptor >= 0)
+	{
+		close(m_fileDescriptor);
+		m_fileDescriptor = -1;
+	}
+#endif
+	m_pMapped = NULL;
+	m_mappedBytes = 0;
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for finding the entry cached for a
+ *  source image path.  The modification time only counts to
+ *  the second, so an edit in the same second the source was
+ *  cached from would keep its old time.  The size and time
+ *  are trusted when they match and the source was last
+ *  changed well before the cache was written, otherwise the
+ *  source is hashed and the entry is only used when the
+ *  contents turn out to be the same.
+ ***********************************************************/
+bool DecodedTextureCache::Find(const char* sourceFile, CACHE_ENTRY& entry) const
+{
+	if (NULL == m_pMapped)
+	{
+		return(false);
+	}
+
+	const CACHE_HEADER* pHeader = (const CACHE_HEADER*)m_pMapped;
+	const CACHE_RECORD* pRecords = (const CACHE_RECORD*)(m_pMapped + sizeof(CACHE_HEADER));
+	const char* pPaths = (const char*)(pRecords + pHeader->entryCount);
+	size_t pathLength = strlen(sourceFile);
+
+	for (uint32_t i = 0; i < pHeader->entryCount; i++)
+	{
+		const CACHE_RECORD& record = pRecords[i];
+		if ((record.pathLength != pathLength) ||
+			(memcmp(pPaths + record.pathOffset, sourceFile, pathLength) != 0))
+		{
+			continue;
+		}
+
+		uint64_t sourceSize = 0;
+		int64_t modifiedTime = 0;
+		if (CompressedTextureCache::GetFileStatus(sourceFile, sourceSize, modifiedTime) == false)
+		{
+			return(false);
+		}
+
+		bool bTrustTime = (modifiedTime == record.modifiedTime) && (record.modifiedTime + 1 < pHeader->writtenTime);
+		if ((sourceSize != record.sourceSize) || (bTrustTime == false))
+		{
+			uint64_t contentHash = 0;
+			if ((sourceSize != record.sourceSize) ||
+				(CompressedTextureCache::HashFile(sourceFile, contentHash) == false) ||
+				(contentHash != record.contentHash))
+			{
+				std::cout << "INFO: decoded texture cache entry for " << sourceFile << " is out of date" << std::endl;
+				return(false);
+			}
+		}
+
+		entry.pixels = m_pMapped + record.dataOffset;
+		entry.sourceSize = sourceSize;
+		entry.modifiedTime = modifiedTime;
+		entry.contentHash = record.contentHash;
+		entry.width = record.width;
+		entry.height = record.height;
+		entry.levelBytes.clear();
+		int levelWidth = record.width;
+		int levelHeight = record.height;
+		while (true)
+		{
+			entry.levelBytes.push_back((size_t)levelWidth * levelHeight * 4);
+			if ((levelWidth == 1) && (levelHeight == 1))
+			{
+				break;
+			}
+			levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+			levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+		}
+
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing a new cache file with the
+ *  given images, recording the size, modification time and
+ *  content hash each source had when it was decoded.  The
+ *  source is not looked at again here, so an edit made after
+ *  the decode leaves a record that no longer matches rather
+ *  than old pixels under the new hash.  The file is written under
+ *  a temporary name and then renamed, so a run that stops
+ *  part way through never leaves a cache that looks whole.
+ ***********************************************************/
+bool DecodedTextureCache::Write(const char* filename, const std::vector<WRITE_ENTRY>& entries)
+{
+	CACHE_HEADER header = {};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.writtenTime = (int64_t)time(NULL);
+
+	std::vector<CACHE_RECORD> records;
+	std::vector<const WRITE_ENTRY*> recordEntries;
+	std::string paths;
+	for (const WRITE_ENTRY& writeEntry : entries)
+	{
+		if (writeEntry.pixels.size() != GetChainBytes(writeEntry.width, writeEntry.height))
+		{
+			continue;
+		}
+
+		CACHE_RECORD record = {};
+		record.sourceSize = writeEntry.sourceSize;
+		record.modifiedTime = writeEntry.modifiedTime;
+		record.contentHash = writeEntry.contentHash;
+		record.dataBytes = writeEntry.pixels.size();
+		record.pathOffset = (uint32_t)paths.size();
+		record.pathLength = (uint32_t)writeEntry.sourceFile.size();
+		record.width = writeEntry.width;
+		record.height = writeEntry.height;
+		paths += writeEntry.sourceFile;
+		records.push_back(record);
+		recordEntries.push_back(&writeEntry);
+	}
+	header.entryCount = (uint32_t)records.size();
+	header.pathBytes = (uint32_t)paths.size();
+
+	// lay out the pixels after the table, each on a cache line
+	uint64_t offset = sizeof(CACHE_HEADER) + sizeof(CACHE_RECORD) * records.size() + paths.size();
+	for (CACHE_RECORD& record : records)
+	{
+		offset = (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+		record.dataOffset = offset;
+		offset += record.dataBytes;
+	}
+
+	std::string temporaryFile = std::string(filename) + ".tmp";
+	{
+		std::ofstream cacheFile(temporaryFile, std::ios::binary | std::ios::trunc);
+		if (cacheFile.is_open() == false)
+		{
+			std::cout << "WARNING: could not write the decoded texture cache " << filename << std::endl;
+			return(false);
+		}
+
+		cacheFile.write((const char*)&header, sizeof(header));
+		cacheFile.write((const char*)records.data(), sizeof(CACHE_RECORD) * records.size());
+		cacheFile.write(paths.data(), paths.size());
+
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			while ((uint64_t)cacheFile.tellp() < records[i].dataOffset)
+			{
+				cacheFile.put(0);
+			}
+			cacheFile.write((const char*)recordEntries[i]->pixels.data(), recordEntries[i]->pixels.size());
+		}
+
+		if (cacheFile.good() == false)
+		{
+			std::cout << "WARNING: could not write the decoded texture cache " << filename << std::endl;
+			cacheFile.close();
+			std::remove(temporaryFile.c_str());
+			return(false);
+		}
+	}
+
+	// renaming over an existing file fails on Windows
+	std::remove(filename);
+	if (std::rename(temporaryFile.c_str(), filename) != 0)
+	{
+		std::remove(temporaryFile.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetChainBytes()
+ *
+ *  This method is used for getting the bytes of RGBA pixels
+ *  in every mipmap level of an image, down to one texel.
+ ***********************************************************/
+size_t DecodedTextureCache::GetChainBytes(int width, int height)
+{
+	size_t bytes = 0;
+	while (true)
+	{
+		bytes += (size_t)width * height * 4;
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+	return(bytes);
+}
+
+/***********************************************************
+ *  BuildChain()
+ *
+ *  This method is used for making every mipmap level of an
+ *  RGBA image from the level above it, by averaging each 2x2
+ *  square of texels and repeating the last row or column of
+ *  an odd sized level.  The levels follow the image in the
+ *  chain, and the bytes of each level are listed.
+ ***********************************************************/
+void DecodedTextureCache::BuildChain(unsigned char* chain, int width, int height, std::vector<size_t>& levelBytes)
+{
+	levelBytes.clear();
+	levelBytes.push_back((size_t)width * height * 4);
+
+	const unsigned char* source = chain;
+	while ((width > 1) || (height > 1))
+	{
+		int halvedWidth = (width > 1) ? width / 2 : 1;
+		int halvedHeight = (height > 1) ? height / 2 : 1;
+		unsigned char* halved = (unsigned char*)source + (size_t)width * height * 4;
+
+		for (int y = 0; y < halvedHeight; y++)
+		{
+			int y0 = (y * 2 < height) ? y * 2 : height - 1;
+			int y1 = (y * 2 + 1 < height) ? y * 2 + 1 : height - 1;
+			for (int x = 0; x < halvedWidth; x++)
+			{
+				int x0 = (x * 2 < width) ? x * 2 : width - 1;
+				int x1 = (x * 2 + 1 < width) ? x * 2 + 1 : width - 1;
+				for (int c = 0; c < 4; c++)
+				{
+					int sum =
+						source[((size_t)y0 * width + x0) * 4 + c] +
+						source[((size_t)y0 * width + x1) * 4 + c] +
+						source[((size_t)y1 * width + x0) * 4 + c] +
+						source[((size_t)y1 * width + x1) * 4 + c];
+					halved[((size_t)y * halvedWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		levelBytes.push_back((size_t)halvedWidth * halvedHeight * 4);
+		source = halved;
+		width = halvedWidth;
+		height = halvedHeight;
+	}
+}
+
+/***********************************************************
+ *  RunRoundTripCheck()
+ *
+ *  This method is used for checking the cache without any
+ *  OpenGL context.  A small source file and the mipmap chain
+ *  of an odd sized image are written to a cache, which is
+ *  then mapped and searched, and every level has to come
+ *  back as it was written.  The source is then written again
+ *  within the same second, once with the same contents and
+ *  once edited, and only the unchanged one may be found.
+ *  Last the cache is written again with the pixels of the
+ *  source from before the edit, which may not be found
+ *  either.
+ *  It returns false and prints what went wrong on failure.
+ ***********************************************************/
+bool DecodedTextureCache::RunRoundTripCheck()
+{
+	const char* const sourceFile = "texturecachecheck.src";
+	const char* const cacheFile = "texturecachecheck.cache";
+	const int width = 13;
+	const int height = 7;
+	bool bPassed = true;
+
+	{
+		std::ofstream source(sourceFile, std::ios::binary | std::ios::trunc);
+		source << "round trip source " << width << "x" << height;
+	}
+
+	WRITE_ENTRY writeEntry;
+	writeEntry.sourceFile = sourceFile;
+	CompressedTextureCache::GetFileStatus(sourceFile, writeEntry.sourceSize, writeEntry.modifiedTime);
+	CompressedTextureCache::HashFile(sourceFile, writeEntry.contentHash);
+	writeEntry.width = width;
+	writeEntry.height = height;
+	writeEntry.pixels.resize(GetChainBytes(width, height));
+	for (int i = 0; i < width * height * 4; i++)
+	{
+		writeEntry.pixels[i] = (unsigned char)(i * 37 + 11);
+	}
+	std::vector<size_t> levelBytes;
+	BuildChain(writeEntry.pixels.data(), width, height, levelBytes);
+
+	std::vector<WRITE_ENTRY> entries(1, writeEntry);
+	DecodedTextureCache cache;
+	CACHE_ENTRY entry;
+	if (Write(cacheFile, entries) == false)
+	{
+		std::cout << "ERROR: could not write the decoded texture cache check file" << std::endl;
+		bPassed = false;
+	}
+	else if ((cache.Open(cacheFile) == false) || (cache.Find(sourceFile, entry) == false))
+	{
+		std::cout << "ERROR: decoded texture cache lost the image it was written with" << std::endl;
+		bPassed = false;
+	}
+	else if ((entry.width != width) || (entry.height != height) || (entry.levelBytes != levelBytes) ||
+		(memcmp(entry.pixels, writeEntry.pixels.data(), writeEntry.pixels.size()) != 0))
+	{
+		std::cout << "ERROR: decoded texture cache changed the pixels of the image" << std::endl;
+		bPassed = false;
+	}
+
+	// written again in the same second the cache was, so the
+	// time cannot be trusted and the source has to be hashed
+	if (bPassed == true)
+	{
+		{
+			std::ofstream source(sourceFile, std::ios::binary | std::ios::trunc);
+			source << "round trip source " << width << "x" << height;
+		}
+		if (cache.Find(sourceFile, entry) == false)
+		{
+			std::cout << "ERROR: decoded texture cache dropped a source that was only written again" << std::endl;
+			bPassed = false;
+		}
+
+		{
+			std::ofstream source(sourceFile, std::ios::binary | std::ios::trunc);
+			source << "edited trip source " << width << "x" << height;
+		}
+		if (cache.Find(sourceFile, entry) == true)
+		{
+			std::cout << "ERROR: decoded texture cache kept a source edited in the same second" << std::endl;
+			bPassed = false;
+		}
+	}
+
+	cache.Close();
+
+	// the source is now edited after the pixels were decoded,
+	// so writing them again must not make them look current
+	if (bPassed == true)
+	{
+		if ((Write(cacheFile, entries) == false) || (cache.Open(cacheFile) == false))
+		{
+			std::cout << "ERROR: could not write the decoded texture cache check file again" << std::endl;
+			bPassed = false;
+		}
+		else if (cache.Find(sourceFile, entry) == true)
+		{
+			std::cout << "ERROR: decoded texture cache stored old pixels for a source edited before writing" << std::endl;
+			bPassed = false;
+		}
+		cache.Close();
+	}
+
+	std::remove(cacheFile);
+	std::remove(sourceFile);
+
+	if (bPassed == true)
+	{
+		std::cout << "INFO: decoded texture cache gave back all " << levelBytes.size()
+			<< " levels of a " << width << "x" << height << " image and rejected its edited source" << std::endl;
+	}
+
+	return(bPassed);
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// decodedtexturecache.h
+// ============
+// keep the decoded texture images and their mipmaps in one memory mapped
+// file, so later runs upload them without decoding anything
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  DecodedTextureCache
+ *
+ *  This class holds the RGBA pixels of every uncompressed
+ *  scene texture, with all of their mipmap levels, in one
+ *  cache file that is mapped into memory rather than read.
+ *  An image found in the cache is uploaded straight from
+ *  the mapping, so a warm start neither decodes the image
+ *  nor generates its mipmaps.
+ *
+ *  Each entry is keyed by the path of its source image and
+ *  remembers the size, modification time and content hash
+ *  of the source.  A matching size and time are trusted when
+ *  they cannot hide an edit, and otherwise the source is
+ *  hashed, so an edited image is always decoded again while
+ *  one that was only touched keeps its entry.
+ ***********************************************************/
+class DecodedTextureCache
+{
+public:
+	// constructor
+	DecodedTextureCache();
+	// destructor
+	~DecodedTextureCache();
+
+	// pixels of one cached image, inside the mapping
+	struct CACHE_ENTRY
+	{
+		// every mipmap level, one after the other from the
+		// full size image down
+		const unsigned char* pixels;
+		int width;
+		int height;
+		std::vector<size_t> levelBytes;
+		// the source as it was checked, to write the entry
+		// again with
+		uint64_t sourceSize;
+		int64_t modifiedTime;
+		uint64_t contentHash;
+	};
+
+	// one decoded image to write to a new cache file
+	struct WRITE_ENTRY
+	{
+		std::string sourceFile;
+		// size and modification time of the source, taken
+		// before it was read, and the hash of the bytes the
+		// pixels were decoded from
+		uint64_t sourceSize;
+		int64_t modifiedTime;
+		uint64_t contentHash;
+		int width;
+		int height;
+		// every mipmap level from the full size image down
+		std::vector<unsigned char> pixels;
+	};
+
+	// map a cache file into memory, false when it is missing
+	// or was not written by this version
+	bool Open(const char* filename);
+	// unmap the cache file, the pixels of any entry found in
+	// it can no longer be used
+	void Close();
+	bool IsOpen() const { return(NULL != m_pMapped); }
+
+	// find the entry of a source image, false when there is
+	// none or the source has changed since it was cached
+	bool Find(const char* sourceFile, CACHE_ENTRY& entry) const;
+
+	// write a new cache file holding the given images under
+	// the source status they were decoded with, the file has
+	// to be closed first if it is open
+	static bool Write(const char* filename, const std::vector<WRITE_ENTRY>& entries);
+
+	// bytes of RGBA pixels in every mipmap level of an image
+	static size_t GetChainBytes(int width, int height);
+	// fill in every mipmap level below an RGBA image, which is
+	// the first level of a chain of GetChainBytes() bytes
+	static void BuildChain(unsigned char* chain, int width, int height, std::vector<size_t>& levelBytes);
+
+	// check that an image written to a cache file is found in
+	// it again unchanged, and that an edited source is not
+	static bool RunRoundTripCheck();
+
+private:
+	// the mapped cache file
+	const unsigned char* m_pMapped;
+	size_t m_mappedBytes;
+	// handles the mapping is held by
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+};
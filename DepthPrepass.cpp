@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.cpp
+// ============
+// lay down the depth of the opaque draws before they are shaded
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthPrepass.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_ViewName = "view";
+	const char* g_ProjectionName = "projection";
+}
+
+/***********************************************************
+ *  DepthPrepass()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthPrepass::DepthPrepass()
+{
+	m_pDepthShader = NULL;
+	m_viewLocation = -1;
+	m_projectionLocation = -1;
+}
+
+/***********************************************************
+ *  ~DepthPrepass()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DepthPrepass::~DepthPrepass()
+{
+	if (NULL != m_pDepthShader)
+	{
+		delete m_pDepthShader;
+		m_pDepthShader = NULL;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the shaders that write
+ *  the depth of the opaque draws.
+ ***********************************************************/
+bool DepthPrepass::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (NULL == m_pDepthShader)
+	{
+		m_pDepthShader = new ShaderManager();
+		GLuint programID = m_pDepthShader->LoadShaders(vertexShaderFile, fragmentShaderFile);
+		if (programID == 0)
+		{
+			delete m_pDepthShader;
+			m_pDepthShader = NULL;
+			return(false);
+		}
+
+		// resolve the locations once instead of looking them up
+		// by name on every pre-pass
+		m_viewLocation = glGetUniformLocation(programID, g_ViewName);
+		m_projectionLocation = glGetUniformLocation(programID, g_ProjectionName);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the first commands of the
+ *  indirect buffer, which hold the opaque draws, into the
+ *  depth buffer only.  Commands compacted by the GPU culling
+ *  pass stop at the draw count it wrote for them.
+ ***********************************************************/
+void DepthPrepass::Draw(
+	SceneMeshes* pMeshes,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	int commandCount,
+	GLuint drawCountBuffer,
+	GLintptr drawCountOffset)
+{
+	if ((NULL == pMeshes) || (NULL == m_pDepthShader) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	m_pDepthShader->use();
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(m_projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	if (drawCountBuffer != 0)
+	{
+		pMeshes->DrawIndirectPositionsCount(drawCountBuffer, drawCountOffset, 0, commandCount);
+	}
+	else
+	{
+		pMeshes->DrawIndirectPositions(0, commandCount);
+	}
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+/***********************************************************
+ *  BeginEqualDepth()
+ *
+ *  This method is used for passing only the fragments that
+ *  land exactly on the depth laid down by the pre-pass.
+ ***********************************************************/
+void DepthPrepass::BeginEqualDepth()
+{
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+}
+
+/***********************************************************
+ *  EndEqualDepth()
+ *
+ *  This method is used for restoring the depth test and
+ *  depth writes used by the rest of the frame.
+ ***********************************************************/
+void DepthPrepass::EndEqualDepth()
+{
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+}
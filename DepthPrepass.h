@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.h
+// ============
+// lay down the depth of the opaque draws before they are shaded
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneMeshes.h"
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DepthPrepass
+ *
+ *  This class draws the opaque indirect commands once with
+ *  only the vertex positions and no color writes, filling the
+ *  depth buffer with the nearest opaque surface of every
+ *  pixel.  The lit pass that follows tests for an equal depth
+ *  with depth writes off, so the lighting of the fragment
+ *  shader runs at most once per pixel however much the opaque
+ *  objects overlap.
+ *
+ *  Both passes transform the positions with the same
+ *  invariant expression, so their depths match exactly.
+ ***********************************************************/
+class DepthPrepass
+{
+public:
+	// constructor
+	DepthPrepass();
+	// destructor
+	~DepthPrepass();
+
+	// load the depth-only shaders
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// write the depth of the first commands in the indirect
+	// buffer, only as many as the draw count at an offset in
+	// drawCountBuffer when one is given for commands written on
+	// the GPU, the caller has to make its own shader program
+	// current again afterwards
+	void Draw(
+		SceneMeshes* pMeshes,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		int commandCount,
+		GLuint drawCountBuffer = 0,
+		GLintptr drawCountOffset = 0);
+
+	// test the following draws against the depth written by
+	// the pre-pass, without writing depth of their own
+	static void BeginEqualDepth();
+	// go back to the usual depth test and depth writes
+	static void EndEqualDepth();
+
+private:
+	// shaders that only transform the positions
+	ShaderManager* m_pDepthShader;
+	GLint m_viewLocation;
+	GLint m_projectionLocation;
+};
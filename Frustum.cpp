@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// view frustum planes for culling bounding volumes
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class.  Until planes have been
+ *  extracted every bounding volume is treated as visible.
+ ***********************************************************/
+Frustum::Frustum()
+{
+	for (int i = 0; i < 6; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f);
+	}
+}
+
+/***********************************************************
+ *  ~Frustum()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Frustum::~Frustum()
+{
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for extracting the frustum planes in
+ *  world space from a view-projection matrix.  A point is in
+ *  the clip volume when -w <= x, y, z <= w, so each plane is
+ *  the fourth row of the matrix plus or minus one of the
+ *  other rows.  This holds for glm::perspective as well as
+ *  for glm::ortho.
+ ***********************************************************/
+void Frustum::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	// glm matrices are stored by column, so gather the rows
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];    // left
+	m_planes[1] = rows[3] - rows[0];    // right
+	m_planes[2] = rows[3] + rows[1];    // bottom
+	m_planes[3] = rows[3] - rows[1];    // top
+	m_planes[4] = rows[3] + rows[2];    // near
+	m_planes[5] = rows[3] - rows[2];    // far
+
+	// normalize so the plane distances are in world units
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsVisible()
+ *
+ *  This method is used for testing a bounding volume against
+ *  the frustum, rejecting with the cheap sphere test first
+ *  and then with the tighter box test.
+ ***********************************************************/
+bool Frustum::IsVisible(const BOUNDING_VOLUME& bounds) const
+{
+	if (IsSphereVisible(bounds.sphereCenter, bounds.sphereRadius) == false)
+	{
+		return(false);
+	}
+
+	return(TestBox(bounds.aabbMin, bounds.aabbMax) != OUTSIDE);
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for testing a bounding sphere, which
+ *  is outside when it is fully behind any one plane.
+ ***********************************************************/
+bool Frustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  TestBox()
+ *
+ *  This method is used for testing an axis-aligned box.  For
+ *  each plane only the corner farthest along the plane normal
+ *  and the corner farthest against it need to be checked.
+ ***********************************************************/
+Frustum::TEST_RESULT Frustum::TestBox(const glm::vec3& aabbMin, const glm::vec3& aabbMax) const
+{
+	TEST_RESULT result = INSIDE;
+
+	for (int i = 0; i < 6; i++)
+	{
+		glm::vec3 normal = glm::vec3(m_planes[i]);
+		glm::vec3 farCorner(
+			(normal.x >= 0.0f) ? aabbMax.x : aabbMin.x,
+			(normal.y >= 0.0f) ? aabbMax.y : aabbMin.y,
+			(normal.z >= 0.0f) ? aabbMax.z : aabbMin.z);
+		glm::vec3 nearCorner(
+			(normal.x >= 0.0f) ? aabbMin.x : aabbMax.x,
+			(normal.y >= 0.0f) ? aabbMin.y : aabbMax.y,
+			(normal.z >= 0.0f) ? aabbMin.z : aabbMax.z);
+
+		if (glm::dot(normal, farCorner) + m_planes[i].w < 0.0f)
+		{
+			return(OUTSIDE);
+		}
+		if (glm::dot(normal, nearCorner) + m_planes[i].w < 0.0f)
+		{
+			result = INTERSECTING;
+		}
+	}
+
+	return(result);
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// view frustum planes for culling bounding volumes
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolume.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class holds the six planes of a view frustum, taken
+ *  straight from a view-projection matrix so that the same
+ *  code works for perspective and orthographic projections,
+ *  and tests bounding volumes against them.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+	// destructor
+	~Frustum();
+
+	// where a bounding box lies relative to the frustum
+	enum TEST_RESULT
+	{
+		OUTSIDE = 0,
+		INTERSECTING,
+		INSIDE
+	};
+
+	// extract the planes from a view-projection matrix
+	void ExtractPlanes(const glm::mat4& viewProjection);
+
+	// true when any part of the bounding volume may be visible
+	bool IsVisible(const BOUNDING_VOLUME& bounds) const;
+	// test a bounding sphere against the planes
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+	// test an axis-aligned bounding box against the planes
+	TEST_RESULT TestBox(const glm::vec3& aabbMin, const glm::vec3& aabbMax) const;
+
+	// the six planes, for testing on the GPU
+	const glm::vec4* GetPlanes() const { return(m_planes); }
+
+private:
+	// left, right, bottom, top, near and far planes, with
+	// normals that point into the frustum
+	glm::vec4 m_planes[6];
+};
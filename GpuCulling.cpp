@@ -0,0 +1,1121 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.cpp
+// ============
+// cull the render list on the GPU against the view frustum and a
+// hierarchical depth pyramid, writing the indirect draws that survive
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuCulling.h"
+#include "Frustum.h"
+#include "ShaderProgram.h"
+#include "TextureUnits.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// shader storage bindings used by the compute shaders,
+	// above the ones the scene shaders keep bound
+	const GLuint CULL_OBJECT_BINDING = 3;
+	const GLuint SOURCE_INSTANCE_BINDING = 4;
+	const GLuint INSTANCE_BINDING = 5;
+	const GLuint WORKING_COMMAND_BINDING = 6;
+	const GLuint COMMAND_BINDING = 7;
+	const GLuint DRAW_DATA_BINDING = 8;
+	const GLuint COMPACT_DRAW_DATA_BINDING = 9;
+	const GLuint DRAW_COUNT_BINDING = 10;
+	const GLuint CULL_COUNT_BINDING = 11;
+
+	// image units for the pyramid levels being reduced
+	const GLuint SOURCE_LEVEL_IMAGE = 0;
+	const GLuint TARGET_LEVEL_IMAGE = 1;
+
+	// work group sizes declared by the compute shaders
+	const GLuint CULL_GROUP_SIZE = 64;
+	const GLuint PYRAMID_GROUP_SIZE = 8;
+
+	// each per-draw value is copied as one uvec4
+	const GLsizeiptr DRAW_DATA_SIZE = 4 * sizeof(GLuint);
+}
+
+/***********************************************************
+ *  GpuCulling()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuCulling::GpuCulling()
+{
+	m_cullProgram = 0;
+	m_compactProgram = 0;
+	m_depthPyramidProgram = 0;
+	m_objectCountLocation = -1;
+	m_instanceWordsLocation = -1;
+	m_frustumPlanesLocation = -1;
+	m_previousViewProjectionLocation = -1;
+	m_bDepthPyramidValidLocation = -1;
+	m_depthPyramidLevelsLocation = -1;
+	m_commandCountLocation = -1;
+	m_opaqueCommandCountLocation = -1;
+	m_bCompactLocation = -1;
+	m_bFromDepthLocation = -1;
+	m_targetSizeLocation = -1;
+	m_sourceInstanceBuffer = 0;
+	m_objectBuffer = 0;
+	m_commandTemplateBuffer = 0;
+	m_workingCommandBuffer = 0;
+	m_compactDrawDataBuffer = 0;
+	m_drawCountBuffer = 0;
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_opaqueCommandCount = 0;
+	m_bIndirectCount = false;
+	m_depthTexture = 0;
+	m_depthPyramid = 0;
+	m_depthWidth = 0;
+	m_depthHeight = 0;
+	m_depthPyramidLevels = 0;
+	m_bDepthPyramidValid = false;
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_cullCountBuffer = 0;
+	m_countReadbackBuffer = 0;
+	m_pCountReadback = NULL;
+	for (int i = 0; i < COUNT_READBACK_SLOTS; i++)
+	{
+		m_countFences[i] = 0;
+	}
+	m_nextCountSlot = 0;
+	m_visibleCount = 0;
+	m_occludedCount = 0;
+}
+
+/***********************************************************
+ *  ~GpuCulling()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuCulling::~GpuCulling()
+{
+	GLuint programs[] = { m_cullProgram, m_compactProgram, m_depthPyramidProgram };
+	for (GLuint program : programs)
+	{
+		if (program != 0)
+		{
+			glDeleteProgram(program);
+		}
+	}
+	m_cullProgram = 0;
+	m_compactProgram = 0;
+	m_depthPyramidProgram = 0;
+
+	GLuint buffers[] =
+	{
+		m_sourceInstanceBuffer,
+		m_objectBuffer,
+		m_commandTemplateBuffer,
+		m_workingCommandBuffer,
+		m_compactDrawDataBuffer,
+		m_drawCountBuffer
+	};
+	for (GLuint buffer : buffers)
+	{
+		if (buffer != 0)
+		{
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+	m_sourceInstanceBuffer = 0;
+	m_objectBuffer = 0;
+	m_commandTemplateBuffer = 0;
+	m_workingCommandBuffer = 0;
+	m_compactDrawDataBuffer = 0;
+	m_drawCountBuffer = 0;
+
+	for (int i = 0; i < COUNT_READBACK_SLOTS; i++)
+	{
+		if (m_countFences[i] != 0)
+		{
+			glDeleteSync(m_countFences[i]);
+			m_countFences[i] = 0;
+		}
+	}
+	if (m_countReadbackBuffer != 0)
+	{
+		glUnmapNamedBuffer(m_countReadbackBuffer);
+		glDeleteBuffers(1, &m_countReadbackBuffer);
+		m_countReadbackBuffer = 0;
+	}
+	m_pCountReadback = NULL;
+	if (m_cullCountBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_cullCountBuffer);
+		m_cullCountBuffer = 0;
+	}
+
+	CreateDepthPyramid(0, 0);
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that the driver can run
+ *  the compute shaders, which are written for GLSL 4.50 and
+ *  set up with the OpenGL 4.5 named buffer and texture
+ *  calls.  Mesa's llvmpipe software renderer is a 4.5
+ *  driver, so the path can be checked without a GPU.
+ ***********************************************************/
+bool GpuCulling::IsSupported()
+{
+	return(GLEW_VERSION_4_5 ? true : false);
+}
+
+/***********************************************************
+ *  RunCullCheck()
+ *
+ *  This method is used for culling two layers of boxes, a
+ *  near layer and a far one, seen through a 256 pixel
+ *  viewport with a wall cleared into the middle of the depth
+ *  buffer between the layers.  The instances and commands
+ *  written by the compute shaders are read back and checked
+ *  against the frustum test run on the CPU, the far boxes
+ *  well inside the wall have to be occluded and the boxes
+ *  nowhere near it drawn, and the compacted commands have to
+ *  match the commands that drew anything, in order, in their
+ *  opaque and translucent ranges.  The same cull is then run
+ *  the way drivers without indirect count draws get it, and
+ *  the boxes drawn by both ways have to make the same image
+ *  as every box drawn without culling.  It returns false and
+ *  prints the first few differences when the results are
+ *  wrong.
+ ***********************************************************/
+bool GpuCulling::RunCullCheck()
+{
+	const int VIEWPORT_SIZE = 256;
+	const int WALL_MIN = 64;
+	const int WALL_MAX = 192;
+	// pyramid texels the far boxes can be tested against
+	const int WALL_MARGIN = 16;
+	const int GRID_SIZE = 40;
+	const float LAYER_DEPTHS[2] = { 5.0f, 30.0f };
+	const float WALL_DEPTH = 10.0f;
+	const int COMMAND_COUNT = 8;
+	const int OPAQUE_COMMAND_COUNT = 6;
+
+	GpuCulling culling;
+	if (culling.Initialize(
+		"shaders/cullComputeShader.glsl",
+		"shaders/compactComputeShader.glsl",
+		"shaders/depthPyramidComputeShader.glsl") == false)
+	{
+		std::cout << "ERROR: GPU culling check could not load the compute shaders" << std::endl;
+		return(false);
+	}
+
+	// the camera sits at the origin looking down -Z
+	glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	Frustum frustum;
+	frustum.ExtractPlanes(viewProjection);
+	const glm::vec4* planes = frustum.GetPlanes();
+
+	// the boxes are spread over the commands in turn, and each
+	// box keeps its own index in its material index
+	std::vector<SceneMeshes::INSTANCE_DATA> instances;
+	std::vector<CULL_OBJECT> objects;
+	std::vector<int> objectCommands;
+	for (int command = 0; command < COMMAND_COUNT; command++)
+	{
+		for (int layer = 0; layer < 2; layer++)
+		{
+			for (int i = command; i < GRID_SIZE * GRID_SIZE; i += COMMAND_COUNT)
+			{
+				glm::vec3 center(
+					(float)(i % GRID_SIZE - GRID_SIZE / 2),
+					(float)(i / GRID_SIZE - GRID_SIZE / 2),
+					-LAYER_DEPTHS[layer]);
+
+				SceneMeshes::INSTANCE_DATA instance;
+				instance.modelMatrix = glm::mat4(1.0f);
+				instance.modelMatrix[3] = glm::vec4(center, 1.0f);
+				instance.color = glm::vec4(1.0f);
+				instance.materialIndex = (GLint)instances.size();
+				instances.push_back(instance);
+
+				CULL_OBJECT object;
+				object.aabbMin = center - glm::vec3(0.4f);
+				object.commandIndex = (GLuint)command;
+				object.aabbMax = center + glm::vec3(0.4f);
+				object.padding = 0;
+				objects.push_back(object);
+				objectCommands.push_back(command);
+			}
+		}
+	}
+
+	std::vector<SceneMeshes::DRAW_COMMAND> commands(COMMAND_COUNT);
+	std::vector<GLuint> drawData(4 * COMMAND_COUNT, 0);
+	GLuint firstInstance = 0;
+	for (int command = 0; command < COMMAND_COUNT; command++)
+	{
+		commands[command].count = 36;
+		commands[command].instanceCount = 0;
+		commands[command].firstIndex = 0;
+		commands[command].baseVertex = 0;
+		commands[command].baseInstance = firstInstance;
+		for (int objectCommand : objectCommands)
+		{
+			commands[command].instanceCount += (objectCommand == command) ? 1 : 0;
+		}
+		firstInstance += commands[command].instanceCount;
+		drawData[4 * command] = 100 + command;
+	}
+
+	// work out on the CPU which boxes are in the frustum, which
+	// have to be hidden by the wall and which cannot be
+	glm::vec4 wallClip = viewProjection * glm::vec4(0.0f, 0.0f, -WALL_DEPTH, 1.0f);
+	float wallDepth = (wallClip.z / wallClip.w) * 0.5f + 0.5f;
+	int objectCount = (int)objects.size();
+	std::vector<bool> inFrustum(objectCount, true);
+	std::vector<bool> mustHide(objectCount, false);
+	std::vector<bool> mustDraw(objectCount, false);
+	int frustumCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		const CULL_OBJECT& object = objects[i];
+		for (int plane = 0; plane < 6; plane++)
+		{
+			glm::vec3 farCorner(
+				(planes[plane].x >= 0.0f) ? object.aabbMax.x : object.aabbMin.x,
+				(planes[plane].y >= 0.0f) ? object.aabbMax.y : object.aabbMin.y,
+				(planes[plane].z >= 0.0f) ? object.aabbMax.z : object.aabbMin.z);
+			if (glm::dot(glm::vec3(planes[plane]), farCorner) + planes[plane].w < 0.0f)
+			{
+				inFrustum[i] = false;
+			}
+		}
+		if (inFrustum[i] == false)
+		{
+			continue;
+		}
+		frustumCount++;
+
+		glm::vec2 pixelMin((float)VIEWPORT_SIZE);
+		glm::vec2 pixelMax(0.0f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec4 clipPosition = viewProjection * glm::vec4(
+				((corner & 1) != 0) ? object.aabbMax.x : object.aabbMin.x,
+				((corner & 2) != 0) ? object.aabbMax.y : object.aabbMin.y,
+				((corner & 4) != 0) ? object.aabbMax.z : object.aabbMin.z,
+				1.0f);
+			for (int axis = 0; axis < 2; axis++)
+			{
+				float pixel = (clipPosition[axis] / clipPosition.w * 0.5f + 0.5f) * (float)VIEWPORT_SIZE;
+				pixelMin[axis] = glm::min(pixelMin[axis], pixel);
+				pixelMax[axis] = glm::max(pixelMax[axis], pixel);
+			}
+		}
+
+		bool bFar = (object.aabbMax.z < -WALL_DEPTH);
+		bool bInsideWall = true;
+		bool bClearOfWall = false;
+		for (int axis = 0; axis < 2; axis++)
+		{
+			bInsideWall = bInsideWall &&
+				(pixelMin[axis] >= (float)(WALL_MIN + WALL_MARGIN)) &&
+				(pixelMax[axis] <= (float)(WALL_MAX - WALL_MARGIN));
+			bClearOfWall = bClearOfWall ||
+				(pixelMax[axis] < (float)WALL_MIN) || (pixelMin[axis] > (float)WALL_MAX);
+		}
+		mustHide[i] = bFar && bInsideWall;
+		mustDraw[i] = (bFar == false) || bClearOfWall;
+	}
+
+	// the wall is drawn by clearing part of the depth buffer
+	GLuint depthTexture = 0;
+	GLuint framebuffer = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+	glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT24, VIEWPORT_SIZE, VIEWPORT_SIZE);
+	glCreateFramebuffers(1, &framebuffer);
+	glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+	glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+	glNamedFramebufferReadBuffer(framebuffer, GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, VIEWPORT_SIZE, VIEWPORT_SIZE);
+	glClearDepth(1.0);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(WALL_MIN, WALL_MIN, WALL_MAX - WALL_MIN, WALL_MAX - WALL_MIN);
+	glClearDepth(wallDepth);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearDepth(1.0);
+	culling.BuildDepthPyramid(viewProjection);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	GLuint instanceBuffer = 0;
+	GLuint commandBuffer = 0;
+	GLuint drawDataBuffer = 0;
+	glCreateBuffers(1, &instanceBuffer);
+	glNamedBufferData(instanceBuffer, sizeof(SceneMeshes::INSTANCE_DATA) * instances.size(), NULL, GL_DYNAMIC_COPY);
+	glCreateBuffers(1, &commandBuffer);
+	glNamedBufferData(commandBuffer, sizeof(SceneMeshes::DRAW_COMMAND) * commands.size(), NULL, GL_DYNAMIC_COPY);
+	glCreateBuffers(1, &drawDataBuffer);
+	glNamedBufferData(drawDataBuffer, sizeof(GLuint) * drawData.size(), drawData.data(), GL_STATIC_DRAW);
+
+	culling.SetObjects(instances, objects, commands, OPAQUE_COMMAND_COUNT);
+
+	// the counts of a cull are read by the one after it, once
+	// the first has finished
+	culling.Cull(planes, instanceBuffer, commandBuffer, drawDataBuffer);
+	glFinish();
+	culling.Cull(planes, instanceBuffer, commandBuffer, drawDataBuffer);
+	glFinish();
+
+	std::vector<SceneMeshes::INSTANCE_DATA> culledInstances(instances.size());
+	std::vector<SceneMeshes::DRAW_COMMAND> workingCommands(COMMAND_COUNT);
+	std::vector<SceneMeshes::DRAW_COMMAND> compactCommands(COMMAND_COUNT);
+	std::vector<GLuint> compactDrawData(4 * COMMAND_COUNT);
+	GLuint drawCounts[2] = { 0, 0 };
+	glGetNamedBufferSubData(instanceBuffer, 0, sizeof(SceneMeshes::INSTANCE_DATA) * culledInstances.size(), culledInstances.data());
+	glGetNamedBufferSubData(culling.m_workingCommandBuffer, 0, sizeof(SceneMeshes::DRAW_COMMAND) * COMMAND_COUNT, workingCommands.data());
+	glGetNamedBufferSubData(commandBuffer, 0, sizeof(SceneMeshes::DRAW_COMMAND) * COMMAND_COUNT, compactCommands.data());
+	glGetNamedBufferSubData(culling.m_compactDrawDataBuffer, 0, sizeof(GLuint) * compactDrawData.size(), compactDrawData.data());
+	glGetNamedBufferSubData(culling.m_drawCountBuffer, 0, sizeof(drawCounts), drawCounts);
+
+	int errors = 0;
+	const int MAX_ERRORS = 10;
+
+	// every box drawn has to be in the frustum, drawn by its
+	// own command and drawn once
+	std::vector<bool> drawn(objectCount, false);
+	int drawnCount = 0;
+	for (int command = 0; command < COMMAND_COUNT; command++)
+	{
+		for (GLuint k = 0; k < workingCommands[command].instanceCount; k++)
+		{
+			int i = culledInstances[commands[command].baseInstance + k].materialIndex;
+			bool bValid = (i >= 0) && (i < objectCount) &&
+				(objectCommands[i] == command) && (drawn[i] == false) && inFrustum[i];
+			if ((bValid == false) || (mustHide[i] == true))
+			{
+				if (errors++ < MAX_ERRORS)
+				{
+					std::cout << "ERROR: GPU culling drew box " << i << " with command " << command << std::endl;
+				}
+				continue;
+			}
+			drawn[i] = true;
+			drawnCount++;
+		}
+	}
+	for (int i = 0; i < objectCount; i++)
+	{
+		if ((mustDraw[i] == true) && (drawn[i] == false) && (errors++ < MAX_ERRORS))
+		{
+			std::cout << "ERROR: GPU culling dropped box " << i << std::endl;
+		}
+	}
+
+	int hiddenCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		hiddenCount += mustHide[i] ? 1 : 0;
+	}
+	if ((culling.GetVisibleCount() != drawnCount) ||
+		(culling.GetVisibleCount() + culling.GetOccludedCount() != frustumCount) ||
+		(culling.GetOccludedCount() < hiddenCount) || (hiddenCount == 0))
+	{
+		std::cout << "ERROR: GPU culling counted " << culling.GetVisibleCount() << " visible and "
+			<< culling.GetOccludedCount() << " occluded boxes, expected " << drawnCount << " visible, "
+			<< frustumCount << " in the frustum and at least " << hiddenCount << " occluded" << std::endl;
+		errors++;
+	}
+
+	// the commands that drew anything are packed in order into
+	// the opaque and the translucent ranges
+	for (int range = 0; range < 2; range++)
+	{
+		int rangeStart = (range == 0) ? 0 : OPAQUE_COMMAND_COUNT;
+		int rangeEnd = (range == 0) ? OPAQUE_COMMAND_COUNT : COMMAND_COUNT;
+		int slot = rangeStart;
+		for (int command = rangeStart; command < rangeEnd; command++)
+		{
+			if (workingCommands[command].instanceCount == 0)
+			{
+				continue;
+			}
+			if ((compactCommands[slot].instanceCount != workingCommands[command].instanceCount) ||
+				(compactCommands[slot].baseInstance != commands[command].baseInstance) ||
+				(compactDrawData[4 * slot] != drawData[4 * command]))
+			{
+				if (errors++ < MAX_ERRORS)
+				{
+					std::cout << "ERROR: GPU culling compacted command " << command << " wrongly into slot " << slot << std::endl;
+				}
+			}
+			slot++;
+		}
+		if ((int)drawCounts[range] != slot - rangeStart)
+		{
+			std::cout << "ERROR: GPU culling wrote a draw count of " << drawCounts[range]
+				<< " for range " << range << ", expected " << (slot - rangeStart) << std::endl;
+			errors++;
+		}
+	}
+
+	int visibleCount = culling.GetVisibleCount();
+	int occludedCount = culling.GetOccludedCount();
+
+	// the boxes are drawn over the wall once with every command
+	// as it was set, once with the compacted commands and their
+	// draw counts, and once with the commands kept in place the
+	// way drivers without indirect count draws get them.  The
+	// cull only drops boxes the wall hides, so all three images
+	// have to be the same.
+	const glm::vec3 BOX_CORNERS[8] = {
+		glm::vec3(-0.4f, -0.4f, -0.4f), glm::vec3(0.4f, -0.4f, -0.4f),
+		glm::vec3(-0.4f, 0.4f, -0.4f), glm::vec3(0.4f, 0.4f, -0.4f),
+		glm::vec3(-0.4f, -0.4f, 0.4f), glm::vec3(0.4f, -0.4f, 0.4f),
+		glm::vec3(-0.4f, 0.4f, 0.4f), glm::vec3(0.4f, 0.4f, 0.4f) };
+	const GLuint BOX_INDICES[36] = {
+		0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+		0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+		0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5 };
+
+	GLuint shaders[2];
+	const char* vertexShaderFile = "shaders/cullCheckVertexShader.glsl";
+	const char* fragmentShaderFile = "shaders/cullCheckFragmentShader.glsl";
+	shaders[0] = CompileShaderFiles(GL_VERTEX_SHADER, &vertexShaderFile, 1);
+	shaders[1] = CompileShaderFiles(GL_FRAGMENT_SHADER, &fragmentShaderFile, 1);
+	GLuint drawProgram = LinkShaderProgram(shaders, 2);
+	if (drawProgram == 0)
+	{
+		std::cout << "ERROR: GPU culling check could not load the box shaders" << std::endl;
+		errors++;
+	}
+
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLuint sourceInstanceBuffer = 0;
+	GLuint sourceCommandBuffer = 0;
+	GLuint vao = 0;
+	glCreateBuffers(1, &vertexBuffer);
+	glNamedBufferData(vertexBuffer, sizeof(BOX_CORNERS), BOX_CORNERS, GL_STATIC_DRAW);
+	glCreateBuffers(1, &indexBuffer);
+	glNamedBufferData(indexBuffer, sizeof(BOX_INDICES), BOX_INDICES, GL_STATIC_DRAW);
+	glCreateBuffers(1, &sourceInstanceBuffer);
+	glNamedBufferData(sourceInstanceBuffer, sizeof(SceneMeshes::INSTANCE_DATA) * instances.size(), instances.data(), GL_STATIC_DRAW);
+	glCreateBuffers(1, &sourceCommandBuffer);
+	glNamedBufferData(sourceCommandBuffer, sizeof(SceneMeshes::DRAW_COMMAND) * commands.size(), commands.data(), GL_STATIC_DRAW);
+
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayVertexBuffer(vao, 0, vertexBuffer, 0, sizeof(glm::vec3));
+	glVertexArrayElementBuffer(vao, indexBuffer);
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, 0, 0);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glEnableVertexArrayAttrib(vao, 1 + column);
+		glVertexArrayAttribFormat(vao, 1 + column, 4, GL_FLOAT, GL_FALSE, column * sizeof(glm::vec4));
+		glVertexArrayAttribBinding(vao, 1 + column, 1);
+	}
+	glEnableVertexArrayAttrib(vao, 5);
+	glVertexArrayAttribIFormat(vao, 5, 1, GL_INT, offsetof(SceneMeshes::INSTANCE_DATA, materialIndex));
+	glVertexArrayAttribBinding(vao, 5, 1);
+	glVertexArrayBindingDivisor(vao, 1, 1);
+
+	GLuint colorTexture = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &colorTexture);
+	glTextureStorage2D(colorTexture, 1, GL_R32I, VIEWPORT_SIZE, VIEWPORT_SIZE);
+	glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, colorTexture, 0);
+	glNamedFramebufferDrawBuffer(framebuffer, GL_COLOR_ATTACHMENT0);
+
+	std::vector<GLint> images[3];
+	for (int image = 0; (image < 3) && (drawProgram != 0); image++)
+	{
+		if (image == 2)
+		{
+			// without indirect count draws every command is kept
+			// in place, with the instances the cull gave it
+			culling.m_bIndirectCount = false;
+			culling.Cull(planes, instanceBuffer, commandBuffer, drawDataBuffer);
+			glGetNamedBufferSubData(commandBuffer, 0, sizeof(SceneMeshes::DRAW_COMMAND) * COMMAND_COUNT, compactCommands.data());
+			for (int command = 0; command < COMMAND_COUNT; command++)
+			{
+				if ((compactCommands[command].instanceCount != workingCommands[command].instanceCount) ||
+					(compactCommands[command].baseInstance != commands[command].baseInstance))
+				{
+					if (errors++ < MAX_ERRORS)
+					{
+						std::cout << "ERROR: GPU culling without indirect count moved command " << command << std::endl;
+					}
+				}
+			}
+		}
+
+		const GLint background = -1;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glClearBufferiv(GL_COLOR, 0, &background);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_SCISSOR_TEST);
+		glClearDepth(wallDepth);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+		glClearDepth(1.0);
+
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glUseProgram(drawProgram);
+		glUniformMatrix4fv(glGetUniformLocation(drawProgram, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+		glBindVertexArray(vao);
+		glVertexArrayVertexBuffer(vao, 1, (image == 0) ? sourceInstanceBuffer : instanceBuffer, 0, sizeof(SceneMeshes::INSTANCE_DATA));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, (image == 0) ? sourceCommandBuffer : commandBuffer);
+		if (image == 1)
+		{
+			glBindBuffer(GL_PARAMETER_BUFFER, culling.m_drawCountBuffer);
+			for (int range = 0; range < 2; range++)
+			{
+				int firstCommand = (range == 0) ? 0 : OPAQUE_COMMAND_COUNT;
+				int maxCommandCount = (range == 0) ? OPAQUE_COMMAND_COUNT : COMMAND_COUNT - OPAQUE_COMMAND_COUNT;
+				// core since OpenGL 4.6, an extension before that
+				if (GLEW_VERSION_4_6)
+				{
+					glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT,
+						(void*)(sizeof(SceneMeshes::DRAW_COMMAND) * firstCommand),
+						culling.GetDrawCountOffset(range == 1), maxCommandCount, 0);
+				}
+				else
+				{
+					glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT,
+						(void*)(sizeof(SceneMeshes::DRAW_COMMAND) * firstCommand),
+						culling.GetDrawCountOffset(range == 1), maxCommandCount, 0);
+				}
+			}
+			glBindBuffer(GL_PARAMETER_BUFFER, 0);
+		}
+		else
+		{
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, COMMAND_COUNT, 0);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		glDisable(GL_DEPTH_TEST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		images[image].resize(VIEWPORT_SIZE * VIEWPORT_SIZE);
+		glGetTextureImage(colorTexture, 0, GL_RED_INTEGER, GL_INT,
+			(GLsizei)(sizeof(GLint) * images[image].size()), images[image].data());
+	}
+
+	int coveredPixels = 0;
+	for (size_t pixel = 0; pixel < images[0].size(); pixel++)
+	{
+		coveredPixels += (images[0][pixel] >= 0) ? 1 : 0;
+	}
+	for (int image = 1; (image < 3) && (drawProgram != 0); image++)
+	{
+		int differentPixels = 0;
+		for (size_t pixel = 0; pixel < images[0].size(); pixel++)
+		{
+			differentPixels += (images[image][pixel] != images[0][pixel]) ? 1 : 0;
+		}
+		if (differentPixels > 0)
+		{
+			std::cout << "ERROR: GPU culling image " << image << " differs from the unculled image in "
+				<< differentPixels << " pixels" << std::endl;
+			errors++;
+		}
+	}
+	if ((drawProgram != 0) && (coveredPixels == 0))
+	{
+		std::cout << "ERROR: GPU culling check drew no boxes" << std::endl;
+		errors++;
+	}
+
+	glDeleteProgram(drawProgram);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteBuffers(1, &sourceInstanceBuffer);
+	glDeleteBuffers(1, &sourceCommandBuffer);
+	glDeleteBuffers(1, &instanceBuffer);
+	glDeleteBuffers(1, &commandBuffer);
+	glDeleteBuffers(1, &drawDataBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &colorTexture);
+	glDeleteTextures(1, &depthTexture);
+
+	if (errors > 0)
+	{
+		std::cout << "ERROR: GPU culling check failed with " << errors << " errors" << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: GPU culling check passed on " << glGetString(GL_RENDERER) << ", "
+		<< objectCount << " boxes, " << visibleCount << " visible, "
+		<< occludedCount << " occluded, " << (objectCount - frustumCount)
+		<< " outside the frustum, " << drawCounts[0] << " opaque and " << drawCounts[1]
+		<< " translucent commands drawn, " << coveredPixels << " box pixels the same in all three images" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the compute shaders and
+ *  resolving their uniform locations.
+ ***********************************************************/
+bool GpuCulling::Initialize(
+	const char* cullShaderFile,
+	const char* compactShaderFile,
+	const char* depthPyramidShaderFile)
+{
+	if (m_cullProgram != 0)
+	{
+		return(true);
+	}
+
+	m_cullProgram = LoadComputeProgram(cullShaderFile);
+	m_compactProgram = LoadComputeProgram(compactShaderFile);
+	m_depthPyramidProgram = LoadComputeProgram(depthPyramidShaderFile);
+	if ((m_cullProgram == 0) || (m_compactProgram == 0) || (m_depthPyramidProgram == 0))
+	{
+		return(false);
+	}
+
+	m_objectCountLocation = glGetUniformLocation(m_cullProgram, "objectCount");
+	m_instanceWordsLocation = glGetUniformLocation(m_cullProgram, "wordsPerInstance");
+	m_frustumPlanesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+	m_previousViewProjectionLocation = glGetUniformLocation(m_cullProgram, "previousViewProjection");
+	m_bDepthPyramidValidLocation = glGetUniformLocation(m_cullProgram, "bDepthPyramidValid");
+	m_depthPyramidLevelsLocation = glGetUniformLocation(m_cullProgram, "depthPyramidLevels");
+	m_commandCountLocation = glGetUniformLocation(m_compactProgram, "commandCount");
+	m_opaqueCommandCountLocation = glGetUniformLocation(m_compactProgram, "opaqueCommandCount");
+	m_bCompactLocation = glGetUniformLocation(m_compactProgram, "bCompact");
+	m_bFromDepthLocation = glGetUniformLocation(m_depthPyramidProgram, "bFromDepth");
+	m_targetSizeLocation = glGetUniformLocation(m_depthPyramidProgram, "targetSize");
+	glProgramUniform1i(m_cullProgram, glGetUniformLocation(m_cullProgram, "depthPyramid"), DEPTH_PYRAMID_TEXTURE_UNIT);
+	glProgramUniform1i(m_depthPyramidProgram, glGetUniformLocation(m_depthPyramidProgram, "depthTexture"), DEPTH_PYRAMID_TEXTURE_UNIT);
+
+	// the draw counts only exist when the driver can draw with
+	// them, one for the opaque and one for the translucent range
+	m_bIndirectCount = (GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters) ? true : false;
+
+	glGenBuffers(1, &m_drawCountBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the visible and occluded counts of each frame are copied
+	// into a slot of a buffer that stays mapped for reading, the
+	// mapping is coherent so a slot can be read once its fence
+	// has signaled
+	const GLbitfield readbackFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr readbackSize = 2 * sizeof(GLuint) * COUNT_READBACK_SLOTS;
+	glCreateBuffers(1, &m_cullCountBuffer);
+	glNamedBufferStorage(m_cullCountBuffer, 2 * sizeof(GLuint), NULL, 0);
+	glCreateBuffers(1, &m_countReadbackBuffer);
+	glNamedBufferStorage(m_countReadbackBuffer, readbackSize, NULL, readbackFlags);
+	m_pCountReadback = (GLuint*)glMapNamedBufferRange(m_countReadbackBuffer, 0, readbackSize, readbackFlags);
+	if (NULL == m_pCountReadback)
+	{
+		std::cout << "WARNING: the cull count buffer could not be mapped, culled objects are not counted" << std::endl;
+	}
+
+	std::cout << "INFO: GPU culling initialized, " <<
+		(m_bIndirectCount ? "compacting the draw commands" : "zeroing the culled draw commands") << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadComputeProgram()
+ *
+ *  This method is used for compiling a compute shader from
+ *  a file and linking it into a program of its own.  Zero is
+ *  returned when the file cannot be read or the shader does
+ *  not build.
+ ***********************************************************/
+GLuint GpuCulling::LoadComputeProgram(const char* filename)
+{
+	GLuint shader = CompileShaderFiles(GL_COMPUTE_SHADER, &filename, 1);
+
+	return(LinkShaderProgram(&shader, 1));
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method is used for uploading the instance values and
+ *  bounds of every object, along with the commands that draw
+ *  them.  The commands are kept with their instance counts
+ *  zeroed, for the cull to count the survivors back into.
+ *  The opaque commands have to come before the translucent
+ *  ones, which are compacted into a range of their own.
+ ***********************************************************/
+void GpuCulling::SetObjects(
+	const std::vector<SceneMeshes::INSTANCE_DATA>& instances,
+	const std::vector<CULL_OBJECT>& objects,
+	const std::vector<SceneMeshes::DRAW_COMMAND>& commands,
+	int opaqueCommandCount)
+{
+	m_objectCount = (int)objects.size();
+	m_commandCount = (int)commands.size();
+	m_opaqueCommandCount = opaqueCommandCount;
+	if ((m_objectCount == 0) || (m_commandCount == 0))
+	{
+		return;
+	}
+
+	std::vector<SceneMeshes::DRAW_COMMAND> templateCommands = commands;
+	for (SceneMeshes::DRAW_COMMAND& command : templateCommands)
+	{
+		command.instanceCount = 0;
+	}
+
+	if (m_sourceInstanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_sourceInstanceBuffer);
+		glGenBuffers(1, &m_objectBuffer);
+		glGenBuffers(1, &m_commandTemplateBuffer);
+		glGenBuffers(1, &m_workingCommandBuffer);
+		glGenBuffers(1, &m_compactDrawDataBuffer);
+	}
+
+	// these are only replaced when the render list changes,
+	// moved objects are written in place by UpdateObjects()
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_sourceInstanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SceneMeshes::INSTANCE_DATA) * instances.size(), instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(CULL_OBJECT) * objects.size(), objects.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandTemplateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SceneMeshes::DRAW_COMMAND) * templateCommands.size(), templateCommands.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_workingCommandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SceneMeshes::DRAW_COMMAND) * templateCommands.size(), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_compactDrawDataBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_SIZE * m_commandCount, NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UpdateObjects()
+ *
+ *  This method is used for uploading the instance values and
+ *  bounds of a range of objects in place, so moving a few
+ *  objects costs no more than writing those few.  The range
+ *  has to be inside the objects given to SetObjects().
+ ***********************************************************/
+void GpuCulling::UpdateObjects(
+	const std::vector<SceneMeshes::INSTANCE_DATA>& instances,
+	const std::vector<CULL_OBJECT>& objects,
+	int firstObject,
+	int objectCount)
+{
+	if ((m_sourceInstanceBuffer == 0) || (firstObject < 0) || (objectCount <= 0) ||
+		(firstObject + objectCount > m_objectCount))
+	{
+		return;
+	}
+
+	glNamedBufferSubData(
+		m_sourceInstanceBuffer,
+		sizeof(SceneMeshes::INSTANCE_DATA) * firstObject,
+		sizeof(SceneMeshes::INSTANCE_DATA) * objectCount,
+		&instances[firstObject]);
+	glNamedBufferSubData(
+		m_objectBuffer,
+		sizeof(CULL_OBJECT) * firstObject,
+		sizeof(CULL_OBJECT) * objectCount,
+		&objects[firstObject]);
+}
+
+/***********************************************************
+ *  UpdateCommands()
+ *
+ *  This method is used for uploading a range of the commands
+ *  in place, with their instance counts zeroed like the
+ *  ones uploaded by SetObjects().
+ ***********************************************************/
+void GpuCulling::UpdateCommands(
+	const std::vector<SceneMeshes::DRAW_COMMAND>& commands,
+	int firstCommand,
+	int commandCount)
+{
+	if ((m_commandTemplateBuffer == 0) || (firstCommand < 0) || (commandCount <= 0) ||
+		(firstCommand + commandCount > m_commandCount))
+	{
+		return;
+	}
+
+	std::vector<SceneMeshes::DRAW_COMMAND> templateCommands(
+		commands.begin() + firstCommand,
+		commands.begin() + firstCommand + commandCount);
+	for (SceneMeshes::DRAW_COMMAND& command : templateCommands)
+	{
+		command.instanceCount = 0;
+	}
+
+	glNamedBufferSubData(
+		m_commandTemplateBuffer,
+		sizeof(SceneMeshes::DRAW_COMMAND) * firstCommand,
+		sizeof(SceneMeshes::DRAW_COMMAND) * commandCount,
+		templateCommands.data());
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for culling every object on the GPU.
+ *  The first dispatch tests each object, appends the ones
+ *  that pass to the instances of their command and counts
+ *  them, and the counts are copied out for reading once the
+ *  frame has finished.  The second dispatch compacts the
+ *  commands that still draw anything, keeping their order so
+ *  translucent draws stay sorted, with the opaque commands
+ *  packed from the start of the buffer and the translucent
+ *  ones from the first translucent command on, or copies
+ *  every command across when the driver cannot draw with a
+ *  draw count.  The caller has to make its own shader
+ *  program current again afterwards.
+ ***********************************************************/
+void GpuCulling::Cull(
+	const glm::vec4 frustumPlanes[6],
+	GLuint instanceBuffer,
+	GLuint commandBuffer,
+	GLuint drawDataBuffer)
+{
+	if ((m_cullProgram == 0) || (m_objectCount == 0) || (m_commandCount == 0))
+	{
+		return;
+	}
+
+	ReadCullCounts();
+
+	GLsizeiptr commandSize = sizeof(SceneMeshes::DRAW_COMMAND) * m_commandCount;
+
+	// start every command with no instances
+	glBindBuffer(GL_COPY_READ_BUFFER, m_commandTemplateBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_workingCommandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandSize);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glClearNamedBufferData(m_cullCountBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+	glUseProgram(m_cullProgram);
+	glUniform1ui(m_objectCountLocation, (GLuint)m_objectCount);
+	glUniform1ui(m_instanceWordsLocation, (GLuint)(sizeof(SceneMeshes::INSTANCE_DATA) / sizeof(GLuint)));
+	glUniform4fv(m_frustumPlanesLocation, 6, glm::value_ptr(frustumPlanes[0]));
+	glUniformMatrix4fv(m_previousViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(m_previousViewProjection));
+	glUniform1i(m_bDepthPyramidValidLocation, m_bDepthPyramidValid ? 1 : 0);
+	glUniform1i(m_depthPyramidLevelsLocation, m_depthPyramidLevels);
+	if (m_bDepthPyramidValid == true)
+	{
+		// bound by unit so the active texture unit tracked by
+		// the uniform cache is left alone
+		glBindTextureUnit(DEPTH_PYRAMID_TEXTURE_UNIT, m_depthPyramid);
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OBJECT_BINDING, m_objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SOURCE_INSTANCE_BINDING, m_sourceInstanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WORKING_COMMAND_BINDING, m_workingCommandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COUNT_BINDING, m_cullCountBuffer);
+	glDispatchCompute((m_objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// copy the counts into the next readback slot, unless the
+	// GPU is still working on the frame that slot came from,
+	// in which case this frame goes uncounted rather than wait
+	int countSlot = m_nextCountSlot;
+	if ((NULL != m_pCountReadback) && (m_countFences[countSlot] == 0))
+	{
+		glCopyNamedBufferSubData(
+			m_cullCountBuffer,
+			m_countReadbackBuffer,
+			0,
+			2 * sizeof(GLuint) * countSlot,
+			2 * sizeof(GLuint));
+		m_countFences[countSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_nextCountSlot = (countSlot + 1) % COUNT_READBACK_SLOTS;
+	}
+
+	// a single work group scans the commands in order
+	glUseProgram(m_compactProgram);
+	glUniform1ui(m_commandCountLocation, (GLuint)m_commandCount);
+	glUniform1ui(m_opaqueCommandCountLocation, (GLuint)m_opaqueCommandCount);
+	glUniform1i(m_bCompactLocation, m_bIndirectCount ? 1 : 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, drawDataBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMPACT_DRAW_DATA_BINDING, m_compactDrawDataBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT_BINDING, m_drawCountBuffer);
+	glDispatchCompute(1, 1, 1);
+
+	// the results are read as draw commands, draw parameters,
+	// instance attributes and per-draw storage
+	glMemoryBarrier(
+		GL_COMMAND_BARRIER_BIT |
+		GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+		GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************
+ *  ReadCullCounts()
+ *
+ *  This method is used for reading the visible and occluded
+ *  counts of every frame the GPU has finished, oldest first,
+ *  so the latest finished frame's counts are kept.  Fences
+ *  are only polled, the CPU never waits on them.
+ ***********************************************************/
+void GpuCulling::ReadCullCounts()
+{
+	if (NULL == m_pCountReadback)
+	{
+		return;
+	}
+
+	// the next slot to write holds the oldest copy
+	for (int i = 0; i < COUNT_READBACK_SLOTS; i++)
+	{
+		int slot = (m_nextCountSlot + i) % COUNT_READBACK_SLOTS;
+		if (m_countFences[slot] == 0)
+		{
+			continue;
+		}
+
+		GLenum result = glClientWaitSync(m_countFences[slot], 0, 0);
+		if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+		{
+			break;
+		}
+		glDeleteSync(m_countFences[slot]);
+		m_countFences[slot] = 0;
+
+		m_visibleCount = (int)m_pCountReadback[2 * slot];
+		m_occludedCount = (int)m_pCountReadback[2 * slot + 1];
+	}
+}
+
+/***********************************************************
+ *  BuildDepthPyramid()
+ *
+ *  This method is used for copying the depth buffer of the
+ *  frame just drawn and reducing it into a pyramid where each
+ *  texel holds the farthest depth of the texels below it.
+ *  An object whose nearest depth is behind the farthest depth
+ *  of every texel it covers is hidden.
+ ***********************************************************/
+void GpuCulling::BuildDepthPyramid(const glm::mat4& viewProjection)
+{
+	if (m_depthPyramidProgram == 0)
+	{
+		return;
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		return;
+	}
+	if ((viewport[2] != m_depthWidth) || (viewport[3] != m_depthHeight))
+	{
+		CreateDepthPyramid(viewport[2], viewport[3]);
+	}
+
+	glCopyTextureSubImage2D(m_depthTexture, 0, 0, 0, viewport[0], viewport[1], m_depthWidth, m_depthHeight);
+
+	glUseProgram(m_depthPyramidProgram);
+
+	// the first level is read straight from the depth copy
+	int width = m_depthWidth;
+	int height = m_depthHeight;
+	glUniform1i(m_bFromDepthLocation, 1);
+	glUniform2i(m_targetSizeLocation, width, height);
+	glBindTextureUnit(DEPTH_PYRAMID_TEXTURE_UNIT, m_depthTexture);
+	glBindImageTexture(TARGET_LEVEL_IMAGE, m_depthPyramid, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute(
+		(width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+		(height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+		1);
+
+	// every other level reduces the one above it
+	glUniform1i(m_bFromDepthLocation, 0);
+	for (int level = 1; level < m_depthPyramidLevels; level++)
+	{
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		glUniform2i(m_targetSizeLocation, width, height);
+		glBindImageTexture(SOURCE_LEVEL_IMAGE, m_depthPyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(TARGET_LEVEL_IMAGE, m_depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(
+			(width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+			(height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+			1);
+	}
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	m_previousViewProjection = viewProjection;
+	m_bDepthPyramidValid = true;
+}
+
+/***********************************************************
+ *  CreateDepthPyramid()
+ *
+ *  This method is used for creating the depth copy and the
+ *  full mip chain of the pyramid for a viewport size, or for
+ *  releasing them when the size is zero.
+ ***********************************************************/
+void GpuCulling::CreateDepthPyramid(int width, int height)
+{
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+	if (m_depthPyramid != 0)
+	{
+		glDeleteTextures(1, &m_depthPyramid);
+		m_depthPyramid = 0;
+	}
+	m_depthWidth = 0;
+	m_depthHeight = 0;
+	m_depthPyramidLevels = 0;
+	m_bDepthPyramidValid = false;
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	m_depthWidth = width;
+	m_depthHeight = height;
+	m_depthPyramidLevels = 1;
+	for (int size = (width > height) ? width : height; size > 1; size /= 2)
+	{
+		m_depthPyramidLevels++;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT24, width, height);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthPyramid);
+	glTextureStorage2D(m_depthPyramid, m_depthPyramidLevels, GL_R32F, width, height);
+	glTextureParameteri(m_depthPyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTextureParameteri(m_depthPyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthPyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(m_depthPyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.h
+// ============
+// cull the render list on the GPU against the view frustum and a
+// hierarchical depth pyramid, writing the indirect draws that survive
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneMeshes.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  GpuCulling
+ *
+ *  This class moves the culling of the render list onto the
+ *  GPU.  The bounds, instance values and indirect commands of
+ *  every object are uploaded once, with only the ranges that
+ *  change written again afterwards, and each frame a compute
+ *  shader tests every object against the view frustum and
+ *  against a depth pyramid built from the depth buffer of the
+ *  previous frame.  The instance values of the objects that
+ *  pass are packed into the instance buffer, the commands are
+ *  compacted into the indirect buffer in their original
+ *  order, and a draw count is written for each of the opaque
+ *  and the translucent ranges, so the two can be drawn by
+ *  glMultiDrawElementsIndirectCount with their own blending
+ *  and depth writes.  Drivers without indirect count draws
+ *  get every command instead, with the culled ones left at
+ *  an instance count of zero.
+ *
+ *  The culling itself costs the CPU a handful of dispatches
+ *  and uniform updates per frame, whatever the number of
+ *  objects.  What does grow is the work around it: the
+ *  translucent commands are sorted back to front on the CPU
+ *  and uploaded again every frame, which grows with the
+ *  number of glass objects, and moved objects are written
+ *  again one instance at a time.  The levels of detail, the
+ *  tessellated meshes and the impostors all change the draws
+ *  on the CPU, so they are left out of this path.  The
+ *  counts of visible and occluded objects are copied into a
+ *  persistently mapped buffer and read once a fence says the
+ *  frame has finished, so they trail by a frame or two
+ *  instead of stalling the CPU.
+ ***********************************************************/
+class GpuCulling
+{
+public:
+	// constructor
+	GpuCulling();
+	// destructor
+	~GpuCulling();
+
+	// bounds of one instance in the instance buffer and the
+	// command that draws it, laid out to match the std430
+	// CullObject shader struct
+	struct CULL_OBJECT
+	{
+		glm::vec3 aabbMin;
+		GLuint commandIndex;
+		glm::vec3 aabbMax;
+		GLuint padding;
+	};
+
+	// true when the driver can run the compute shaders, which
+	// takes OpenGL 4.5
+	static bool IsSupported();
+	// cull a known set of boxes with the compute shaders, with
+	// and without indirect count draws, and compare the results
+	// with the ones worked out on the CPU - needs a current
+	// OpenGL 4.5 context
+	static bool RunCullCheck();
+
+	// load the compute shaders
+	bool Initialize(
+		const char* cullShaderFile,
+		const char* compactShaderFile,
+		const char* depthPyramidShaderFile);
+
+	// upload the instance values, bounds and commands of the
+	// whole render list, whenever any of them change - the
+	// first opaqueCommandCount commands are the opaque ones
+	void SetObjects(
+		const std::vector<SceneMeshes::INSTANCE_DATA>& instances,
+		const std::vector<CULL_OBJECT>& objects,
+		const std::vector<SceneMeshes::DRAW_COMMAND>& commands,
+		int opaqueCommandCount);
+	// upload the instance values and bounds of a range of the
+	// objects already uploaded, such as the ones that moved
+	void UpdateObjects(
+		const std::vector<SceneMeshes::INSTANCE_DATA>& instances,
+		const std::vector<CULL_OBJECT>& objects,
+		int firstObject,
+		int objectCount);
+	// upload a range of the commands already uploaded, such as
+	// the translucent ones after they were put in a new order
+	void UpdateCommands(
+		const std::vector<SceneMeshes::DRAW_COMMAND>& commands,
+		int firstCommand,
+		int commandCount);
+
+	// cull every object, writing the survivors into the given
+	// instance and command buffers, and the per-draw values of
+	// the surviving commands into the compacted draw buffer -
+	// the per-draw values are copied as one uvec4 each
+	void Cull(
+		const glm::vec4 frustumPlanes[6],
+		GLuint instanceBuffer,
+		GLuint commandBuffer,
+		GLuint drawDataBuffer);
+
+	// build the depth pyramid from the depth buffer of the
+	// frame just drawn, for culling the next frame
+	void BuildDepthPyramid(const glm::mat4& viewProjection);
+
+	// true when the commands are compacted and drawn with
+	// glMultiDrawElementsIndirectCount
+	bool IsCompacting() const { return(m_bIndirectCount); }
+	// buffer holding the draw counts of the compacted commands
+	GLuint GetDrawCountBuffer() const { return(m_drawCountBuffer); }
+	// offset in the draw count buffer of the opaque or the
+	// translucent draw count
+	static GLintptr GetDrawCountOffset(bool bTranslucent) { return(bTranslucent ? sizeof(GLuint) : 0); }
+	// per-draw values of the compacted commands
+	GLuint GetDrawDataBuffer() const { return(m_compactDrawDataBuffer); }
+	// objects drawn and objects hidden by the depth pyramid in
+	// the latest frame the GPU has finished
+	int GetVisibleCount() const { return(m_visibleCount); }
+	int GetOccludedCount() const { return(m_occludedCount); }
+
+private:
+	// compute shader programs and their uniform locations
+	GLuint m_cullProgram;
+	GLuint m_compactProgram;
+	GLuint m_depthPyramidProgram;
+	GLint m_objectCountLocation;
+	GLint m_instanceWordsLocation;
+	GLint m_frustumPlanesLocation;
+	GLint m_previousViewProjectionLocation;
+	GLint m_bDepthPyramidValidLocation;
+	GLint m_depthPyramidLevelsLocation;
+	GLint m_commandCountLocation;
+	GLint m_opaqueCommandCountLocation;
+	GLint m_bCompactLocation;
+	GLint m_bFromDepthLocation;
+	GLint m_targetSizeLocation;
+
+	// instance values and bounds of every object
+	GLuint m_sourceInstanceBuffer;
+	GLuint m_objectBuffer;
+	// commands with their instance counts zeroed, copied into
+	// the working command buffer at the start of every cull
+	GLuint m_commandTemplateBuffer;
+	GLuint m_workingCommandBuffer;
+	GLuint m_compactDrawDataBuffer;
+	GLuint m_drawCountBuffer;
+	int m_objectCount;
+	int m_commandCount;
+	int m_opaqueCommandCount;
+	bool m_bIndirectCount;
+
+	// copy of the depth buffer and the pyramid of farthest
+	// depths built from it
+	GLuint m_depthTexture;
+	GLuint m_depthPyramid;
+	int m_depthWidth;
+	int m_depthHeight;
+	int m_depthPyramidLevels;
+	bool m_bDepthPyramidValid;
+	// view-projection matrix the depth pyramid was drawn with
+	glm::mat4 m_previousViewProjection;
+
+	// frames whose counts can be waiting on the GPU at once
+	static const int COUNT_READBACK_SLOTS = 3;
+	// counts written by the cull, and the mapped buffer each
+	// frame's counts are copied into, one slot per frame
+	GLuint m_cullCountBuffer;
+	GLuint m_countReadbackBuffer;
+	GLuint* m_pCountReadback;
+	GLsync m_countFences[COUNT_READBACK_SLOTS];
+	int m_nextCountSlot;
+	int m_visibleCount;
+	int m_occludedCount;
+
+	// compile and link a compute shader from a file
+	static GLuint LoadComputeProgram(const char* filename);
+	// create the depth copy and the pyramid for a viewport size
+	void CreateDepthPyramid(int width, int height);
+	// read the counts of every finished frame
+	void ReadCullCounts();
+};
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.cpp
+// ============
+// time a span of GL commands on the GPU without waiting for the result
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuTimer.h"
+
+/***********************************************************
+ *  GpuTimer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuTimer::GpuTimer()
+{
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_queries[i] = 0;
+		m_bPending[i] = false;
+	}
+	m_nextQuery = 0;
+	m_bTiming = false;
+	m_milliseconds = 0.0f;
+}
+
+/***********************************************************
+ *  ~GpuTimer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuTimer::~GpuTimer()
+{
+	if (m_queries[0] != 0)
+	{
+		glDeleteQueries(QUERY_COUNT, m_queries);
+		m_queries[0] = 0;
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for starting to time the commands
+ *  that follow.  When every query in the ring is still
+ *  waiting on its result, this span is simply not timed.
+ ***********************************************************/
+void GpuTimer::Begin()
+{
+	if (m_queries[0] == 0)
+	{
+		glGenQueries(QUERY_COUNT, m_queries);
+	}
+
+	ReadResults();
+
+	m_bTiming = (m_bPending[m_nextQuery] == false);
+	if (m_bTiming == true)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_nextQuery]);
+	}
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for stopping the timer started by
+ *  Begin() and moving on to the next query in the ring.
+ ***********************************************************/
+void GpuTimer::End()
+{
+	if (m_bTiming == false)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bPending[m_nextQuery] = true;
+	m_nextQuery = (m_nextQuery + 1) % QUERY_COUNT;
+	m_bTiming = false;
+}
+
+/***********************************************************
+ *  ReadResults()
+ *
+ *  This method is used for reading back the pending queries
+ *  whose results have arrived, oldest first, keeping the
+ *  time of the most recent one.
+ ***********************************************************/
+void GpuTimer::ReadResults()
+{
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		int query = (m_nextQuery + i) % QUERY_COUNT;
+		if (m_bPending[query] == false)
+		{
+			continue;
+		}
+
+		GLint bAvailable = GL_FALSE;
+		glGetQueryObjectiv(m_queries[query], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == GL_FALSE)
+		{
+			continue;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(m_queries[query], GL_QUERY_RESULT, &nanoseconds);
+		m_milliseconds = (float)((double)nanoseconds / 1000000.0);
+		m_bPending[query] = false;
+	}
+}
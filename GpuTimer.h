@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.h
+// ============
+// time a span of GL commands on the GPU without waiting for the result
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GpuTimer
+ *
+ *  This class times the GL commands issued between Begin()
+ *  and End() with a GL_TIME_ELAPSED query.  The queries are
+ *  kept in a small ring, and a result is only read once the
+ *  GPU has it available, so the time reported is usually
+ *  from a frame or two ago but the CPU never waits for it.
+ *  Only one timer can be running at any moment, since time
+ *  elapsed queries cannot be nested.
+ ***********************************************************/
+class GpuTimer
+{
+public:
+	// constructor
+	GpuTimer();
+	// destructor
+	~GpuTimer();
+
+	// start timing the commands that follow
+	void Begin();
+	// stop timing, the result is read back in a later frame
+	void End();
+
+	// GPU time of the latest span whose result has arrived
+	float GetMilliseconds() const { return(m_milliseconds); }
+
+private:
+	// spans in flight before a query has to be reused
+	static const int QUERY_COUNT = 4;
+
+	GLuint m_queries[QUERY_COUNT];
+	// a query was issued and its result has not been read
+	bool m_bPending[QUERY_COUNT];
+	// query the next span is timed with
+	int m_nextQuery;
+	// true between Begin() and End() when a query was free
+	bool m_bTiming;
+	float m_milliseconds;
+
+	// read back every pending result that has arrived
+	void ReadResults();
+};
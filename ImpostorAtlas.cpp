@@ -0,0 +1,560 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.cpp
+// ============
+// bake objects into an atlas of octahedral views and draw distant copies
+// of them as single quads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImpostorAtlas.h"
+#include "TextureUnits.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// vertex attribute locations used by the impostor shaders
+	const GLuint CORNER_ATTRIBUTE = 0;
+	const GLuint CENTER_RADIUS_ATTRIBUTE = 1;
+	const GLuint ROTATION_ATTRIBUTE = 2;
+	const GLuint LAYER_ATTRIBUTE = 3;
+	const GLuint MATERIAL_ATTRIBUTE = 4;
+
+	// width and height of one atlas layer in pixels
+	const int ATLAS_PIXELS = ImpostorAtlas::VIEW_GRID * ImpostorAtlas::VIEW_PIXELS;
+
+	// corners of the quad, stretched over the bounds of each
+	// impostor by the vertex shader
+	const GLfloat QUAD_CORNERS[] =
+	{
+		-1.0f, -1.0f,
+		1.0f, -1.0f,
+		-1.0f, 1.0f,
+		1.0f, 1.0f
+	};
+
+	// identifies a cache file and the layout it was written in
+	const char CACHE_MAGIC[4] = { 'I', 'M', 'P', 'A' };
+	const uint32_t CACHE_VERSION = 1;
+
+	// header at the start of a cache file, followed by the
+	// color layers and then the normal layers
+	struct CACHE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		int32_t impostorCount;
+		int32_t viewGrid;
+		int32_t viewPixels;
+		int32_t padding;
+	};
+}
+
+/***********************************************************
+ *  ImpostorAtlas()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImpostorAtlas::ImpostorAtlas()
+{
+	m_bakeProgram = 0;
+	m_drawProgram = 0;
+	m_bakeFirstDrawIDLocation = -1;
+	m_sceneUniformBuffer = 0;
+	m_colorAtlas = 0;
+	m_normalAtlas = 0;
+	m_impostorCount = 0;
+	m_framebuffer = 0;
+	m_depthBuffer = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_viewport[i] = 0;
+	}
+	m_bakeLayer = -1;
+	m_vao = 0;
+	m_quadBuffer = 0;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+}
+
+/***********************************************************
+ *  ~ImpostorAtlas()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImpostorAtlas::~ImpostorAtlas()
+{
+	if (m_bakeProgram != 0)
+	{
+		glDeleteProgram(m_bakeProgram);
+		m_bakeProgram = 0;
+	}
+	if (m_drawProgram != 0)
+	{
+		glDeleteProgram(m_drawProgram);
+		m_drawProgram = 0;
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_quadBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_vao = 0;
+	}
+
+	CreateAtlas(0);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for linking the program that bakes
+ *  the views and the program that draws the impostor quads.
+ *  Calling it again once it has succeeded does nothing.
+ ***********************************************************/
+bool ImpostorAtlas::Initialize(
+	const char* bakeVertexShaderFile,
+	const char* bakeFragmentShaderFile,
+	const char* drawVertexShaderFile,
+	const char* drawFragmentShaderFile)
+{
+	if ((m_bakeProgram != 0) && (m_drawProgram != 0))
+	{
+		return(true);
+	}
+
+	GLuint shaders[2];
+	if (m_bakeProgram == 0)
+	{
+		shaders[0] = CompileShaderFiles(GL_VERTEX_SHADER, &bakeVertexShaderFile, 1);
+		shaders[1] = CompileShaderFiles(GL_FRAGMENT_SHADER, &bakeFragmentShaderFile, 1);
+		m_bakeProgram = LinkShaderProgram(shaders, 2);
+		if (m_bakeProgram == 0)
+		{
+			return(false);
+		}
+
+		m_bakeFirstDrawIDLocation = glGetUniformLocation(m_bakeProgram, "firstDrawID");
+		m_bakeSceneUniforms.Initialize();
+
+		// without bindless handles each texture array is read
+		// from the texture unit of the same number, as in the
+		// scene program
+		for (GLuint unit = 0; unit < SCENE_TEXTURE_ARRAY_UNITS; unit++)
+		{
+			std::string elementName = "textureArrays[" + std::to_string(unit) + "]";
+			glProgramUniform1i(m_bakeProgram, glGetUniformLocation(m_bakeProgram, elementName.c_str()), (GLint)unit);
+		}
+	}
+
+	shaders[0] = CompileShaderFiles(GL_VERTEX_SHADER, &drawVertexShaderFile, 1);
+	shaders[1] = CompileShaderFiles(GL_FRAGMENT_SHADER, &drawFragmentShaderFile, 1);
+	m_drawProgram = LinkShaderProgram(shaders, 2);
+	if (m_drawProgram == 0)
+	{
+		return(false);
+	}
+
+	glProgramUniform1i(m_drawProgram, glGetUniformLocation(m_drawProgram, "colorAtlas"), COLOR_ATLAS_TEXTURE_UNIT);
+	glProgramUniform1i(m_drawProgram, glGetUniformLocation(m_drawProgram, "normalAtlas"), NORMAL_ATLAS_TEXTURE_UNIT);
+
+	CreateVertexArray();
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateVertexArray()
+ *
+ *  This method is used for creating the vertex array that
+ *  draws the quad once for every impostor instance, reading
+ *  the bounds, rotation, layer and material of each instance
+ *  from the instance buffer.
+ ***********************************************************/
+void ImpostorAtlas::CreateVertexArray()
+{
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_quadBuffer);
+	glGenBuffers(1, &m_instanceBuffer);
+
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_quadBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+	glVertexAttribPointer(CORNER_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 2, (void*)0);
+	glEnableVertexAttribArray(CORNER_ATTRIBUTE);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glVertexAttribPointer(CENTER_RADIUS_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(IMPOSTOR_INSTANCE),
+		(void*)offsetof(IMPOSTOR_INSTANCE, centerRadius));
+	glVertexAttribPointer(ROTATION_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(IMPOSTOR_INSTANCE),
+		(void*)offsetof(IMPOSTOR_INSTANCE, rotation));
+	glVertexAttribIPointer(LAYER_ATTRIBUTE, 1, GL_INT, sizeof(IMPOSTOR_INSTANCE),
+		(void*)offsetof(IMPOSTOR_INSTANCE, layer));
+	glVertexAttribIPointer(MATERIAL_ATTRIBUTE, 1, GL_INT, sizeof(IMPOSTOR_INSTANCE),
+		(void*)offsetof(IMPOSTOR_INSTANCE, materialIndex));
+
+	const GLuint instanceAttributes[] =
+	{
+		CENTER_RADIUS_ATTRIBUTE,
+		ROTATION_ATTRIBUTE,
+		LAYER_ATTRIBUTE,
+		MATERIAL_ATTRIBUTE
+	};
+	for (GLuint attribute : instanceAttributes)
+	{
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  CreateAtlas()
+ *
+ *  This method is used for creating the color and normal
+ *  texture arrays for a number of impostors, releasing the
+ *  old ones first.  A count of 0 only releases them.
+ ***********************************************************/
+void ImpostorAtlas::CreateAtlas(int impostorCount)
+{
+	if (m_colorAtlas != 0)
+	{
+		glDeleteTextures(1, &m_colorAtlas);
+		glDeleteTextures(1, &m_normalAtlas);
+		m_colorAtlas = 0;
+		m_normalAtlas = 0;
+	}
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+	m_impostorCount = (impostorCount > 0) ? impostorCount : 0;
+	if (m_impostorCount == 0)
+	{
+		return;
+	}
+
+	// the views of an impostor share the edges of their
+	// cells, so the atlas is only filtered within a level
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_colorAtlas);
+	glTextureStorage3D(m_colorAtlas, 1, GL_RGBA8, ATLAS_PIXELS, ATLAS_PIXELS, m_impostorCount);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_normalAtlas);
+	glTextureStorage3D(m_normalAtlas, 1, GL_RGBA8, ATLAS_PIXELS, ATLAS_PIXELS, m_impostorCount);
+
+	const GLuint textures[] = { m_colorAtlas, m_normalAtlas };
+	for (GLuint texture : textures)
+	{
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+}
+
+/***********************************************************
+ *  GetAtlasBytes()
+ *
+ *  This method is used for getting the texture memory held
+ *  by the color and normal layers of every impostor.
+ ***********************************************************/
+size_t ImpostorAtlas::GetAtlasBytes() const
+{
+	return((size_t)m_impostorCount * ATLAS_PIXELS * ATLAS_PIXELS * 4 * 2);
+}
+
+/***********************************************************
+ *  GetViewDirection()
+ *
+ *  This method is used for getting the direction a view of
+ *  the grid is baked from.  The grid covers a square that
+ *  the octahedral mapping folds over the whole sphere, the
+ *  inner diamond onto the upper half and the corners onto
+ *  the lower half, so the views are spread close to evenly
+ *  with none of them wasted.  The view shader makes the same
+ *  mapping in reverse to pick the view for the camera.
+ ***********************************************************/
+glm::vec3 ImpostorAtlas::GetViewDirection(int view)
+{
+	// center of the view's cell, from -1 to 1 across the grid
+	float octahedralX = ((view % VIEW_GRID) + 0.5f) * (2.0f / VIEW_GRID) - 1.0f;
+	float octahedralY = ((view / VIEW_GRID) + 0.5f) * (2.0f / VIEW_GRID) - 1.0f;
+
+	glm::vec3 direction(
+		octahedralX,
+		1.0f - std::fabs(octahedralX) - std::fabs(octahedralY),
+		octahedralY);
+	if (direction.y < 0.0f)
+	{
+		direction.x = (1.0f - std::fabs(octahedralY)) * ((octahedralX >= 0.0f) ? 1.0f : -1.0f);
+		direction.z = (1.0f - std::fabs(octahedralX)) * ((octahedralY >= 0.0f) ? 1.0f : -1.0f);
+	}
+
+	return(glm::normalize(direction));
+}
+
+/***********************************************************
+ *  LoadCache()
+ *
+ *  This method is used for creating the atlas and filling it
+ *  from a cache file.  The file is only used when it was
+ *  written with the same key, number of impostors and view
+ *  layout, so a change to the scene bakes the impostors
+ *  again rather than showing stale ones.
+ ***********************************************************/
+bool ImpostorAtlas::LoadCache(const char* filename, uint64_t key, int impostorCount)
+{
+	std::ifstream cacheFile(filename, std::ios::binary);
+	if (cacheFile.is_open() == false)
+	{
+		return(false);
+	}
+
+	CACHE_HEADER header;
+	cacheFile.read((char*)&header, sizeof(header));
+	if ((cacheFile.good() == false) ||
+		(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+		(header.version != CACHE_VERSION) ||
+		(header.key != key) ||
+		(header.impostorCount != impostorCount) ||
+		(header.viewGrid != VIEW_GRID) ||
+		(header.viewPixels != VIEW_PIXELS))
+	{
+		std::cout << "INFO: impostor cache " << filename << " is out of date" << std::endl;
+		return(false);
+	}
+
+	size_t layerBytes = (size_t)ATLAS_PIXELS * ATLAS_PIXELS * 4;
+	std::vector<unsigned char> colorPixels(layerBytes * impostorCount);
+	std::vector<unsigned char> normalPixels(layerBytes * impostorCount);
+	cacheFile.read((char*)colorPixels.data(), colorPixels.size());
+	cacheFile.read((char*)normalPixels.data(), normalPixels.size());
+	if (cacheFile.good() == false)
+	{
+		std::cout << "WARNING: impostor cache " << filename << " is truncated" << std::endl;
+		return(false);
+	}
+
+	CreateAtlas(impostorCount);
+	glTextureSubImage3D(m_colorAtlas, 0, 0, 0, 0, ATLAS_PIXELS, ATLAS_PIXELS, impostorCount,
+		GL_RGBA, GL_UNSIGNED_BYTE, colorPixels.data());
+	glTextureSubImage3D(m_normalAtlas, 0, 0, 0, 0, ATLAS_PIXELS, ATLAS_PIXELS, impostorCount,
+		GL_RGBA, GL_UNSIGNED_BYTE, normalPixels.data());
+
+	return(true);
+}
+
+/***********************************************************
+ *  SaveCache()
+ *
+ *  This method is used for reading the baked atlas back from
+ *  the GPU and writing it to a cache file under a key.
+ ***********************************************************/
+bool ImpostorAtlas::SaveCache(const char* filename, uint64_t key) const
+{
+	if (m_impostorCount == 0)
+	{
+		return(false);
+	}
+
+	size_t atlasBytes = (size_t)ATLAS_PIXELS * ATLAS_PIXELS * 4 * m_impostorCount;
+	std::vector<unsigned char> colorPixels(atlasBytes);
+	std::vector<unsigned char> normalPixels(atlasBytes);
+	glGetTextureImage(m_colorAtlas, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)atlasBytes, colorPixels.data());
+	glGetTextureImage(m_normalAtlas, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)atlasBytes, normalPixels.data());
+
+	std::ofstream cacheFile(filename, std::ios::binary | std::ios::trunc);
+	if (cacheFile.is_open() == false)
+	{
+		std::cout << "WARNING: could not write the impostor cache " << filename << std::endl;
+		return(false);
+	}
+
+	CACHE_HEADER header = {};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.impostorCount = m_impostorCount;
+	header.viewGrid = VIEW_GRID;
+	header.viewPixels = VIEW_PIXELS;
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write((const char*)colorPixels.data(), colorPixels.size());
+	cacheFile.write((const char*)normalPixels.data(), normalPixels.size());
+
+	return(cacheFile.good());
+}
+
+/***********************************************************
+ *  BeginBake()
+ *
+ *  This method is used for creating an empty atlas and the
+ *  framebuffer the views are drawn into, and switching to
+ *  the bake program.  The bake program shares the vertex
+ *  shader of the scene, reading the camera of each view from
+ *  a uniform buffer of its own, and its samplers were set
+ *  when it was linked so it reads the scene textures the
+ *  same way.
+ ***********************************************************/
+void ImpostorAtlas::BeginBake(int impostorCount)
+{
+	CreateAtlas(impostorCount);
+	if ((m_bakeProgram == 0) || (m_impostorCount == 0))
+	{
+		return;
+	}
+
+	glCreateRenderbuffers(1, &m_depthBuffer);
+	glNamedRenderbufferStorage(m_depthBuffer, GL_DEPTH_COMPONENT24, ATLAS_PIXELS, ATLAS_PIXELS);
+
+	const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glCreateFramebuffers(1, &m_framebuffer);
+	glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	glNamedFramebufferDrawBuffers(m_framebuffer, 2, drawBuffers);
+
+	// the views are drawn with their own camera, so the scene
+	// uniform buffer is swapped out until the bake is done
+	glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, SCENE_UNIFORM_BINDING, &m_sceneUniformBuffer);
+	m_bakeSceneUniforms.Bind();
+
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glUseProgram(m_bakeProgram);
+	glEnable(GL_DEPTH_TEST);
+	m_bakeLayer = -1;
+}
+
+/***********************************************************
+ *  BakeView()
+ *
+ *  This method is used for aiming the bake program at one
+ *  view of an impostor.  The view looks at the bounds from
+ *  the direction of its cell with an orthographic camera
+ *  that just fits the bounding sphere, and only draws into
+ *  that cell.  The layer is cleared the first time it is
+ *  drawn into.
+ ***********************************************************/
+void ImpostorAtlas::BakeView(int layer, int view, const glm::vec3& center, float radius, int drawIndex)
+{
+	if ((m_framebuffer == 0) || (layer < 0) || (layer >= m_impostorCount) || (radius <= 0.0f))
+	{
+		return;
+	}
+
+	if (layer != m_bakeLayer)
+	{
+		glNamedFramebufferTextureLayer(m_framebuffer, GL_COLOR_ATTACHMENT0, m_colorAtlas, 0, layer);
+		glNamedFramebufferTextureLayer(m_framebuffer, GL_COLOR_ATTACHMENT1, m_normalAtlas, 0, layer);
+		if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR: the impostor framebuffer is not complete" << std::endl;
+		}
+
+		// empty texels are transparent and are not drawn
+		const GLfloat clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const GLfloat clearDepth = 1.0f;
+		glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, 0, clearColor);
+		glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, 1, clearColor);
+		glClearNamedFramebufferfv(m_framebuffer, GL_DEPTH, 0, &clearDepth);
+		m_bakeLayer = layer;
+	}
+
+	// the up vector has to match the one the view shader
+	// builds the quad with
+	glm::vec3 direction = GetViewDirection(view);
+	glm::vec3 up = (std::fabs(direction.y) > 0.999f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 viewMatrix = glm::lookAt(center + direction * (2.0f * radius), center, up);
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.5f * radius, 3.5f * radius);
+
+	glViewport(
+		(view % VIEW_GRID) * VIEW_PIXELS,
+		(view / VIEW_GRID) * VIEW_PIXELS,
+		VIEW_PIXELS,
+		VIEW_PIXELS);
+	m_bakeSceneUniforms.SetView(viewMatrix, projection, center + direction * (2.0f * radius));
+	m_bakeSceneUniforms.Upload();
+	glProgramUniform1i(m_bakeProgram, m_bakeFirstDrawIDLocation, drawIndex);
+}
+
+/***********************************************************
+ *  EndBake()
+ *
+ *  This method is used for going back to the default
+ *  framebuffer, the viewport it was drawn with and the
+ *  scene uniform buffer.  The caller has to make its own
+ *  shader program current again.
+ ***********************************************************/
+void ImpostorAtlas::EndBake()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+
+	// the framebuffer is only needed again for a new bake
+	if (m_framebuffer != 0)
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_UNIFORM_BINDING, (GLuint)m_sceneUniformBuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_depthBuffer = 0;
+	}
+	m_bakeLayer = -1;
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing one quad for each
+ *  impostor instance with a single instanced draw.  The
+ *  view and light values come from the scene uniform buffer
+ *  and the materials from the material buffer, so the
+ *  impostors are lit like the objects they stand in for.
+ *  The caller has to make its own shader program current
+ *  again afterwards.
+ ***********************************************************/
+void ImpostorAtlas::Draw(const std::vector<IMPOSTOR_INSTANCE>& instances)
+{
+	if ((m_drawProgram == 0) || (m_impostorCount == 0) || instances.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (instances.size() > m_instanceCapacity)
+	{
+		m_instanceCapacity = instances.size();
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			m_instanceCapacity * sizeof(IMPOSTOR_INSTANCE),
+			NULL,
+			GL_STREAM_DRAW);
+	}
+	glBufferSubData(
+		GL_ARRAY_BUFFER,
+		0,
+		instances.size() * sizeof(IMPOSTOR_INSTANCE),
+		instances.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(m_drawProgram);
+	glBindTextureUnit(COLOR_ATLAS_TEXTURE_UNIT, m_colorAtlas);
+	glBindTextureUnit(NORMAL_ATLAS_TEXTURE_UNIT, m_normalAtlas);
+	glBindVertexArray(m_vao);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances.size());
+	glBindVertexArray(0);
+}
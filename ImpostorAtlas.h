@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.h
+// ============
+// bake objects into an atlas of octahedral views and draw distant copies
+// of them as single quads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneUniformBuffer.h"
+#include "ShaderProgram.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  ImpostorAtlas
+ *
+ *  This class holds a pre-rendered stand-in, an impostor,
+ *  for each distinct object shape in the scene.  Every
+ *  impostor takes one layer of two texture arrays, holding
+ *  the unlit color and the normal of the object as seen
+ *  from a grid of directions spread over the whole sphere
+ *  by an octahedral mapping.  A distant object is then drawn
+ *  as one quad showing the view nearest to the direction of
+ *  the camera, lit per pixel from the baked normals, so it
+ *  still follows the scene lights and its own material.
+ *
+ *  The views are drawn with an offscreen framebuffer by the
+ *  caller's own draw calls, and the finished atlas can be
+ *  written to a cache file and read back on later runs.
+ ***********************************************************/
+class ImpostorAtlas
+{
+public:
+	// constructor
+	ImpostorAtlas();
+	// destructor
+	~ImpostorAtlas();
+
+	// per-instance values of one impostor quad, read by the
+	// impostor vertex shader as instance attributes
+	struct IMPOSTOR_INSTANCE
+	{
+		// world space center of the baked bounds, w the radius
+		glm::vec4 centerRadius;
+		// quaternion turning the baked views into the world
+		glm::vec4 rotation;
+		// atlas layer holding the views of the object
+		GLint layer;
+		// index into the material buffer, or -1 for none
+		GLint materialIndex;
+	};
+
+	// views baked for each impostor, on a square grid, and
+	// the width and height of one view in pixels
+	static const int VIEW_GRID = 8;
+	static const int VIEW_PIXELS = 32;
+
+	// load the shaders that bake and draw the impostors
+	bool Initialize(
+		const char* bakeVertexShaderFile,
+		const char* bakeFragmentShaderFile,
+		const char* drawVertexShaderFile,
+		const char* drawFragmentShaderFile);
+
+	// create the atlas for a number of impostors from a cache
+	// file, false when the file is missing or was written for
+	// a different key, leaving the impostors to be baked
+	bool LoadCache(const char* filename, uint64_t key, int impostorCount);
+	// write the baked atlas to a cache file under a key
+	bool SaveCache(const char* filename, uint64_t key) const;
+
+	// create an empty atlas and switch to the bake program
+	// and framebuffer
+	void BeginBake(int impostorCount);
+	// aim the bake program at one view of an impostor, framing
+	// bounds given in the object's own frame - the caller then
+	// draws the object with the per-draw values at drawIndex
+	void BakeView(int layer, int view, const glm::vec3& center, float radius, int drawIndex);
+	// go back to the default framebuffer and viewport
+	void EndBake();
+
+	// draw a quad for each impostor instance, with the view,
+	// light and sampler values of the program in use
+	void Draw(const std::vector<IMPOSTOR_INSTANCE>& instances);
+
+	// number of impostors held in the atlas
+	int GetImpostorCount() const { return(m_impostorCount); }
+	// bytes of texture memory taken by the atlas
+	size_t GetAtlasBytes() const;
+
+	// direction from the object to the camera that a view of
+	// the grid was baked from, in the object's own frame
+	static glm::vec3 GetViewDirection(int view);
+
+private:
+	// programs that bake and draw the impostors
+	GLuint m_bakeProgram;
+	GLuint m_drawProgram;
+	GLint m_bakeFirstDrawIDLocation;
+	// view values of the bake, read by the scene vertex shader
+	// in place of the camera of the scene
+	SceneUniformBuffer m_bakeSceneUniforms;
+	// scene uniform buffer to bind again once the bake is done
+	GLint m_sceneUniformBuffer;
+
+	// texture arrays with the color and normal views, one
+	// layer per impostor
+	GLuint m_colorAtlas;
+	GLuint m_normalAtlas;
+	int m_impostorCount;
+	// framebuffer and depth buffer the views are baked with
+	GLuint m_framebuffer;
+	GLuint m_depthBuffer;
+	// viewport to go back to once the bake is done
+	GLint m_viewport[4];
+	// layer the framebuffer is drawing into, -1 for none
+	int m_bakeLayer;
+
+	// unit quad drawn once per impostor instance
+	GLuint m_vao;
+	GLuint m_quadBuffer;
+	GLuint m_instanceBuffer;
+	size_t m_instanceCapacity;
+
+	// create the texture arrays for a number of impostors
+	void CreateAtlas(int impostorCount);
+	// create the vertex array for the quad and the
+	// per-instance impostor attributes
+	void CreateVertexArray();
+};
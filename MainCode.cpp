@@ -1,5 +1,6 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -11,8 +12,14 @@
 
 #include "SceneManager.h"
 #include "ViewManager.h"
-#include "ShapeMeshes.h"
+#include "SceneMeshes.h"
 #include "ShaderManager.h"
+#include "UniformCache.h"
+#include "SceneUniformBuffer.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RenderQueue.h"
+#include "DecodedTextureCache.h"
+#include "GpuCulling.h"
 
 // Namespace for declaring global variables
 namespace
@@ -27,14 +34,30 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// uniform cache object for setting shader values by resolved location
+	UniformCache* g_UniformCache = nullptr;
+	// uniform buffer sharing the view and light values with every scene program
+	SceneUniformBuffer* g_SceneUniforms = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// optional rendering path switched on and off every second
+	// so its frame time can be compared with the path it replaces
+	enum COMPARE_PATH
+	{
+		COMPARE_NONE,
+		COMPARE_TESSELLATION,
+		COMPARE_DEPTH_PREPASS
+	};
+	// names of the compared paths, in COMPARE_PATH order
+	const char* const COMPARE_PATH_NAMES[] = { "", "tessellation", "the depth pre-pass" };
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool SetComparedPath(COMPARE_PATH comparePath, bool bEnable);
 
 
 /***********************************************************
@@ -45,6 +68,74 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// time the scene object hierarchy at increasing object
+	// counts instead of running the scene
+	if ((argc > 1) && (strcmp(argv[1], "--bvh-benchmark") == 0))
+	{
+		BoundingVolumeHierarchy::RunBenchmark(1000);
+		BoundingVolumeHierarchy::RunBenchmark(100000);
+		BoundingVolumeHierarchy::RunBenchmark(1000000);
+		return(EXIT_SUCCESS);
+	}
+
+	// check the draw order of the render queue instead of
+	// running the scene
+	if ((argc > 1) && (strcmp(argv[1], "--render-queue-check") == 0))
+	{
+		if (RenderQueue::RunOrderCheck() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// check that the decoded texture cache gives back what was
+	// written to it instead of running the scene
+	if ((argc > 1) && (strcmp(argv[1], "--texture-cache-check") == 0))
+	{
+		if (DecodedTextureCache::RunRoundTripCheck() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// check the GPU culling compute shaders against the results
+	// worked out on the CPU instead of running the scene, in a
+	// hidden window asking only for OpenGL 4.5 so that software
+	// drivers such as Mesa llvmpipe can run it
+	if ((argc > 1) && (strcmp(argv[1], "--gpu-culling-check") == 0))
+	{
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+		g_Window = glfwCreateWindow(256, 256, WINDOW_TITLE, NULL, NULL);
+		if (g_Window == NULL)
+		{
+			std::cout << "ERROR: GPU culling check could not create an OpenGL 4.5 context" << std::endl;
+			glfwTerminate();
+			return(EXIT_FAILURE);
+		}
+		glfwMakeContextCurrent(g_Window);
+
+		bool bPassed = false;
+		if (InitializeGLEW() == true)
+		{
+			if (GpuCulling::IsSupported() == false)
+			{
+				std::cout << "ERROR: GPU culling check needs OpenGL 4.5" << std::endl;
+			}
+			else
+			{
+				bPassed = GpuCulling::RunCullCheck();
+			}
+		}
+		glfwTerminate();
+		return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -68,14 +159,127 @@ int main(int argc, char* argv[])
 
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"../../../Utilities/shaders/vertexShader.glsl",
-		"../../../Utilities/shaders/fragmentShader.glsl");
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
 
+	// resolve the shader uniform locations once the program is linked
+	g_UniformCache = new UniformCache();
+	g_UniformCache->Initialize();
+
+	// share the view and light values with every program that
+	// draws the scene through one uniform buffer
+	g_SceneUniforms = new SceneUniformBuffer();
+	g_SceneUniforms->Initialize();
+	g_SceneUniforms->Bind();
+	g_ViewManager->SetSceneUniforms(g_SceneUniforms);
+
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_UniformCache, g_SceneUniforms);
+
+	// the switches that change how the scene is loaded have to
+	// be applied before it is prepared
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--uncompressed-textures") == 0)
+		{
+			g_SceneManager->SetCompressedTextures(false);
+		}
+	}
 	g_SceneManager->PrepareScene();
 
+	// turn on the optional rendering paths asked for
+	bool bRenderStats = false;
+	bool bTextureBenchmark = false;
+	// every how many objects one is turned each frame, 0 for none
+	int spinStride = 0;
+	COMPARE_PATH comparePath = COMPARE_NONE;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--occlusion-culling") == 0)
+		{
+			g_SceneManager->SetOcclusionCulling(true);
+		}
+		else if (strcmp(argv[i], "--gpu-culling") == 0)
+		{
+			g_SceneManager->SetGpuCulling(true);
+		}
+		else if (strcmp(argv[i], "--tessellation") == 0)
+		{
+			g_SceneManager->SetTessellatedMeshes(true);
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			g_SceneManager->SetDepthPrepass(true);
+		}
+		else if (strcmp(argv[i], "--oit") == 0)
+		{
+			g_SceneManager->SetWeightedBlendedOit(true);
+		}
+		else if (strcmp(argv[i], "--impostors") == 0)
+		{
+			g_SceneManager->SetImpostors(true);
+		}
+		else if ((strcmp(argv[i], "--impostor-radius") == 0) && (i + 1 < argc))
+		{
+			i++;
+			g_SceneManager->SetImpostorPixelRadius((float)atof(argv[i]));
+		}
+		else if ((strcmp(argv[i], "--anisotropy") == 0) && (i + 1 < argc))
+		{
+			i++;
+			g_SceneManager->SetTextureAnisotropy((float)atof(argv[i]));
+		}
+		else if ((strcmp(argv[i], "--spin-objects") == 0) && (i + 1 < argc))
+		{
+			i++;
+			spinStride = atoi(argv[i]);
+		}
+		else if (strcmp(argv[i], "--compare-tessellation") == 0)
+		{
+			comparePath = COMPARE_TESSELLATION;
+		}
+		else if (strcmp(argv[i], "--compare-depth-prepass") == 0)
+		{
+			comparePath = COMPARE_DEPTH_PREPASS;
+		}
+		else if (strcmp(argv[i], "--render-stats") == 0)
+		{
+			bRenderStats = true;
+		}
+		else if (strcmp(argv[i], "--texture-benchmark") == 0)
+		{
+			bTextureBenchmark = true;
+		}
+	}
+
+	// time the texture filtering modes once the other switches
+	// are applied, then close instead of running the scene
+	if (bTextureBenchmark == true)
+	{
+		g_SceneManager->RunTextureBenchmark();
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+
+	// the compared path starts switched on, and the time of each
+	// one second window is added to the totals of the mode it ran
+	bool bCompareEnabled = true;
+	int compareWindows = 0;
+	int compareCount[2] = { 0, 0 };
+	double compareFrameMilliseconds[2] = { 0.0, 0.0 };
+	double compareGpuMilliseconds[2] = { 0.0, 0.0 };
+	if ((comparePath != COMPARE_NONE) &&
+		(SetComparedPath(comparePath, bCompareEnabled) == false))
+	{
+		std::cout << "WARNING: " << COMPARE_PATH_NAMES[comparePath] << " could not be switched on, nothing to compare" << std::endl;
+		comparePath = COMPARE_NONE;
+	}
+
+	// frames rendered since the render stats were last printed
+	int statsFrames = 0;
+	double statsStartTime = glfwGetTime();
+	double lastFrameTime = statsStartTime;
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
@@ -87,12 +291,79 @@ int main(int argc, char* argv[])
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// start counting the shader state calls for this frame
+		g_UniformCache->ResetFrameCounters();
+
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewProjection(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix());
+
+		// turn the objects asked for at 90 degrees a second,
+		// which rebuilds only their model matrices
+		double frameTime = glfwGetTime();
+		g_SceneManager->SpinObjects(spinStride, (float)(90.0 * (frameTime - lastFrameTime)));
+		lastFrameTime = frameTime;
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		// print the frame rate and the counters of the latest
+		// frame once a second, for comparing rendering paths
+		statsFrames++;
+		double statsTime = glfwGetTime() - statsStartTime;
+		if ((bRenderStats == true) && (statsTime >= 1.0))
+		{
+			const SceneManager::RENDER_STATS& stats = g_SceneManager->GetRenderStats();
+			std::cout << "INFO: " << (1000.0 * statsTime / statsFrames) << " ms per frame, "
+				<< stats.depthPrepassGpuMilliseconds << " ms GPU depth pre-pass, "
+				<< stats.sceneGpuMilliseconds << " ms GPU scene, "
+				<< stats.trianglesDrawn << " triangles, "
+				<< stats.drawCalls << " draw calls, "
+				<< stats.drawCommands << " commands, "
+				<< stats.impostorsDrawn << " impostors" << std::endl;
+			std::cout << "INFO: " << stats.visibleObjects << " objects visible, "
+				<< stats.culledObjects << " culled by the frustum, "
+				<< stats.occludedObjects << " occluded" << std::endl;
+			std::cout << "INFO: " << stats.stateCallsIssued << " uniform and texture calls issued, "
+				<< stats.stateCallsSkipped << " skipped as redundant, "
+				<< stats.stateChangesSaved << " program, texture and mesh switches saved by sorting, "
+				<< stats.transformsRebuilt << " model matrices rebuilt" << std::endl;
+		}
+		if ((comparePath != COMPARE_NONE) && (statsTime >= 1.0))
+		{
+			// the GPU timers lag a frame or two, so only the latest
+			// frame of the window is read, and the first window of
+			// each mode is left out while the programs warm up
+			const SceneManager::RENDER_STATS& stats = g_SceneManager->GetRenderStats();
+			int mode = (bCompareEnabled == true) ? 1 : 0;
+			if (compareWindows >= 2)
+			{
+				compareCount[mode]++;
+				compareFrameMilliseconds[mode] += 1000.0 * statsTime / statsFrames;
+				compareGpuMilliseconds[mode] += stats.depthPrepassGpuMilliseconds + stats.sceneGpuMilliseconds;
+			}
+			compareWindows++;
+
+			// print the averages after every window without the path
+			if ((mode == 0) && (compareCount[0] > 0) && (compareCount[1] > 0))
+			{
+				std::cout << "INFO: compared over " << compareCount[0] << " seconds each, "
+					<< (compareFrameMilliseconds[1] / compareCount[1]) << " ms per frame and "
+					<< (compareGpuMilliseconds[1] / compareCount[1]) << " ms GPU with " << COMPARE_PATH_NAMES[comparePath] << ", "
+					<< (compareFrameMilliseconds[0] / compareCount[0]) << " ms per frame and "
+					<< (compareGpuMilliseconds[0] / compareCount[0]) << " ms GPU without" << std::endl;
+			}
+
+			bCompareEnabled = !bCompareEnabled;
+			SetComparedPath(comparePath, bCompareEnabled);
+		}
+		if (statsTime >= 1.0)
+		{
+			statsFrames = 0;
+			statsStartTime = glfwGetTime();
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
@@ -112,6 +383,16 @@ int main(int argc, char* argv[])
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_SceneUniforms)
+	{
+		delete g_SceneUniforms;
+		g_SceneUniforms = NULL;
+	}
+	if (NULL != g_UniformCache)
+	{
+		delete g_UniformCache;
+		g_UniformCache = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
@@ -174,4 +455,25 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  SetComparedPath()
+ *
+ *  This function is used to switch the rendering path being
+ *  compared on or off, and returns whether it is now on.
+ ***********************************************************/
+bool SetComparedPath(COMPARE_PATH comparePath, bool bEnable)
+{
+	switch (comparePath)
+	{
+	case COMPARE_TESSELLATION:
+		g_SceneManager->SetTessellatedMeshes(bEnable);
+		return(g_SceneManager->IsTessellating());
+	case COMPARE_DEPTH_PREPASS:
+		g_SceneManager->SetDepthPrepass(bEnable);
+		return(g_SceneManager->IsDepthPrepassing());
+	default:
+		return(false);
+	}
+}
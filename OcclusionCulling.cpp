@@ -0,0 +1,396 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculling.cpp
+// ============
+// hardware occlusion queries against proxy bounding boxes
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCulling.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_ViewProjectionName = "viewProjection";
+
+	// vertex attribute locations used by the proxy shaders
+	const GLuint POSITION_ATTRIBUTE = 0;
+	const GLuint PROXY_MIN_ATTRIBUTE = 1;
+	const GLuint PROXY_MAX_ATTRIBUTE = 2;
+
+	// frames a visible object goes untested, the test of each
+	// object is offset by its index within this period
+	const int VISIBLE_RETEST_FRAMES = 8;
+	// the proxy boxes are grown by this much so that they are
+	// not hidden by the faces of the object they enclose
+	const float PROXY_MARGIN = 0.01f;
+	// a camera this close to a box may have the near plane clip
+	// away the faces in front of it, so it is never tested -
+	// the distance of the near plane used by the view manager
+	const float NEAR_PLANE_MARGIN = 0.1f;
+
+	// corners of the unit cube, scaled to each proxy box by
+	// the vertex shader
+	const GLfloat CUBE_VERTICES[] =
+	{
+		0.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 0.0f,
+		1.0f, 1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 1.0f,
+		1.0f, 1.0f, 1.0f,
+		0.0f, 1.0f, 1.0f
+	};
+
+	// two triangles for each face of the unit cube
+	const GLuint CUBE_INDICES[] =
+	{
+		0, 2, 1,  0, 3, 2,    // back
+		4, 5, 6,  4, 6, 7,    // front
+		0, 4, 7,  0, 7, 3,    // left
+		1, 2, 6,  1, 6, 5,    // right
+		0, 1, 5,  0, 5, 4,    // bottom
+		3, 7, 6,  3, 6, 2     // top
+	};
+	const GLsizei CUBE_INDEX_COUNT = sizeof(CUBE_INDICES) / sizeof(CUBE_INDICES[0]);
+}
+
+/***********************************************************
+ *  OcclusionCulling()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCulling::OcclusionCulling()
+{
+	m_pProxyShader = NULL;
+	m_viewProjectionLocation = -1;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_proxyBuffer = 0;
+	m_proxyCapacity = 0;
+	m_cameraPosition = glm::vec3(0.0f);
+	m_frame = 0;
+	m_queriesIssued = 0;
+}
+
+/***********************************************************
+ *  ~OcclusionCulling()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCulling::~OcclusionCulling()
+{
+	Resize(0);
+
+	if (NULL != m_pProxyShader)
+	{
+		delete m_pProxyShader;
+		m_pProxyShader = NULL;
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+		m_vertexBuffer = 0;
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_indexBuffer = 0;
+	}
+	if (m_proxyBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_proxyBuffer);
+		m_proxyBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the shaders that draw the
+ *  proxy boxes and creating the unit cube they are drawn from.
+ ***********************************************************/
+bool OcclusionCulling::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (NULL == m_pProxyShader)
+	{
+		m_pProxyShader = new ShaderManager();
+		GLuint programID = m_pProxyShader->LoadShaders(vertexShaderFile, fragmentShaderFile);
+		// resolve the location once instead of looking it up by
+		// name every time the proxy boxes are drawn
+		m_viewProjectionLocation = glGetUniformLocation(programID, g_ViewProjectionName);
+	}
+
+	if (m_vao == 0)
+	{
+		CreateVertexArray();
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateVertexArray()
+ *
+ *  This method is used for creating the vertex array object
+ *  for the unit cube, with the corners of each proxy box read
+ *  as instance attributes so every box is drawn from the same
+ *  eight vertices.
+ ***********************************************************/
+void OcclusionCulling::CreateVertexArray()
+{
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vertexBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+	glGenBuffers(1, &m_proxyBuffer);
+
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+	glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+	glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CUBE_INDICES), CUBE_INDICES, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_proxyBuffer);
+	glVertexAttribPointer(
+		PROXY_MIN_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE,
+		sizeof(PROXY_BOX), (void*)offsetof(PROXY_BOX, aabbMin));
+	glEnableVertexAttribArray(PROXY_MIN_ATTRIBUTE);
+	glVertexAttribDivisor(PROXY_MIN_ATTRIBUTE, 1);
+	glVertexAttribPointer(
+		PROXY_MAX_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE,
+		sizeof(PROXY_BOX), (void*)offsetof(PROXY_BOX, aabbMax));
+	glEnableVertexAttribArray(PROXY_MAX_ATTRIBUTE);
+	glVertexAttribDivisor(PROXY_MAX_ATTRIBUTE, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for sizing the query state to match
+ *  the render list.  Every entry starts out visible, so it
+ *  is drawn until a finished test says otherwise.
+ ***********************************************************/
+void OcclusionCulling::Resize(int objectCount)
+{
+	for (OBJECT_QUERY& objectQuery : m_objectQueries)
+	{
+		if (objectQuery.queryID != 0)
+		{
+			glDeleteQueries(1, &objectQuery.queryID);
+		}
+	}
+	m_objectQueries.clear();
+
+	OBJECT_QUERY objectQuery;
+	objectQuery.queryID = 0;
+	objectQuery.bPending = false;
+	objectQuery.bOccluded = false;
+	objectQuery.nextTestFrame = 0;
+	objectQuery.lastCandidateFrame = -1;
+	m_objectQueries.resize(objectCount, objectQuery);
+
+	m_queuedObjects.clear();
+	m_proxyBoxes.clear();
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  Any query
+ *  whose result is available is read back, and any that is
+ *  not is left for a later frame rather than waited on.
+ ***********************************************************/
+void OcclusionCulling::BeginFrame(const glm::vec3& cameraPosition)
+{
+	m_frame++;
+	m_cameraPosition = cameraPosition;
+	m_queuedObjects.clear();
+	m_proxyBoxes.clear();
+
+	for (OBJECT_QUERY& objectQuery : m_objectQueries)
+	{
+		if (objectQuery.bPending == false)
+		{
+			continue;
+		}
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(objectQuery.queryID, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+		{
+			continue;
+		}
+
+		GLuint anySamplesPassed = GL_FALSE;
+		glGetQueryObjectuiv(objectQuery.queryID, GL_QUERY_RESULT, &anySamplesPassed);
+		objectQuery.bOccluded = (anySamplesPassed == GL_FALSE);
+		objectQuery.bPending = false;
+	}
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether an object can
+ *  be skipped this frame.  A result is only trusted when the
+ *  object was inside the view frustum last frame too, since
+ *  an object coming back into view was not tested against
+ *  what is in front of it now.
+ ***********************************************************/
+bool OcclusionCulling::IsOccluded(int objectIndex) const
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objectQueries.size()))
+	{
+		return(false);
+	}
+
+	const OBJECT_QUERY& objectQuery = m_objectQueries[objectIndex];
+
+	return((objectQuery.bOccluded == true) &&
+		(objectQuery.lastCandidateFrame == m_frame - 1));
+}
+
+/***********************************************************
+ *  QueueTest()
+ *
+ *  This method is used for deciding whether an object inside
+ *  the view frustum is tested this frame.  Occluded objects
+ *  are tested every frame, and visible objects every few
+ *  frames.  An object with a test still in flight, or with
+ *  the camera inside its box, is not tested.
+ ***********************************************************/
+void OcclusionCulling::QueueTest(int objectIndex, const BOUNDING_VOLUME& bounds)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objectQueries.size()))
+	{
+		return;
+	}
+
+	OBJECT_QUERY& objectQuery = m_objectQueries[objectIndex];
+	bool bReturning = (objectQuery.lastCandidateFrame != m_frame - 1);
+	objectQuery.lastCandidateFrame = m_frame;
+
+	if (objectQuery.bPending == true)
+	{
+		return;
+	}
+
+	// the faces of the box in front of the camera would be
+	// clipped away, so the object has to be drawn regardless
+	glm::vec3 nearMin = bounds.aabbMin - glm::vec3(NEAR_PLANE_MARGIN);
+	glm::vec3 nearMax = bounds.aabbMax + glm::vec3(NEAR_PLANE_MARGIN);
+	if ((m_cameraPosition.x >= nearMin.x) && (m_cameraPosition.x <= nearMax.x) &&
+		(m_cameraPosition.y >= nearMin.y) && (m_cameraPosition.y <= nearMax.y) &&
+		(m_cameraPosition.z >= nearMin.z) && (m_cameraPosition.z <= nearMax.z))
+	{
+		objectQuery.bOccluded = false;
+		objectQuery.nextTestFrame = m_frame + 1;
+		return;
+	}
+
+	if ((objectQuery.bOccluded == false) &&
+		(bReturning == false) &&
+		(m_frame < objectQuery.nextTestFrame))
+	{
+		return;
+	}
+
+	objectQuery.nextTestFrame = m_frame + VISIBLE_RETEST_FRAMES -
+		(m_frame + objectIndex) % VISIBLE_RETEST_FRAMES;
+
+	PROXY_BOX proxyBox;
+	proxyBox.aabbMin = bounds.aabbMin - glm::vec3(PROXY_MARGIN);
+	proxyBox.aabbMax = bounds.aabbMax + glm::vec3(PROXY_MARGIN);
+	m_queuedObjects.push_back(objectIndex);
+	m_proxyBoxes.push_back(proxyBox);
+}
+
+/***********************************************************
+ *  IssueQueries()
+ *
+ *  This method is used for drawing the proxy box of every
+ *  queued test inside its own occlusion query.  It is called
+ *  after the scene has been drawn, so the depth buffer holds
+ *  every occluder of the frame.  The boxes write no color and
+ *  no depth, and the caller has to make its own shader
+ *  program current again afterwards.
+ ***********************************************************/
+void OcclusionCulling::IssueQueries(const glm::mat4& viewProjection)
+{
+	m_queriesIssued = 0;
+
+	if ((m_vao == 0) || (NULL == m_pProxyShader) || m_queuedObjects.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_proxyBuffer);
+	if (m_proxyBoxes.size() > m_proxyCapacity)
+	{
+		m_proxyCapacity = m_proxyBoxes.size();
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			m_proxyCapacity * sizeof(PROXY_BOX),
+			NULL,
+			GL_STREAM_DRAW);
+	}
+	glBufferSubData(
+		GL_ARRAY_BUFFER,
+		0,
+		m_proxyBoxes.size() * sizeof(PROXY_BOX),
+		m_proxyBoxes.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_pProxyShader->use();
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glBindVertexArray(m_vao);
+
+	for (size_t i = 0; i < m_queuedObjects.size(); i++)
+	{
+		OBJECT_QUERY& objectQuery = m_objectQueries[m_queuedObjects[i]];
+		if (objectQuery.queryID == 0)
+		{
+			glGenQueries(1, &objectQuery.queryID);
+		}
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, objectQuery.queryID);
+		glDrawElementsInstancedBaseInstance(
+			GL_TRIANGLES,
+			CUBE_INDEX_COUNT,
+			GL_UNSIGNED_INT,
+			(void*)0,
+			1,
+			(GLuint)i);
+		glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+
+		objectQuery.bPending = true;
+		m_queriesIssued++;
+	}
+
+	glBindVertexArray(0);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
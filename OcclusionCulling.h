@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculling.h
+// ============
+// hardware occlusion queries against proxy bounding boxes
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolume.h"
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCulling
+ *
+ *  This class tests scene objects for occlusion by drawing
+ *  their bounding boxes against the depth buffer of the frame
+ *  with an occlusion query each.  The results are read back a
+ *  frame later, and only once they are available, so the CPU
+ *  never waits on the GPU.  An object whose last finished test
+ *  found no visible samples is skipped until a later test
+ *  finds it visible again.
+ *
+ *  To keep the number of queries down, the results are
+ *  assumed to stay the same from one frame to the next:
+ *  visible objects are only tested again every few frames,
+ *  staggered so they do not all come due together, while
+ *  occluded objects are tested every frame so they reappear
+ *  as soon as possible.
+ ***********************************************************/
+class OcclusionCulling
+{
+public:
+	// constructor
+	OcclusionCulling();
+	// destructor
+	~OcclusionCulling();
+
+	// create the proxy box geometry and load the proxy shaders
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// size the per-object query state for a render list
+	void Resize(int objectCount);
+
+	// start a new frame, reading back the query results that
+	// have arrived since the last frame without waiting
+	void BeginFrame(const glm::vec3& cameraPosition);
+	// true when an object failed its last finished test and
+	// was inside the view frustum last frame as well
+	bool IsOccluded(int objectIndex) const;
+	// consider an object inside the view frustum for a test
+	// this frame, queued only when one is due
+	void QueueTest(int objectIndex, const BOUNDING_VOLUME& bounds);
+	// draw the proxy box of every queued test against the
+	// depth buffer of the frame, one query each
+	void IssueQueries(const glm::mat4& viewProjection);
+
+	// queries issued by the last call to IssueQueries()
+	int GetQueriesIssued() const { return(m_queriesIssued); }
+
+private:
+	// query state of one render list entry
+	struct OBJECT_QUERY
+	{
+		GLuint queryID;
+		// a query was issued and its result has not been read
+		bool bPending;
+		// the last finished test found no visible samples
+		bool bOccluded;
+		// first frame a visible object is tested again
+		int nextTestFrame;
+		// last frame the object was inside the view frustum
+		int lastCandidateFrame;
+	};
+
+	// proxy box drawn for one queued test, read by the proxy
+	// vertex shader as instance attributes
+	struct PROXY_BOX
+	{
+		glm::vec3 aabbMin;
+		glm::vec3 aabbMax;
+	};
+
+	// query state indexed like the render list
+	std::vector<OBJECT_QUERY> m_objectQueries;
+	// tests queued for this frame and their proxy boxes
+	std::vector<int> m_queuedObjects;
+	std::vector<PROXY_BOX> m_proxyBoxes;
+	// shaders that only transform the proxy boxes
+	ShaderManager* m_pProxyShader;
+	GLint m_viewProjectionLocation;
+	// unit cube drawn once per proxy box
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLuint m_proxyBuffer;
+	size_t m_proxyCapacity;
+	// camera position of the frame being tested
+	glm::vec3 m_cameraPosition;
+	// number of the frame being rendered
+	int m_frame;
+	int m_queriesIssued;
+
+	// create the vertex array for the unit cube and the
+	// per-instance proxy box attributes
+	void CreateVertexArray();
+};
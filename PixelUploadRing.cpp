@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+// pixeluploadring.cpp
+// ============
+// stream texture images to the GPU through a persistently mapped pixel
+// buffer, recycling its slots with fences
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PixelUploadRing.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// longest wait for one fence when the caller has to have a
+	// slot, in nanoseconds
+	const GLuint64 FENCE_WAIT_NANOSECONDS = 1000000000;
+}
+
+/***********************************************************
+ *  PixelUploadRing()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PixelUploadRing::PixelUploadRing()
+{
+	m_buffer = 0;
+	m_pMapped = NULL;
+	m_slotBytes = 0;
+	m_slotCount = 0;
+	for (int i = 0; i < MAX_SLOTS; i++)
+	{
+		m_fences[i] = 0;
+	}
+	m_nextSlot = 0;
+}
+
+/***********************************************************
+ *  ~PixelUploadRing()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PixelUploadRing::~PixelUploadRing()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the pixel buffer with
+ *  immutable storage and mapping it for writing once.  The
+ *  mapping is coherent, so an image written into a slot is
+ *  seen by the GPU without flushing the range.
+ ***********************************************************/
+bool PixelUploadRing::Initialize(size_t slotBytes, int slotCount)
+{
+	Destroy();
+
+	// buffer storage and the named buffer calls are core
+	// from 4.4 and 4.5
+	if (GLEW_VERSION_4_5 == false)
+	{
+		return(false);
+	}
+	if ((slotBytes == 0) || (slotCount <= 0))
+	{
+		return(false);
+	}
+	if (slotCount > MAX_SLOTS)
+	{
+		slotCount = MAX_SLOTS;
+	}
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferStorage(m_buffer, (GLsizeiptr)(slotBytes * slotCount), NULL, flags);
+	m_pMapped = (unsigned char*)glMapNamedBufferRange(m_buffer, 0, (GLsizeiptr)(slotBytes * slotCount), flags);
+	if (NULL == m_pMapped)
+	{
+		std::cout << "WARNING: the pixel upload buffer could not be mapped" << std::endl;
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		return(false);
+	}
+
+	m_slotBytes = slotBytes;
+	m_slotCount = slotCount;
+	m_nextSlot = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting on the uploads still in
+ *  flight and then unmapping and deleting the buffer.
+ ***********************************************************/
+void PixelUploadRing::Destroy()
+{
+	for (int i = 0; i < MAX_SLOTS; i++)
+	{
+		if (m_fences[i] != 0)
+		{
+			glClientWaitSync(m_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_NANOSECONDS);
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = 0;
+		}
+	}
+
+	if (m_buffer != 0)
+	{
+		glUnmapNamedBuffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_pMapped = NULL;
+	m_slotBytes = 0;
+	m_slotCount = 0;
+}
+
+/***********************************************************
+ *  AcquireSlot()
+ *
+ *  This method is used for finding a slot the GPU is done
+ *  reading from, trying them in ring order.  Fences are only
+ *  polled, unless bWait is set and every slot is busy, in
+ *  which case the oldest upload is waited on.
+ ***********************************************************/
+int PixelUploadRing::AcquireSlot(size_t bytes, bool bWait)
+{
+	if ((m_buffer == 0) || (bytes > m_slotBytes))
+	{
+		return(-1);
+	}
+
+	for (int i = 0; i < m_slotCount; i++)
+	{
+		int slot = (m_nextSlot + i) % m_slotCount;
+		if (m_fences[slot] != 0)
+		{
+			GLenum result = glClientWaitSync(m_fences[slot], 0, 0);
+			if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+			{
+				continue;
+			}
+			glDeleteSync(m_fences[slot]);
+			m_fences[slot] = 0;
+		}
+
+		m_nextSlot = (slot + 1) % m_slotCount;
+		return(slot);
+	}
+
+	if (bWait == false)
+	{
+		return(-1);
+	}
+
+	// the next slot in ring order holds the oldest upload
+	int slot = m_nextSlot;
+	GLenum result = glClientWaitSync(m_fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_NANOSECONDS);
+	if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+	{
+		return(-1);
+	}
+	glDeleteSync(m_fences[slot]);
+	m_fences[slot] = 0;
+	m_nextSlot = (slot + 1) % m_slotCount;
+
+	return(slot);
+}
+
+/***********************************************************
+ *  GetSlotPointer()
+ *
+ *  This method is used for getting the mapped memory of a
+ *  slot returned by AcquireSlot().
+ ***********************************************************/
+void* PixelUploadRing::GetSlotPointer(int slot) const
+{
+	if ((NULL == m_pMapped) || (slot < 0) || (slot >= m_slotCount))
+	{
+		return(NULL);
+	}
+
+	return(m_pMapped + (m_slotBytes * slot));
+}
+
+/***********************************************************
+ *  GetSlotOffset()
+ *
+ *  This method is used for getting the buffer offset of a
+ *  slot, to pass to the texture upload while the buffer is
+ *  bound as the pixel unpack buffer.
+ ***********************************************************/
+GLintptr PixelUploadRing::GetSlotOffset(int slot) const
+{
+	return((GLintptr)(m_slotBytes * slot));
+}
+
+/***********************************************************
+ *  ReleaseSlot()
+ *
+ *  This method is used for placing a fence after the uploads
+ *  that read from a slot, so it is not written again until
+ *  the GPU has finished copying out of it.
+ ***********************************************************/
+void PixelUploadRing::ReleaseSlot(int slot)
+{
+	if ((slot < 0) || (slot >= m_slotCount))
+	{
+		return;
+	}
+
+	if (m_fences[slot] != 0)
+	{
+		glDeleteSync(m_fences[slot]);
+	}
+	m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the buffer as the source
+ *  of the pixel uploads that follow.
+ ***********************************************************/
+void PixelUploadRing::Bind() const
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+}
+
+/***********************************************************
+ *  Unbind()
+ *
+ *  This method is used for going back to uploading pixels
+ *  from client memory.
+ ***********************************************************/
+void PixelUploadRing::Unbind() const
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// pixeluploadring.h
+// ============
+// stream texture images to the GPU through a persistently mapped pixel
+// buffer, recycling its slots with fences
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  PixelUploadRing
+ *
+ *  This class holds one pixel unpack buffer split into a
+ *  small ring of equal slots, mapped once for the life of
+ *  the buffer.  An image is written straight into a free
+ *  slot and the texture is filled from the buffer offset,
+ *  so the driver copies it on the GPU timeline instead of
+ *  making its own copy of the pixels during the call.  A
+ *  fence placed after the upload marks when the slot can be
+ *  written again, and a slot whose fence has not signalled
+ *  is never handed out, so the CPU does not wait on the GPU
+ *  unless the caller asks it to.
+ ***********************************************************/
+class PixelUploadRing
+{
+public:
+	// constructor
+	PixelUploadRing();
+	// destructor
+	~PixelUploadRing();
+
+	// create the buffer with a number of slots that each
+	// hold up to slotBytes, false when persistent mapping is
+	// not supported and images have to be uploaded directly
+	bool Initialize(size_t slotBytes, int slotCount);
+	// wait for the uploads in flight and free the buffer
+	void Destroy();
+
+	// get a slot for an image of the given size, -1 when the
+	// image does not fit a slot, or when every slot is still
+	// in use and bWait is false
+	int AcquireSlot(size_t bytes, bool bWait);
+	// mapped memory of a slot, for the image to be written to
+	void* GetSlotPointer(int slot) const;
+	// offset of a slot in the buffer, passed to the texture
+	// upload in place of the pixel pointer
+	GLintptr GetSlotOffset(int slot) const;
+	// place the fence for a slot after its uploads were issued
+	void ReleaseSlot(int slot);
+
+	// bind and unbind the buffer as the pixel unpack buffer
+	void Bind() const;
+	void Unbind() const;
+
+	bool IsInitialized() const { return(m_buffer != 0); }
+	size_t GetSlotBytes() const { return(m_slotBytes); }
+
+private:
+	// most slots a ring is created with
+	static const int MAX_SLOTS = 8;
+
+	GLuint m_buffer;
+	// start of the persistently mapped buffer
+	unsigned char* m_pMapped;
+	size_t m_slotBytes;
+	int m_slotCount;
+	// fence for the last upload from each slot, 0 when free
+	GLsync m_fences[MAX_SLOTS];
+	// slot tried first by the next acquire
+	int m_nextSlot;
+};
@@ -0,0 +1,362 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// order the draws of a frame by a packed state sort key
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const int TRANSLUCENT_SHIFT = 63;
+	const int PROGRAM_SHIFT = 56;
+	const int TEXTURE_SHIFT = 48;
+	const int MESH_SHIFT = 43;
+	const int MATERIAL_SHIFT = 32;
+
+	// translucent keys keep the view depth right under the
+	// translucent bit and the state fields below the depth
+	const int TRANSLUCENT_DEPTH_SHIFT = 31;
+	const int TRANSLUCENT_STATE_SHIFT = 32;
+
+	const uint64_t PROGRAM_MASK = 0x7F;
+	const uint64_t TEXTURE_MASK = 0xFF;
+	const uint64_t MESH_MASK = 0x1F;
+	const uint64_t MATERIAL_MASK = 0x7FF;
+	// the opaque depth buckets double in size from one unit
+	const int OPAQUE_DEPTH_BUCKETS = 16;
+
+	// one bit per field that costs a state change to switch, the
+	// material is read per instance so switching it costs nothing
+	const uint64_t PROGRAM_FIELD = PROGRAM_MASK << PROGRAM_SHIFT;
+	const uint64_t TEXTURE_FIELD = TEXTURE_MASK << TEXTURE_SHIFT;
+	const uint64_t MESH_FIELD = MESH_MASK << MESH_SHIFT;
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_bResorted = false;
+	m_stateChangesSaved = 0;
+}
+
+/***********************************************************
+ *  ~RenderQueue()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderQueue::~RenderQueue()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for packing the state of a draw into
+ *  a 64-bit sort key.  A texture slot or material index of
+ *  -1 (none) sorts ahead of all the others.  Translucent
+ *  draws keep their exact depth, opaque draws only the
+ *  bucket it falls in.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(
+	bool bTranslucent,
+	int programIndex,
+	int textureSlot,
+	int materialIndex,
+	int meshIndex,
+	float viewDepth)
+{
+	uint64_t sortKey = 0;
+	uint32_t depthBits = 0;
+
+	// the bits of a non-negative float sort in the same order
+	// as its value, so the depth does not need quantizing
+	if (viewDepth < 0.0f)
+	{
+		viewDepth = 0.0f;
+	}
+	memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+
+	sortKey |= ((uint64_t)programIndex & PROGRAM_MASK) << PROGRAM_SHIFT;
+	sortKey |= ((uint64_t)(textureSlot + 1) & TEXTURE_MASK) << TEXTURE_SHIFT;
+	sortKey |= ((uint64_t)meshIndex & MESH_MASK) << MESH_SHIFT;
+	sortKey |= ((uint64_t)(materialIndex + 1) & MATERIAL_MASK) << MATERIAL_SHIFT;
+
+	// translucent draws blend over what is behind them, so they
+	// are drawn from the back to the front across the whole scene
+	// and the state only breaks ties between equal depths
+	if (bTranslucent)
+	{
+		sortKey >>= TRANSLUCENT_STATE_SHIFT;
+		sortKey |= (uint64_t)(~depthBits) << TRANSLUCENT_DEPTH_SHIFT;
+		sortKey |= (uint64_t)1 << TRANSLUCENT_SHIFT;
+	}
+	else
+	{
+		// the exponent of 1 + depth is its base 2 logarithm,
+		// rounded down
+		uint32_t bucketBits = 0;
+		float bucketDepth = viewDepth + 1.0f;
+		memcpy(&bucketBits, &bucketDepth, sizeof(bucketBits));
+		int bucket = (int)(bucketBits >> 23) - 127;
+		if (bucket >= OPAQUE_DEPTH_BUCKETS)
+		{
+			bucket = OPAQUE_DEPTH_BUCKETS - 1;
+		}
+		sortKey |= (uint64_t)bucket;
+	}
+
+	return(sortKey);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the submitted draws
+ *  before the draws of a new frame are submitted.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_submitted.clear();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for adding a draw to the queue.
+ ***********************************************************/
+void RenderQueue::Submit(uint64_t sortKey, int objectIndex)
+{
+	QUEUE_ENTRY entry;
+	entry.sortKey = sortKey;
+	entry.objectIndex = objectIndex;
+	m_submitted.push_back(entry);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the submitted draws by
+ *  their keys with a least significant digit radix sort,
+ *  eight bits per pass.  Passes where every key has the same
+ *  digit are skipped, and when the submitted draws match the
+ *  last sorted draws the previous order is kept as it is.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	m_bResorted = false;
+
+	if ((m_submitted.size() == m_lastSubmitted.size()) &&
+		(m_submitted.size() == m_sorted.size()))
+	{
+		bool bChanged = false;
+		for (size_t i = 0; (i < m_submitted.size()) && (bChanged == false); i++)
+		{
+			bChanged = (m_submitted[i].sortKey != m_lastSubmitted[i].sortKey) ||
+				(m_submitted[i].objectIndex != m_lastSubmitted[i].objectIndex);
+		}
+
+		if (bChanged == false)
+		{
+			return;
+		}
+	}
+
+	m_lastSubmitted = m_submitted;
+	m_sorted = m_submitted;
+	m_scratch.resize(m_sorted.size());
+
+	if (m_sorted.empty())
+	{
+		m_stateChangesSaved = 0;
+		m_bResorted = true;
+		return;
+	}
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256];
+		memset(counts, 0, sizeof(counts));
+
+		for (const QUEUE_ENTRY& entry : m_sorted)
+		{
+			counts[(entry.sortKey >> shift) & 0xFF]++;
+		}
+
+		// every key has the same digit in this pass
+		if (counts[(m_sorted[0].sortKey >> shift) & 0xFF] == m_sorted.size())
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			size_t count = counts[digit];
+			counts[digit] = offset;
+			offset += count;
+		}
+
+		for (const QUEUE_ENTRY& entry : m_sorted)
+		{
+			m_scratch[counts[(entry.sortKey >> shift) & 0xFF]++] = entry;
+		}
+		m_sorted.swap(m_scratch);
+	}
+
+	m_stateChangesSaved = CountStateChanges(m_submitted) - CountStateChanges(m_sorted);
+	m_bResorted = true;
+}
+
+/***********************************************************
+ *  StateBits()
+ *
+ *  This method is used for moving the state fields of a sort
+ *  key to where they sit in an opaque key, so that keys of
+ *  both layouts can be compared field by field.
+ ***********************************************************/
+uint64_t RenderQueue::StateBits(uint64_t sortKey)
+{
+	if (sortKey & ((uint64_t)1 << TRANSLUCENT_SHIFT))
+	{
+		uint64_t stateMask = ((uint64_t)1 << TRANSLUCENT_DEPTH_SHIFT) - 1;
+		return((sortKey & stateMask) << TRANSLUCENT_STATE_SHIFT);
+	}
+
+	return(sortKey);
+}
+
+/***********************************************************
+ *  CountStateChanges()
+ *
+ *  This method is used for counting how many program, texture
+ *  and mesh switches it takes to draw the entries in the order
+ *  they are listed.
+ ***********************************************************/
+int RenderQueue::CountStateChanges(const std::vector<QUEUE_ENTRY>& entries)
+{
+	int stateChanges = 0;
+
+	for (size_t i = 1; i < entries.size(); i++)
+	{
+		uint64_t changed = StateBits(entries[i].sortKey) ^ StateBits(entries[i - 1].sortKey);
+
+		if (changed & PROGRAM_FIELD)
+			stateChanges++;
+		if (changed & TEXTURE_FIELD)
+			stateChanges++;
+		if (changed & MESH_FIELD)
+			stateChanges++;
+	}
+
+	return(stateChanges);
+}
+
+/***********************************************************
+ *  RunOrderCheck()
+ *
+ *  This method is used for checking that translucent draws
+ *  come out of the queue from the back to the front even when
+ *  their programs, textures and meshes differ, and that all
+ *  the opaque draws come out ahead of them.  The opaque draws
+ *  are then moved slightly further away, which must not make
+ *  the queue sort again.  It returns false and prints the
+ *  offending entries when the order is wrong.
+ ***********************************************************/
+bool RenderQueue::RunOrderCheck()
+{
+	struct CHECK_DRAW
+	{
+		bool bTranslucent;
+		int programIndex;
+		int textureSlot;
+		int meshIndex;
+		float viewDepth;
+	};
+
+	// submitted with the near translucent draws on the lowest
+	// texture slots, which an order by state would draw first
+	const CHECK_DRAW draws[] =
+	{
+		{ true, 0, 0, 3, 2.0f },
+		{ true, 1, 5, 1, 40.0f },
+		{ false, 0, 7, 2, 12.0f },
+		{ true, 0, 1, 0, 9.5f },
+		{ true, 0, 200, 4, 0.25f },
+		{ false, 1, 0, 0, 3.0f },
+		{ true, 1, 3, 2, 9.75f },
+	};
+	const int drawCount = (int)(sizeof(draws) / sizeof(draws[0]));
+
+	RenderQueue renderQueue;
+	for (int i = 0; i < drawCount; i++)
+	{
+		renderQueue.Submit(
+			MakeSortKey(
+				draws[i].bTranslucent,
+				draws[i].programIndex,
+				draws[i].textureSlot,
+				i,
+				draws[i].meshIndex,
+				draws[i].viewDepth),
+			i);
+	}
+	renderQueue.Sort();
+
+	bool bInOrder = true;
+	for (int position = 1; position < renderQueue.GetCount(); position++)
+	{
+		const CHECK_DRAW& previous = draws[renderQueue.GetObjectIndex(position - 1)];
+		const CHECK_DRAW& current = draws[renderQueue.GetObjectIndex(position)];
+
+		if ((previous.bTranslucent && !current.bTranslucent) ||
+			(previous.bTranslucent && current.bTranslucent &&
+			(previous.viewDepth < current.viewDepth)))
+		{
+			std::cout << "ERROR: render queue drew the draw at depth " << previous.viewDepth
+				<< " before the draw at depth " << current.viewDepth << std::endl;
+			bInOrder = false;
+		}
+	}
+
+	// a small camera move keeps the opaque depth buckets
+	renderQueue.Clear();
+	for (int i = 0; i < drawCount; i++)
+	{
+		renderQueue.Submit(
+			MakeSortKey(
+				draws[i].bTranslucent,
+				draws[i].programIndex,
+				draws[i].textureSlot,
+				i,
+				draws[i].meshIndex,
+				draws[i].bTranslucent ? draws[i].viewDepth : draws[i].viewDepth * 1.02f),
+			i);
+	}
+	renderQueue.Sort();
+	if (renderQueue.WasResorted() == true)
+	{
+		std::cout << "ERROR: render queue sorted again after the opaque draws moved slightly" << std::endl;
+		bInOrder = false;
+	}
+
+	if (bInOrder)
+	{
+		std::cout << "INFO: render queue sorted " << drawCount
+			<< " draws with the translucent draws back to front, and kept the order when"
+			<< " the opaque draws moved slightly" << std::endl;
+	}
+
+	return(bInOrder);
+}
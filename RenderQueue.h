@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// order the draws of a frame by a packed state sort key
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draws for a frame as 64-bit sort
+ *  keys and radix sorts them so that draws sharing the same
+ *  shader program, texture, mesh and material are submitted
+ *  next to each other.  An opaque key is laid out from the
+ *  most to the least significant bits as:
+ *
+ *    63     translucency (opaque draws first)
+ *    56-62  shader program
+ *    48-55  texture slot
+ *    43-47  mesh and its level of detail
+ *    32-42  material
+ *    4-31   unused
+ *    0-3    view depth bucket (front-to-back)
+ *
+ *  The opaque depth only has to be roughly front-to-back for
+ *  the depth test to reject hidden fragments early, so it is
+ *  kept as a bucket that doubles in size with the distance.
+ *  A small camera move then leaves the opaque keys as they
+ *  were and Sort() can keep the last order.
+ *
+ *  A translucent key has to stay back-to-front across the
+ *  whole scene, so its depth comes before the state:
+ *
+ *    63     translucency
+ *    31-62  inverted view depth (back-to-front)
+ *    24-30  shader program
+ *    16-23  texture slot
+ *    11-15  mesh and its level of detail
+ *    0-10   material
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+	// destructor
+	~RenderQueue();
+
+	// pack the draw state into a sort key
+	static uint64_t MakeSortKey(
+		bool bTranslucent,
+		int programIndex,
+		int textureSlot,
+		int materialIndex,
+		int meshIndex,
+		float viewDepth);
+
+	// remove all the submitted draws
+	void Clear();
+	// add a draw to the queue
+	void Submit(uint64_t sortKey, int objectIndex);
+	// sort the submitted draws, skipped when they are
+	// identical to the draws sorted last time
+	void Sort();
+
+	// number of draws in the queue
+	int GetCount() const { return((int)m_sorted.size()); }
+	// object index of a draw in sorted order
+	int GetObjectIndex(int position) const { return(m_sorted[position].objectIndex); }
+	// true when the last call to Sort() had to sort
+	bool WasResorted() const { return(m_bResorted); }
+	// state changes avoided by the sorted order compared
+	// to the order the draws were submitted in
+	int GetStateChangesSaved() const { return(m_stateChangesSaved); }
+
+	// check that translucent draws with different state still
+	// come out from the back to the front
+	static bool RunOrderCheck();
+
+private:
+	struct QUEUE_ENTRY
+	{
+		uint64_t sortKey;
+		int objectIndex;
+	};
+
+	// draws in the order they were submitted this frame
+	std::vector<QUEUE_ENTRY> m_submitted;
+	// submitted draws from the last sort, for change detection
+	std::vector<QUEUE_ENTRY> m_lastSubmitted;
+	// draws in sorted order
+	std::vector<QUEUE_ENTRY> m_sorted;
+	// scratch buffer for the radix sort passes
+	std::vector<QUEUE_ENTRY> m_scratch;
+	bool m_bResorted;
+	int m_stateChangesSaved;
+
+	// state fields of a key in the opaque layout
+	static uint64_t StateBits(uint64_t sortKey);
+	// count the program, texture and mesh changes needed to draw
+	// a list of entries in order
+	static int CountStateChanges(const std::vector<QUEUE_ENTRY>& entries);
+};
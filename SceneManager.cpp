@@ -8,6 +8,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "TextureUnits.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,15 +16,69 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	constexpr UNIFORM_NAME g_FirstDrawIDName = "firstDrawID";
+	constexpr UNIFORM_NAME g_WeightedBlendedName = "bWeightedBlended";
+	const char* const g_TextureArrayName = "textureArrays";
+
+	// shader storage binding points of the per-draw values,
+	// the bindless texture handles and the materials
+	const GLuint DRAW_DATA_BINDING = 0;
+	const GLuint TEXTURE_HANDLE_BINDING = 1;
+	const GLuint MATERIAL_BINDING = 2;
+	// texture arrays the shaders can sample without bindless
+	// handles, one texture unit each
+	const int TOTAL_TEXTURE_ARRAYS = (int)SCENE_TEXTURE_ARRAY_UNITS;
+	// slots in the ring of pixel buffers the images are
+	// streamed through, each the size of the largest image
+	const int PIXEL_UPLOAD_SLOTS = 3;
+	// samples taken along a texture seen at a glancing angle,
+	// clamped to what the hardware supports
+	const float DEFAULT_TEXTURE_ANISOTROPY = 8.0f;
+
+	// bounding sphere radius in pixels below which each level
+	// of detail gives way to the next coarser one
+	const float LOD_PIXEL_RADII[] = { 48.0f, 16.0f, 6.0f };
+	// fraction past a threshold the radius has to move before
+	// the level of detail changes
+	const float LOD_HYSTERESIS = 0.2f;
+
+	// tube thickness of the torus, for the mesh and the patches
+	const float TORUS_THICKNESS = 0.1f;
+
+	// bounding sphere radius in pixels below which an object is
+	// drawn as its impostor, under half the size of one baked view
+	const float IMPOSTOR_PIXEL_RADIUS = 12.0f;
+	// file the baked impostors are kept in between runs
+	const char* const IMPOSTOR_CACHE_FILE = "impostors.cache";
+	// file the decoded texture images are kept in between runs
+	const char* const DECODED_TEXTURE_CACHE_FILE = "textures.cache";
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Continue a 64-bit FNV-1a hash over a block of bytes.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return(hash);
+	}
 } 
 
 /***********************************************************
@@ -31,10 +86,51 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache, SceneUniformBuffer* pSceneUniforms)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pUniformCache = pUniformCache;
+	m_pSceneUniforms = pSceneUniforms;
+	m_basicMeshes = new SceneMeshes();
+	m_renderStats.transformsRebuilt = 0;
+	m_renderStats.stateCallsIssued = 0;
+	m_renderStats.stateCallsSkipped = 0;
+	m_renderStats.stateChangesSaved = 0;
+	m_renderStats.drawCalls = 0;
+	m_renderStats.drawCommands = 0;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_renderStats.visibleObjects = 0;
+	m_renderStats.culledObjects = 0;
+	m_renderStats.occludedObjects = 0;
+	m_renderStats.occlusionQueries = 0;
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewProjection = glm::mat4(1.0f);
+	m_renderStats.trianglesDrawn = 0;
+	m_renderStats.trianglesSaved = 0;
+	m_renderStats.impostorsDrawn = 0;
+	m_renderStats.sceneGpuMilliseconds = 0.0f;
+	m_renderStats.depthPrepassGpuMilliseconds = 0.0f;
+	m_bOcclusionCulling = false;
+	m_bGpuCulling = false;
+	m_bDrawBatchesDirty = false;
+	m_bTessellation = false;
+	m_bDepthPrepass = false;
+	m_bWeightedBlendedOit = false;
+	m_bImpostors = false;
+	m_impostorPixelRadius = IMPOSTOR_PIXEL_RADIUS;
+	m_opaqueCommandCount = 0;
+	m_drawDataBuffer = 0;
+	m_drawDataCapacity = 0;
+	m_bBindlessTextures = GLEW_ARB_bindless_texture ? true : false;
+	m_textureHandleBuffer = 0;
+	m_bCompressedTextures = CompressedTextureCache::IsSupported();
+	m_bDecodedCacheStale = false;
+	for (int i = 0; i < TEXTURE_SOURCE_COUNT; i++)
+	{
+		m_textureLoadCounts[i] = 0;
+	}
+	m_materialBuffer = 0;
+	m_bMaterialsDirty = false;
 }
 
 /***********************************************************
@@ -45,97 +141,610 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pUniformCache = NULL;
+	m_pSceneUniforms = NULL;
+	if (m_decodedCacheWriter.joinable())
+	{
+		m_decodedCacheWriter.join();
+	}
+	DestroyGLTextures();
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+
+	if (m_drawDataBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_drawDataBuffer);
+		m_drawDataBuffer = 0;
+	}
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for registering a texture image file
+ *  as the next layer of the texture array for its image size
+ *  and format, and queueing the file to be decoded on a
+ *  worker thread.  When the block compressed cache beside
+ *  the image is valid, the compressed blocks are used and
+ *  the image is never decoded, otherwise the image is
+ *  decoded and the cache written for the next run.  Next in
+ *  line is the memory mapped cache of decoded images, whose
+ *  pixels are handed straight to the upload without going
+ *  through a worker thread.  Only the headers are read here,
+ *  for the size and format, so the scene can start drawing
+ *  before the pixels arrive.
+ *
+ *  Without bindless handles there is only a texture unit
+ *  for each of the first arrays, so an image of any other
+ *  size after that is decoded and resampled to fit the
+ *  closest array instead of failing to load.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
 {
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+	GLenum format = GL_RGBA8;
+
+	// the tag is the only way to find the texture again
+	if (m_textureTags.Find(tag) >= 0)
+	{
+		std::cout << "ERROR: texture tag " << tag << " is already loaded, skipping image:" << filename << std::endl;
+		return false;
+	}
+
+	if (m_textureIDs.empty())
+	{
+		m_textureLoadStart = std::chrono::steady_clock::now();
+		m_decodedTextureCache.Open(DECODED_TEXTURE_CACHE_FILE);
+	}
+
+	CompressedTextureCache::CACHE_INFO cache;
+	cache.bValid = false;
+	DecodedTextureCache::CACHE_ENTRY decodedEntry;
+	bool bDecodedCacheHit = false;
+	if ((m_bCompressedTextures == true) && (CompressedTextureCache::FindCache(filename, cache) == true))
+	{
+		width = cache.width;
+		height = cache.height;
+		format = cache.format;
+	}
+	else if (m_decodedTextureCache.Find(filename, decodedEntry) == true)
+	{
+		width = decodedEntry.width;
+		height = decodedEntry.height;
+		bDecodedCacheHit = true;
+	}
+	// try to read the image size from the specified image file
+	else if (stbi_info(filename, &width, &height, &colorChannels) == 0)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+
+		// Error loading the image
+		return false;
+	}
+
+	// find the texture array for images of this size and format
+	int arrayIndex = 0;
+	while ((arrayIndex < (int)m_textureArrays.size()) &&
+		((m_textureArrays[arrayIndex].width != width) ||
+		(m_textureArrays[arrayIndex].height != height) ||
+		(m_textureArrays[arrayIndex].format != format)))
+	{
+		arrayIndex++;
+	}
+
+	// without bindless handles every array takes a texture
+	// unit, so once they are all taken the image is resampled
+	// into another layer of the array closest to its size
+	bool bResized = false;
+	if ((arrayIndex == (int)m_textureArrays.size()) &&
+		(m_bBindlessTextures == false) && (arrayIndex >= TOTAL_TEXTURE_ARRAYS))
+	{
+		float closestDistance = 0.0f;
+		for (int i = 0; i < (int)m_textureArrays.size(); i++)
+		{
+			float distance =
+				fabsf(log2f((float)m_textureArrays[i].width / width)) +
+				fabsf(log2f((float)m_textureArrays[i].height / height));
+			if ((i == 0) || (distance < closestDistance))
+			{
+				closestDistance = distance;
+				arrayIndex = i;
+			}
+		}
+		bResized = true;
+
+		std::cout << "WARNING: no texture unit left for the " << width << "x" << height << " image " << filename
+			<< ", resized to " << m_textureArrays[arrayIndex].width << "x" << m_textureArrays[arrayIndex].height << std::endl;
+	}
+
+	if (arrayIndex == (int)m_textureArrays.size())
+	{
+		TEXTURE_ARRAY textureArray;
+		textureArray.ID = 0;
+		textureArray.width = width;
+		textureArray.height = height;
+		textureArray.format = format;
+		textureArray.layers = 0;
+		textureArray.handle = 0;
+		m_textureArrays.push_back(textureArray);
+	}
+
+	// register the texture and associate it with the special tag string
+	TEXTURE_INFO texture;
+	texture.tag = tag;
+	texture.filename = filename;
+	texture.ID = 0;
+	texture.arrayIndex = arrayIndex;
+	texture.layer = m_textureArrays[arrayIndex].layers;
+	texture.bLoaded = false;
+	m_textureArrays[arrayIndex].layers++;
+
+	if (bResized == true)
+	{
+		// the caches hold the image at its own size
+		const TEXTURE_ARRAY& textureArray = m_textureArrays[arrayIndex];
+		m_textureLoader.QueueResized(
+			(int)m_textureIDs.size(),
+			filename,
+			textureArray.width,
+			textureArray.height,
+			textureArray.format);
+		m_textureLoadCounts[TEXTURE_DECODED]++;
+	}
+	else if (bDecodedCacheHit == true)
+	{
+		// uploaded from the mapping with the decoded images
+		TextureLoader::DECODED_IMAGE image;
+		image.textureSlot = (int)m_textureIDs.size();
+		image.filename = filename;
+		image.pixels = (unsigned char*)decodedEntry.pixels;
+		image.bCompressed = false;
+		image.bMapped = true;
+		image.levelBytes = decodedEntry.levelBytes;
+		image.width = decodedEntry.width;
+		image.height = decodedEntry.height;
+		image.channels = 4;
+		image.sourceSize = decodedEntry.sourceSize;
+		image.modifiedTime = decodedEntry.modifiedTime;
+		image.contentHash = decodedEntry.contentHash;
+		image.decodeMilliseconds = 0.0;
+		image.encodeMilliseconds = 0.0;
+		image.bResized = false;
+		m_pendingUploads.push_back(image);
+		m_textureLoadCounts[TEXTURE_FROM_DECODED_CACHE]++;
+	}
+	else
+	{
+		m_textureLoader.Queue((int)m_textureIDs.size(), filename, m_bCompressedTextures ? &cache : NULL);
+		if (cache.bValid == true)
+		{
+			m_textureLoadCounts[TEXTURE_FROM_COMPRESSED_CACHE]++;
+		}
 		else
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			// the decoded cache is missing this image
+			m_textureLoadCounts[TEXTURE_DECODED]++;
+			m_bDecodedCacheStale = true;
 		}
+	}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+	m_textureIDs.push_back(texture);
+	m_textureTags.Intern(tag);
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	return true;
+}
+
+/***********************************************************
+ *  BuildTextureArrays()
+ *
+ *  This method is used for creating a texture array for
+ *  every registered image size, with every layer and mipmap
+ *  level cleared to a grey placeholder until its image has
+ *  been decoded.  The arrays have no filtering state of their
+ *  own, they are all read through the shared anisotropic
+ *  sampler object.
+ ***********************************************************/
+void SceneManager::BuildTextureArrays()
+{
+	const GLubyte placeholderColor[] = { 128, 128, 128, 255 };
+
+	if (m_textureSamplers.GetSampler(TextureSamplers::SAMPLER_ANISOTROPIC) == 0)
+	{
+		m_textureSamplers.Initialize(DEFAULT_TEXTURE_ANISOTROPY);
+	}
+
+	for (int arrayIndex = 0; arrayIndex < (int)m_textureArrays.size(); arrayIndex++)
+	{
+		TEXTURE_ARRAY& textureArray = m_textureArrays[arrayIndex];
+		if (textureArray.ID != 0)
+		{
+			continue;
+		}
+
+		// enough mipmap levels to reach a single texel
+		int levels = 1;
+		while (((textureArray.width >> levels) > 0) || ((textureArray.height >> levels) > 0))
+		{
+			levels++;
+		}
+
+		glGenTextures(1, &textureArray.ID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+		glTexStorage3D(
+			GL_TEXTURE_2D_ARRAY,
+			levels,
+			textureArray.format,
+			textureArray.width,
+			textureArray.height,
+			textureArray.layers);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		// compressed textures cannot be cleared, so the blocks
+		// of the placeholder color are uploaded instead
+		for (int level = 0; level < levels; level++)
+		{
+			if (textureArray.format == GL_RGBA8)
+			{
+				glClearTexImage(textureArray.ID, level, GL_RGBA, GL_UNSIGNED_BYTE, placeholderColor);
+				continue;
+			}
+
+			int levelWidth = std::max(textureArray.width >> level, 1);
+			int levelHeight = std::max(textureArray.height >> level, 1);
+			std::vector<unsigned char> blocks;
+			CompressedTextureCache::MakeSolidLevel(textureArray.format, placeholderColor, levelWidth, levelHeight, blocks);
+			for (int layer = 0; layer < textureArray.layers; layer++)
+			{
+				glCompressedTextureSubImage3D(
+					textureArray.ID,
+					level,
+					0, 0, layer,
+					levelWidth, levelHeight, 1,
+					textureArray.format,
+					(GLsizei)blocks.size(),
+					blocks.data());
+			}
+		}
+	}
+
+	for (TEXTURE_INFO& texture : m_textureIDs)
+	{
+		texture.ID = m_textureArrays[texture.arrayIndex].ID;
+	}
+
+	MakeTextureHandles();
+
+	// size the upload slots for the largest image, falling back
+	// to uploading from the decoded pixels without the ring
+	size_t largestImageBytes = 0;
+	for (const TEXTURE_ARRAY& textureArray : m_textureArrays)
+	{
+		largestImageBytes = std::max(largestImageBytes, DecodedTextureCache::GetChainBytes(textureArray.width, textureArray.height));
+	}
+	if ((largestImageBytes > m_pixelUploadRing.GetSlotBytes()) &&
+		(m_pixelUploadRing.Initialize(largestImageBytes, PIXEL_UPLOAD_SLOTS) == false))
+	{
+		std::cout << "WARNING: persistently mapped pixel buffers are not supported, images are uploaded directly" << std::endl;
+	}
+
+	// texture memory of the full mipmap chains, against the
+	// same images stored as RGBA8
+	size_t textureBytes = 0;
+	size_t uncompressedBytes = 0;
+	int compressedArrays = 0;
+	for (const TEXTURE_ARRAY& textureArray : m_textureArrays)
+	{
+		for (int level = 0; ((textureArray.width >> level) > 0) || ((textureArray.height >> level) > 0); level++)
+		{
+			int levelWidth = std::max(textureArray.width >> level, 1);
+			int levelHeight = std::max(textureArray.height >> level, 1);
+			size_t rgbaBytes = (size_t)levelWidth * levelHeight * 4 * textureArray.layers;
+			uncompressedBytes += rgbaBytes;
+			if (textureArray.format == GL_RGBA8)
+			{
+				textureBytes += rgbaBytes;
+			}
+			else
+			{
+				textureBytes += CompressedTextureCache::GetLevelBytes(textureArray.format, levelWidth, levelHeight) * textureArray.layers;
+			}
+		}
+		compressedArrays += (textureArray.format != GL_RGBA8) ? 1 : 0;
+	}
+
+	std::cout << "INFO: Created " << m_textureArrays.size() << " texture arrays for " << m_textureIDs.size()
+		<< " textures" << (m_bBindlessTextures ? " with bindless handles" : "")
+		<< ", decoding on " << m_textureLoader.GetThreadCount() << " threads, "
+		<< m_textureSamplers.GetAnisotropy() << "x anisotropic filtering" << std::endl;
+	std::cout << "INFO: " << compressedArrays << " texture arrays block compressed, "
+		<< (textureBytes / 1024) << " KB of texture memory against "
+		<< (uncompressedBytes / 1024) << " KB uncompressed" << std::endl;
+}
+
+/***********************************************************
+ *  MakeTextureHandles()
+ *
+ *  This method is used for making a resident bindless handle
+ *  for every texture array paired with the shared sampler,
+ *  and uploading the handles for the shaders.  The state of
+ *  the sampler is frozen by the handles, so they are made
+ *  again whenever the sampler is replaced.  The contents of
+ *  the arrays can still be replaced once the handles exist.
+ ***********************************************************/
+void SceneManager::MakeTextureHandles()
+{
+	if ((m_bBindlessTextures == false) || (m_textureArrays.empty()))
+	{
+		return;
+	}
+
+	GLuint sampler = m_textureSamplers.GetSampler(TextureSamplers::SAMPLER_ANISOTROPIC);
+
+	std::vector<GLuint64> handles;
+	for (TEXTURE_ARRAY& textureArray : m_textureArrays)
+	{
+		if (textureArray.handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(textureArray.handle);
+		}
+		textureArray.handle = glGetTextureSamplerHandleARB(textureArray.ID, sampler);
+		glMakeTextureHandleResidentARB(textureArray.handle);
+		handles.push_back(textureArray.handle);
+	}
+
+	if (m_textureHandleBuffer == 0)
+	{
+		glGenBuffers(1, &m_textureHandleBuffer);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_textureHandleBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint64) * handles.size(), handles.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadDecodedTextures()
+ *
+ *  This method is used for copying the images the worker
+ *  threads have decoded into their texture array layers, on
+ *  the thread that owns the GL context, every mipmap level
+ *  coming with the image.  It runs at
+ *  the start of every frame without waiting, so the scene is
+ *  drawn with placeholders while the decoding goes on, or
+ *  waits for every image when something needs them all.
+ *
+ *  Each image is written into a free slot of the mapped
+ *  pixel buffer ring and the layer is filled from the slot,
+ *  so the upload call returns without the driver copying
+ *  the pixels.  An image that finds every slot still in use
+ *  waits for a later frame rather than stalling this one.
+ *
+ *  When an image had to be decoded, the uncompressed images
+ *  are copied as they go by, and once the last one is in
+ *  place the decoded cache is unmapped and written again
+ *  from those copies for the next run.
+ ***********************************************************/
+void SceneManager::UploadDecodedTextures(bool bWaitForAll)
+{
+	if (bWaitForAll == true)
+	{
+		m_textureLoader.WaitForAll();
+	}
+
+	std::vector<TextureLoader::DECODED_IMAGE> images;
+	m_textureLoader.TakeDecoded(images);
+	images.insert(images.begin(), m_pendingUploads.begin(), m_pendingUploads.end());
+	m_pendingUploads.clear();
+	if (images.empty())
+	{
+		return;
+	}
+
+	for (TextureLoader::DECODED_IMAGE& image : images)
+	{
+		if (NULL == image.pixels)
+		{
+			std::cout << "Could not load image:" << image.filename << std::endl;
+			continue;
+		}
+
+		TEXTURE_INFO& texture = m_textureIDs[image.textureSlot];
+		const TEXTURE_ARRAY& textureArray = m_textureArrays[texture.arrayIndex];
+		if ((image.width != textureArray.width) || (image.height != textureArray.height) ||
+			(image.bCompressed != (textureArray.format != GL_RGBA8)) || (texture.ID == 0))
+		{
+			std::cout << "ERROR: image " << image.filename << " does not fit its texture array layer" << std::endl;
+			TextureLoader::FreePixels(image);
+			continue;
+		}
+
+		size_t imageBytes = 0;
+		for (size_t levelBytes : image.levelBytes)
+		{
+			imageBytes += levelBytes;
+		}
+		int uploadSlot = m_pixelUploadRing.AcquireSlot(imageBytes, bWaitForAll);
+		if ((uploadSlot < 0) && (imageBytes <= m_pixelUploadRing.GetSlotBytes()))
+		{
+			// every slot is still being read by the GPU
+			m_pendingUploads.push_back(image);
+			continue;
+		}
+
+		// with the pixel buffer bound, the source is an offset
+		// into the buffer rather than a pointer
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const unsigned char* source = image.pixels;
+		if (uploadSlot >= 0)
+		{
+			memcpy(m_pixelUploadRing.GetSlotPointer(uploadSlot), image.pixels, imageBytes);
+			m_pixelUploadRing.Bind();
+			source = (const unsigned char*)m_pixelUploadRing.GetSlotOffset(uploadSlot);
+		}
+
+		// every image comes with all of its mipmap levels
+		for (int level = 0; level < (int)image.levelBytes.size(); level++)
+		{
+			int levelWidth = std::max(textureArray.width >> level, 1);
+			int levelHeight = std::max(textureArray.height >> level, 1);
+			if (image.bCompressed)
+			{
+				glCompressedTextureSubImage3D(
+					textureArray.ID,
+					level,
+					0, 0, texture.layer,
+					levelWidth, levelHeight, 1,
+					textureArray.format,
+					(GLsizei)image.levelBytes[level],
+					source);
+			}
+			else
+			{
+				glTextureSubImage3D(
+					textureArray.ID,
+					level,
+					0, 0, texture.layer,
+					levelWidth, levelHeight, 1,
+					GL_RGBA,
+					GL_UNSIGNED_BYTE,
+					source);
+			}
+			source += image.levelBytes[level];
+		}
+
+		if (uploadSlot >= 0)
+		{
+			m_pixelUploadRing.Unbind();
+			m_pixelUploadRing.ReleaseSlot(uploadSlot);
+		}
+		double uploadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		texture.bLoaded = true;
+
+		std::cout << "Successfully loaded image:" << image.filename << ", width:" << image.width << ", height:" << image.height
+			<< ", channels:" << image.channels
+			<< (image.bMapped ? ", mapped from the decoded cache" : (image.bCompressed ? ", read compressed in " : ", decoded in "));
+		if (image.bMapped == false)
+		{
+			std::cout << image.decodeMilliseconds << " ms";
+		}
+		std::cout << ", uploaded in " << uploadMilliseconds << " ms" << std::endl;
+
+		// keep a copy of the uncompressed chains for the decoded
+		// cache, the mapped ones too since the file is replaced,
+		// but not the images a compressed cache serves or was
+		// just written for, which the next run reads from there
+		if ((m_bDecodedCacheStale == true) && (image.bCompressed == false) &&
+			(image.encodeMilliseconds <= 0.0))
+		{
+			DecodedTextureCache::WRITE_ENTRY entry;
+			entry.sourceFile = image.filename;
+			entry.sourceSize = image.sourceSize;
+			entry.modifiedTime = image.modifiedTime;
+			entry.contentHash = image.contentHash;
+			entry.width = image.width;
+			entry.height = image.height;
+			entry.pixels.assign(image.pixels, image.pixels + imageBytes);
+			m_decodedCacheEntries.push_back(entry);
+		}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+		// free the image data from local memory
+		TextureLoader::FreePixels(image);
+		if (image.encodeMilliseconds > 0.0)
+		{
+			std::cout << "INFO: Wrote the compressed texture cache for " << image.filename
+				<< " in " << image.encodeMilliseconds << " ms, used from the next run" << std::endl;
+		}
+	}
 
-		return true;
+	if ((m_textureLoader.GetOutstandingCount() == 0) && (m_pendingUploads.empty()))
+	{
+		// a warm start found every image in one of the caches
+		bool bWarmStart = (m_textureLoadCounts[TEXTURE_DECODED] == 0);
+		std::cout << "INFO: All " << m_textureIDs.size() << " textures loaded "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_textureLoadStart).count()
+			<< " ms after the first was queued, " << (bWarmStart ? "warm" : "cold") << " start: "
+			<< m_textureLoadCounts[TEXTURE_FROM_DECODED_CACHE] << " from the decoded cache, "
+			<< m_textureLoadCounts[TEXTURE_FROM_COMPRESSED_CACHE] << " from compressed caches, "
+			<< m_textureLoadCounts[TEXTURE_DECODED] << " decoded" << std::endl;
+
+		m_decodedTextureCache.Close();
+		if (m_bDecodedCacheStale == true)
+		{
+			WriteDecodedTextureCache();
+			m_bDecodedCacheStale = false;
+		}
 	}
+}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+/***********************************************************
+ *  WriteDecodedTextureCache()
+ *
+ *  This method is used for writing the uncompressed images
+ *  and mipmaps kept while they were uploaded to the decoded
+ *  texture cache.  The worker threads built every mipmap
+ *  level on the CPU, so nothing is read back from the GPU,
+ *  and the file is written on a thread of its own so the
+ *  frame is not held up by the disk.  It only runs once all
+ *  the textures are loaded and only on a run that had to
+ *  decode an image.  Images that failed to load are left
+ *  out rather than caching their placeholder, and so are
+ *  the images with a compressed cache, so no image is kept
+ *  in both.
+ ***********************************************************/
+void SceneManager::WriteDecodedTextureCache()
+{
+	if (m_decodedCacheWriter.joinable())
+	{
+		m_decodedCacheWriter.join();
+	}
 
-	// Error loading the image
-	return false;
+	std::vector<DecodedTextureCache::WRITE_ENTRY> entries;
+	entries.swap(m_decodedCacheEntries);
+	m_decodedCacheWriter = std::thread([entries]()
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (DecodedTextureCache::Write(DECODED_TEXTURE_CACHE_FILE, entries) == true)
+		{
+			std::cout << "INFO: Wrote " << entries.size() << " textures to the decoded texture cache in "
+				<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+				<< " ms, used from the next run" << std::endl;
+		}
+	});
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for making the texture arrays visible
+ *  to the shaders.  With bindless textures the buffer of
+ *  handles is bound, otherwise each array is bound to its own
+ *  texture unit, with the shared sampler, and assigned to the
+ *  matching element of the shader's sampler array.  Either
+ *  way every texture can be used by any draw without binding
+ *  anything again.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (m_bBindlessTextures)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_HANDLE_BINDING, m_textureHandleBuffer);
+		return;
+	}
+
+	for (int i = 0; i < (int)m_textureArrays.size(); i++)
+	{
+		// bind texture arrays on corresponding texture units
+		m_pUniformCache->BindTexture(i, m_textureArrays[i].ID, GL_TEXTURE_2D_ARRAY);
+		glBindSampler(i, m_textureSamplers.GetSampler(TextureSamplers::SAMPLER_ANISOTROPIC));
+
+		std::string elementName = std::string(g_TextureArrayName) + "[" + std::to_string(i) + "]";
+		m_pUniformCache->setSampler2DValue(UNIFORM_NAME(elementName.c_str()), i);
 	}
 }
 
@@ -143,13 +752,38 @@ void SceneManager::BindGLTextures()
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture arrays.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (TEXTURE_ARRAY& textureArray : m_textureArrays)
+	{
+		if (textureArray.handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(textureArray.handle);
+		}
+		if (textureArray.ID != 0)
+		{
+			glDeleteTextures(1, &textureArray.ID);
+		}
+	}
+	m_textureArrays.clear();
+	m_textureIDs.clear();
+	m_textureTags.Clear();
+
+	for (TextureLoader::DECODED_IMAGE& image : m_pendingUploads)
+	{
+		TextureLoader::FreePixels(image);
+	}
+	m_pendingUploads.clear();
+	m_decodedTextureCache.Close();
+	m_pixelUploadRing.Destroy();
+	m_textureSamplers.Destroy();
+
+	if (m_textureHandleBuffer != 0)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		glDeleteBuffers(1, &m_textureHandleBuffer);
+		m_textureHandleBuffer = 0;
 	}
 }
 
@@ -159,50 +793,28 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const std::string& tag)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int textureSlot = FindTextureSlot(tag);
+	if (textureSlot < 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureID);
+	return(m_textureIDs[textureSlot].ID);
 }
 
 /***********************************************************
  *  FindTextureSlot()
  *
  *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  loaded texture bitmap associated with the passed in tag.  The
+ *  texture tags are interned in load order, so the tag handle is
+ *  the slot index.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(const std::string& tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
+	return(m_textureTags.Find(tag));
 }
 
 /***********************************************************
@@ -211,42 +823,60 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(const std::string& tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int materialIndex = FindMaterialIndex(tag);
+	if (materialIndex < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material = m_objectMaterials[materialIndex];
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of the previously
+ *  defined material that is associated with the passed in tag.
+ *  The material tags are interned in definition order, so the
+ *  tag handle is the material index.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const std::string& tag)
+{
+	return(m_materialTags.Find(tag));
+}
+
+/***********************************************************
+ *  InternMaterialTags()
+ *
+ *  This method is used for interning the tags of all the
+ *  defined materials, in the order they were defined.  A tag
+ *  that is used by more than one material is reported, since
+ *  only the first of those materials can be found by it.
+ ***********************************************************/
+void SceneManager::InternMaterialTags()
+{
+	m_materialTags.Clear();
+
+	for (int i = 0; i < (int)m_objectMaterials.size(); i++)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
+		if (m_materialTags.Intern(m_objectMaterials[i].tag) != i)
 		{
-			index++;
+			std::cout << "ERROR: material tag " << m_objectMaterials[i].tag << " is defined more than once" << std::endl;
 		}
 	}
-
-	return(true);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  CalculateModelMatrix()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for calculating the model matrix
+ *  from the passed in transformation values.
  ***********************************************************/
-void SceneManager::SetTransformations(
+glm::mat4 SceneManager::CalculateModelMatrix(
 	glm::vec3 scaleXYZ,
 	float XrotationDegrees,
 	float YrotationDegrees,
@@ -254,7 +884,6 @@ void SceneManager::SetTransformations(
 	glm::vec3 positionXYZ)
 {
 	// variables for this method
-	glm::mat4 modelView;
 	glm::mat4 scale;
 	glm::mat4 rotationX;
 	glm::mat4 rotationY;
@@ -270,1044 +899,2304 @@ void SceneManager::SetTransformations(
 	// set the translation value in the transform buffer
 	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	return(translation * rotationX * rotationY * rotationZ * scale);
+}
 
-	if (NULL != m_pShaderManager)
+/***********************************************************
+ *  AddTexturedObject()
+ *
+ *  This method is used for adding a textured object to the
+ *  render list.  The model matrix, texture slot and material
+ *  are all resolved here so that nothing needs to be looked
+ *  up or recalculated when the scene is rendered.
+ ***********************************************************/
+void SceneManager::AddTexturedObject(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	const std::string& textureTag,
+	const std::string& materialTag,
+	glm::vec2 uvScale)
+{
+	SCENE_OBJECT object;
+
+	object.mesh = mesh;
+	object.scaleXYZ = scaleXYZ;
+	object.XrotationDegrees = XrotationDegrees;
+	object.YrotationDegrees = YrotationDegrees;
+	object.ZrotationDegrees = ZrotationDegrees;
+	object.positionXYZ = positionXYZ;
+	object.modelMatrix = CalculateModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+	object.bTransformDirty = false;
+	object.worldBounds = TransformBoundingVolume(GetSceneObjectMeshBounds(mesh), object.modelMatrix);
+	object.textureSlot = FindTextureSlot(textureTag);
+	object.uvScale = uvScale;
+	object.materialIndex = FindMaterialIndex(materialTag);
+	object.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	object.bTranslucent = IsTranslucent(object.color, object.materialIndex);
+	object.lodLevel = 0;
+	object.impostorIndex = -1;
+	object.bImpostor = false;
+
+	// a missing tag would otherwise draw silently without
+	// its texture or material
+	if (object.textureSlot < 0)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		std::cout << "ERROR: no texture is loaded with the tag " << textureTag << std::endl;
 	}
+	if (object.materialIndex < 0)
+	{
+		std::cout << "ERROR: no material is defined with the tag " << materialTag << std::endl;
+	}
+
+	m_sceneObjects.push_back(object);
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  AddColoredObject()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for adding an object that is drawn
+ *  with a flat color to the render list.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::AddColoredObject(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	const std::string& materialTag)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
+	SCENE_OBJECT object;
+
+	object.mesh = mesh;
+	object.scaleXYZ = scaleXYZ;
+	object.XrotationDegrees = XrotationDegrees;
+	object.YrotationDegrees = YrotationDegrees;
+	object.ZrotationDegrees = ZrotationDegrees;
+	object.positionXYZ = positionXYZ;
+	object.modelMatrix = CalculateModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+	object.bTransformDirty = false;
+	object.worldBounds = TransformBoundingVolume(GetSceneObjectMeshBounds(mesh), object.modelMatrix);
+	object.textureSlot = -1;
+	object.uvScale = glm::vec2(1.0f, 1.0f);
+	object.materialIndex = FindMaterialIndex(materialTag);
+	object.color = color;
+	object.bTranslucent = IsTranslucent(color, object.materialIndex);
+	object.lodLevel = 0;
+	object.impostorIndex = -1;
+	object.bImpostor = false;
+
+	if (object.materialIndex < 0)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		std::cout << "ERROR: no material is defined with the tag " << materialTag << std::endl;
 	}
+
+	m_sceneObjects.push_back(object);
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  GetSceneObjectCommand()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for making the indirect command that
+ *  draws the instances of the basic mesh referenced by a
+ *  draw batch.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+SceneMeshes::DRAW_COMMAND SceneManager::GetSceneObjectCommand(MESH_TYPE mesh, int lodLevel, int count, int firstInstance)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+	SceneMeshes::DRAW_COMMAND command = {};
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		command = m_basicMeshes->GetPlaneMeshCommand(count, firstInstance);
+		break;
+	case MESH_BOX:
+		command = m_basicMeshes->GetBoxMeshCommand(count, firstInstance);
+		break;
+	case MESH_TORUS:
+		command = m_basicMeshes->GetTorusMeshCommand(count, firstInstance, lodLevel);
+		break;
+	case MESH_CYLINDER:
+		command = m_basicMeshes->GetCylinderMeshCommand(count, firstInstance, lodLevel);
+		break;
+	case MESH_CONE:
+		command = m_basicMeshes->GetConeMeshCommand(count, firstInstance, lodLevel);
+		break;
 	}
+
+	return(command);
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  GetSceneObjectMeshLevels()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for getting the number of levels of
+ *  detail loaded for a basic mesh.  The flat meshes only
+ *  ever have the one.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+int SceneManager::GetSceneObjectMeshLevels(MESH_TYPE mesh)
 {
-	if (NULL != m_pShaderManager)
+	int levels = 1;
+
+	switch (mesh)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+	case MESH_TORUS:
+		levels = m_basicMeshes->GetTorusMeshLevels();
+		break;
+	case MESH_CYLINDER:
+		levels = m_basicMeshes->GetCylinderMeshLevels();
+		break;
+	case MESH_CONE:
+		levels = m_basicMeshes->GetConeMeshLevels();
+		break;
+	default:
+		break;
 	}
+
+	return((levels > 1) ? levels : 1);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  GetPixelRadius()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for getting the radius in pixels of
+ *  the bounding sphere of a render list entry.  An entry
+ *  whose center is not in front of the camera gets -1.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+float SceneManager::GetPixelRadius(const SCENE_OBJECT& object, float pixelScale) const
 {
-	if (m_objectMaterials.size() > 0)
+	// the clip space w of the sphere center is its distance in
+	// front of a perspective camera, and 1 for orthographic
+	glm::vec4 viewCenter = m_viewMatrix * glm::vec4(object.worldBounds.sphereCenter, 1.0f);
+	float clipW = m_projectionMatrix[2][3] * viewCenter.z + m_projectionMatrix[3][3];
+	if (clipW <= 0.0f)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
+		return(-1.0f);
 	}
-}
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
+	return(object.worldBounds.sphereRadius * pixelScale / clipW);
+}
 
 /***********************************************************
- *  LoadSceneTextures()
+ *  SelectLevelOfDetail()
  *
- *  This method loads textures from image files and binds
- *  them to OpenGL texture slots for rendering.
+ *  This method is used for picking the level of detail of a
+ *  render list entry from the radius of its bounding sphere
+ *  in pixels.  A level is only left once the radius is
+ *  clearly past its threshold, so an object sitting right on
+ *  a threshold does not flicker between two levels.  The GPU
+ *  culling path does not sort every frame, so it always
+ *  draws the finest level, and tessellated shapes pick their
+ *  own detail on the GPU.
  ***********************************************************/
-void SceneManager::LoadSceneTextures()
+void SceneManager::SelectLevelOfDetail(SCENE_OBJECT& object, float pixelScale)
 {
-		bool bReturn = false;
+	int levels = GetSceneObjectMeshLevels(object.mesh);
+	if ((levels <= 1) || (m_bGpuCulling == true) ||
+		((IsTessellating() == true) && (IsCurvedMesh(object.mesh) == true)))
+	{
+		object.lodLevel = 0;
+		return;
+	}
 
-		// Load textures for the scene
-		bReturn = CreateGLTexture("texture/Blacktable.jpg", "black");
-		bReturn = CreateGLTexture("texture/Metalclip.jpg", "metal");
-		bReturn = CreateGLTexture("texture/wood.jpg", "wood");
-		bReturn = CreateGLTexture("texture/keyboard.jpeg", "keyboard");
-		bReturn = CreateGLTexture("texture/Screen.jpeg", "Screen");
-		bReturn = CreateGLTexture("texture/MugBLACK.jpg", "Mug");
-		bReturn = CreateGLTexture("texture/Coffee.jpeg", "Coffee");
-		bReturn = CreateGLTexture("texture/PEN.jpg", "Pen");
-		bReturn = CreateGLTexture("texture/Screen2.jpg", "Screen2");
+	float pixelRadius = GetPixelRadius(object, pixelScale);
+	if (pixelRadius < 0.0f)
+	{
+		object.lodLevel = 0;
+		return;
+	}
 
-		// Bind the loaded textures to texture slots
-		BindGLTextures();
-	
+	int level = glm::clamp(object.lodLevel, 0, levels - 1);
+
+	// move to a finer level once the radius is well above its
+	// threshold, or to a coarser one once it is well below
+	while ((level > 0) &&
+		(pixelRadius >= LOD_PIXEL_RADII[level - 1] * (1.0f + LOD_HYSTERESIS)))
+	{
+		level--;
+	}
+	while ((level < levels - 1) &&
+		(pixelRadius < LOD_PIXEL_RADII[level] * (1.0f - LOD_HYSTERESIS)))
+	{
+		level++;
+	}
+
+	object.lodLevel = level;
 }
 
 /***********************************************************
- *  DefineObjectMaterials()
+ *  SelectImpostor()
  *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
+ *  This method is used for deciding whether a render list
+ *  entry is drawn as its impostor this frame.  Only opaque
+ *  entries with a baked impostor qualify, and like the level
+ *  of detail, an entry only switches once its size on screen
+ *  is clearly past the threshold.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+bool SceneManager::SelectImpostor(SCENE_OBJECT& object, float pixelScale)
 {
-	OBJECT_MATERIAL goldMaterial;
-	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.ambientStrength = 0.3f;
-	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	goldMaterial.shininess = 22.0;
-	goldMaterial.tag = "metal";
-
-	m_objectMaterials.push_back(goldMaterial);
-
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.ambientStrength = 0.2f;
-	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.shininess = 0.3;
-	woodMaterial.tag = "wood";
-
-	m_objectMaterials.push_back(woodMaterial);
+	float pixelRadius = -1.0f;
+	if ((object.impostorIndex >= 0) && (object.bTranslucent == false))
+	{
+		pixelRadius = GetPixelRadius(object, pixelScale);
+	}
+	if (pixelRadius < 0.0f)
+	{
+		object.bImpostor = false;
+		return(false);
+	}
 
-	OBJECT_MATERIAL glassMaterial;
-	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	glassMaterial.ambientStrength = 0.3f;
-	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	glassMaterial.shininess = 85.0;
-	glassMaterial.tag = "glass";
+	float threshold = m_impostorPixelRadius *
+		((object.bImpostor == true) ? (1.0f + LOD_HYSTERESIS) : (1.0f - LOD_HYSTERESIS));
+	object.bImpostor = (pixelRadius < threshold);
 
-	m_objectMaterials.push_back(glassMaterial);
+	return(object.bImpostor);
 }
 
 /***********************************************************
- *  SetupSceneLights()
+ *  IsDrawingImpostors()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  This method is used for checking whether the distant
+ *  objects are drawn as impostors this frame.  The GPU
+ *  culling path does not sort every frame, so like the
+ *  levels of detail, the impostors are left out of it.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+bool SceneManager::IsDrawingImpostors() const
 {
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting - to use the default rendered 
-	// lighting then comment out the following line
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// Light Source 1 (Main overhead light)
-	m_pShaderManager->setVec3Value("lightSources[0].position", 42.0f, 25.0f, 3.0f);  // Positioned directly above the table
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.1f, 0.1f, 0.1f);  // Ambient light to soften shadows
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.4f, 0.4f, 0.4f);  // Softer diffuse light
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.2f, 0.2f, 0.2f);  // Specular reflection for slight shine
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 64.0f);           // Increased focal strength for wider coverage
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.4f);        // Slight specular intensity
+	return((m_bImpostors == true) && (m_bGpuCulling == false) &&
+		(m_impostorAtlas.GetImpostorCount() > 0));
+}
 
-	// Light Source 2 (Side fill light)
-	m_pShaderManager->setVec3Value("lightSources[1].position", -16.0f, 6.0f, -4.0f);  // Positioned to the side to fill in shadows
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.3f, 0.3f, 0.3f);  // Softer light for shadow fill
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.15f, 0.15f, 0.15f);
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 48.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.3f);
+/***********************************************************
+ *  IsTessellating()
+ *
+ *  This method is used for checking whether the curved shapes
+ *  are drawn as tessellated patches this frame.  The GPU
+ *  culling path writes every indirect command itself, so the
+ *  precomputed meshes are drawn while it is on.
+ ***********************************************************/
+bool SceneManager::IsTessellating() const
+{
+	return((m_bTessellation == true) && (m_bGpuCulling == false));
+}
 
-	// Light Source 3 (Front fill light for shadow reduction)
-	m_pShaderManager->setVec3Value("lightSources[2].position", 16.0f, 5.0f, -10.0f);  // Positioned in front to reduce shadows
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 0.3f, 0.3f, 0.3f);
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 0.2f);
+/***********************************************************
+ *  IsCurvedMesh()
+ *
+ *  This method is used for checking whether a basic mesh can
+ *  be drawn as tessellated patches.
+ ***********************************************************/
+bool SceneManager::IsCurvedMesh(MESH_TYPE mesh)
+{
+	return((mesh == MESH_TORUS) || (mesh == MESH_CYLINDER) || (mesh == MESH_CONE));
 }
 
 /***********************************************************
- *  PrepareScene()
+ *  SetObjectMaterial()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for changing the values of a defined
+ *  material.  Every object that uses the material refers to
+ *  it by index, so only the material buffer is uploaded again
+ *  before the next frame is drawn, unless a change of opacity
+ *  moves objects between the opaque and translucent draws.
  ***********************************************************/
-void SceneManager::PrepareScene()
+bool SceneManager::SetObjectMaterial(
+	const std::string& materialTag,
+	const OBJECT_MATERIAL& material)
 {
-	// Load the textures for the 3D scene
-	LoadSceneTextures();
+	int materialIndex = FindMaterialIndex(materialTag);
+	if (materialIndex < 0)
+	{
+		std::cout << "ERROR: no material is defined with the tag " << materialTag << std::endl;
+		return(false);
+	}
 
-	// define the materials that will be used for the objects
-	// in the 3D scene
-	DefineObjectMaterials();
-	// add and defile the light sources for the 3D scene
-	SetupSceneLights();
+	OBJECT_MATERIAL& definedMaterial = m_objectMaterials[materialIndex];
+	definedMaterial.ambientColor = material.ambientColor;
+	definedMaterial.ambientStrength = material.ambientStrength;
+	definedMaterial.diffuseColor = material.diffuseColor;
+	definedMaterial.specularColor = material.specularColor;
+	definedMaterial.shininess = material.shininess;
+	definedMaterial.opacity = material.opacity;
+	m_bMaterialsDirty = true;
 
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	for (SCENE_OBJECT& object : m_sceneObjects)
+	{
+		bool bTranslucent = IsTranslucent(object.color, object.materialIndex);
+		if ((object.materialIndex == materialIndex) && (object.bTranslucent != bTranslucent))
+		{
+			object.bTranslucent = bTranslucent;
+			m_bDrawBatchesDirty = true;
+		}
+	}
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadTorusMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadCylinderMesh();
+	return(true);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  IsTranslucent()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for classifying an object as opaque
+ *  or translucent from the alpha of its color and the
+ *  opacity of its material.
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::IsTranslucent(const glm::vec4& color, int materialIndex) const
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	//Desk
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(10.0f, 1.0f, 10.0f);
+	if (color.a < 1.0f)
+	{
+		return(true);
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	return((materialIndex >= 0) &&
+		(materialIndex < (int)m_objectMaterials.size()) &&
+		(m_objectMaterials[materialIndex].opacity < 1.0f));
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.5f, 0.0f, 0.0f);
+/***********************************************************
+ *  UploadObjectMaterials()
+ *
+ *  This method is used for packing every defined material
+ *  into the material buffer, in the same order as the
+ *  material indices the render list entries refer to.
+ ***********************************************************/
+void SceneManager::UploadObjectMaterials()
+{
+	std::vector<MATERIAL_DATA> materials;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (const OBJECT_MATERIAL& material : m_objectMaterials)
+	{
+		MATERIAL_DATA materialData;
+		materialData.ambientColorStrength = glm::vec4(material.ambientColor, material.ambientStrength);
+		materialData.diffuseColor = glm::vec4(material.diffuseColor, material.opacity);
+		materialData.specularColorShininess = glm::vec4(material.specularColor, material.shininess);
+		materials.push_back(materialData);
+	}
 
-	//SetShaderColor(0.506, 0.506, 1, 0.506);
+	m_bMaterialsDirty = false;
+	if (materials.empty())
+	{
+		return;
+	}
 
-	SetShaderTexture("black");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	if (m_materialBuffer == 0)
+	{
+		glGenBuffers(1, &m_materialBuffer);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(MATERIAL_DATA) * materials.size(), materials.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
+/***********************************************************
+ *  GetSceneObjectMeshBounds()
+ *
+ *  This method is used for getting the local bounding volume
+ *  of a basic mesh.
+ ***********************************************************/
+const BOUNDING_VOLUME& SceneManager::GetSceneObjectMeshBounds(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		return(m_basicMeshes->GetBoxMeshBounds());
+	case MESH_TORUS:
+		return(m_basicMeshes->GetTorusMeshBounds());
+	case MESH_CYLINDER:
+		return(m_basicMeshes->GetCylinderMeshBounds());
+	case MESH_CONE:
+		return(m_basicMeshes->GetConeMeshBounds());
+	case MESH_PLANE:
+	default:
+		return(m_basicMeshes->GetPlaneMeshBounds());
+	}
+}
 
-	//Clipboard
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(4.0f, 0.20f, 3.0f);
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the view and projection
+ *  matrices of the frame being rendered.  The view matrix
+ *  orders the draws and the frustum planes cull them.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewProjection = projection * view;
+	m_frustum.ExtractPlanes(m_viewProjection);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 80.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SetGpuCulling()
+ *
+ *  This method is used for turning the GPU culling path on
+ *  or off.  It stays off when the driver is older than
+ *  OpenGL 4.5 or the compute shaders do not build.  The
+ *  paths that change the draws on the CPU every frame are
+ *  left out while it is on, with a warning for each.
+ ***********************************************************/
+void SceneManager::SetGpuCulling(bool bEnabled)
+{
+	if (bEnabled == false)
+	{
+		// the GPU path wrote over the instances and commands
+		if (m_bGpuCulling == true)
+		{
+			m_bDrawBatchesDirty = true;
+		}
+		m_bGpuCulling = false;
+		return;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.65f, -1.65f, 5.0f);
+	if (GpuCulling::IsSupported() == false)
+	{
+		std::cout << "WARNING: GPU culling needs OpenGL 4.5, GPU culling stays off" << std::endl;
+		return;
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	if (m_gpuCulling.Initialize(
+		"shaders/cullComputeShader.glsl",
+		"shaders/compactComputeShader.glsl",
+		"shaders/depthPyramidComputeShader.glsl") == false)
+	{
+		std::cout << "WARNING: GPU culling shaders could not be loaded, GPU culling stays off" << std::endl;
+		return;
+	}
 
-	//SetShaderColor(0.506, 0.506, 1, 0.506);
+	m_bGpuCulling = true;
+	m_bDrawBatchesDirty = true;
 
-	SetShaderTexture("wood");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	std::cout << "WARNING: GPU culling draws every mesh at its finest level of detail" << std::endl;
+	if (m_bTessellation == true)
+	{
+		std::cout << "WARNING: GPU culling draws the precomputed curved meshes, tessellated meshes stay off" << std::endl;
+	}
+	if (m_bImpostors == true)
+	{
+		std::cout << "WARNING: GPU culling draws the full meshes, impostors stay off" << std::endl;
+	}
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+/***********************************************************
+ *  SetTessellatedMeshes()
+ *
+ *  This method is used for switching the torus, cylinder and
+ *  cone between the precomputed meshes and the tessellated
+ *  patches.  The patches stay off when the driver has no
+ *  tessellation shaders or they do not build.
+ ***********************************************************/
+void SceneManager::SetTessellatedMeshes(bool bEnabled)
+{
+	if (bEnabled == m_bTessellation)
+	{
+		return;
+	}
 
-	//Note pad
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
+	if (bEnabled == true)
+	{
+		if (TessellatedMeshes::IsSupported() == false)
+		{
+			std::cout << "WARNING: tessellation shaders are not supported, tessellated meshes stay off" << std::endl;
+			return;
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 80.0f;
-	ZrotationDegrees = 0.0f;
+		if (m_tessellatedMeshes.Initialize(
+			m_basicMeshes,
+			TORUS_THICKNESS,
+			"shaders/tessellationSurfaces.glsl",
+			"shaders/tessellationVertexShader.glsl",
+			"shaders/tessellationControlShader.glsl",
+			"shaders/tessellationEvaluationShader.glsl",
+			"shaders/fragmentShader.glsl") == false)
+		{
+			std::cout << "WARNING: tessellation shaders could not be loaded, tessellated meshes stay off" << std::endl;
+			return;
+		}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.65f, -1.5f, 5.0f);
+		size_t meshBytes = m_basicMeshes->GetTorusMeshBytes() +
+			m_basicMeshes->GetCylinderMeshBytes() +
+			m_basicMeshes->GetConeMeshBytes();
+		std::cout << "INFO: tessellated patches use " << m_tessellatedMeshes.GetPatchBytes()
+			<< " bytes in place of " << meshBytes << " bytes of curved meshes" << std::endl;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		if (m_bGpuCulling == true)
+		{
+			std::cout << "WARNING: GPU culling draws the precomputed curved meshes, tessellated meshes stay off" << std::endl;
+		}
+	}
 
-	SetShaderColor(1, 1, 1, 1);
+	m_bTessellation = bEnabled;
+	m_bDrawBatchesDirty = true;
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+/***********************************************************
+ *  SetDepthPrepass()
+ *
+ *  This method is used for turning the depth pre-pass of the
+ *  opaque draws on or off.
+ ***********************************************************/
+void SceneManager::SetDepthPrepass(bool bEnabled)
+{
+	if ((bEnabled == true) && (m_depthPrepass.Initialize(
+		"shaders/depthVertexShader.glsl",
+		"shaders/depthFragmentShader.glsl") == false))
+	{
+		std::cout << "WARNING: depth pre-pass shaders could not be loaded, the depth pre-pass stays off" << std::endl;
+		return;
+	}
 
-	//Clipboard Clip
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.0f, 1.0f, 0.5f);
+	m_bDepthPrepass = bEnabled;
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 170.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SetWeightedBlendedOit()
+ *
+ *  This method is used for switching the translucent draws
+ *  between sorted blending and weighted blended
+ *  order-independent transparency.  The translucent entries
+ *  no longer sort by depth with it on, so the draw batches
+ *  are built again either way.
+ ***********************************************************/
+void SceneManager::SetWeightedBlendedOit(bool bEnabled)
+{
+	if (bEnabled == true)
+	{
+		bool bLoaded = m_weightedBlendedOit.Initialize(
+			"shaders/oitCompositeVertexShader.glsl",
+			"shaders/oitCompositeFragmentShader.glsl");
+		m_pShaderManager->use();
+		if (bLoaded == false)
+		{
+			std::cout << "WARNING: transparency composite shaders could not be loaded, sorted blending stays on" << std::endl;
+			return;
+		}
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.35f, -1.75f, 3.35f);
+	m_bWeightedBlendedOit = bEnabled;
+	m_bDrawBatchesDirty = true;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  SetImpostors()
+ *
+ *  This method is used for turning the impostors of the
+ *  distant curved objects on or off.  The impostors are
+ *  loaded from the cache file or baked the first time they
+ *  are turned on, and stay off when their shaders do not
+ *  build.
+ ***********************************************************/
+void SceneManager::SetImpostors(bool bEnabled)
+{
+	if ((bEnabled == true) && (m_impostorAtlas.GetImpostorCount() == 0))
+	{
+		if (m_impostorAtlas.Initialize(
+			"shaders/vertexShader.glsl",
+			"shaders/impostorBakeFragmentShader.glsl",
+			"shaders/impostorVertexShader.glsl",
+			"shaders/impostorFragmentShader.glsl") == false)
+		{
+			std::cout << "WARNING: impostor shaders could not be loaded, impostors stay off" << std::endl;
+			return;
+		}
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+		// the views are baked from the real images, so every
+		// texture has to be decoded and uploaded first
+		UploadDecodedTextures(true);
+		BuildImpostors();
+	}
+	if ((bEnabled == true) && (m_bGpuCulling == true))
+	{
+		std::cout << "WARNING: GPU culling draws the full meshes, impostors stay off" << std::endl;
+	}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	m_bImpostors = bEnabled;
+	m_bDrawBatchesDirty = true;
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+/***********************************************************
+ *  SetImpostorPixelRadius()
+ *
+ *  This method is used for setting the bounding sphere
+ *  radius in pixels below which objects are drawn as their
+ *  impostors.  Past the size of one baked view the quads
+ *  start to look blurry.
+ ***********************************************************/
+void SceneManager::SetImpostorPixelRadius(float pixels)
+{
+	m_impostorPixelRadius = (pixels > 0.0f) ? pixels : 0.0f;
+}
 
-	//Notepad Ring T1
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.1f, 0.15f);
+/***********************************************************
+ *  SetCompressedTextures()
+ *
+ *  This method is used for choosing whether the images are
+ *  read from and written to block compressed caches.  With
+ *  them off every texture stays RGBA8, coming from the
+ *  decoded texture cache or the image files.  The textures
+ *  are loaded once, so this only has an effect before the
+ *  scene is prepared.
+ ***********************************************************/
+void SceneManager::SetCompressedTextures(bool bEnabled)
+{
+	if (m_textureIDs.empty() == false)
+	{
+		std::cout << "WARNING: the textures are already loaded, the compressed texture setting is ignored" << std::endl;
+		return;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_bCompressedTextures = (bEnabled == true) && (CompressedTextureCache::IsSupported() == true);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-5.65f, -0.95f, 3.5f);
+/***********************************************************
+ *  SetTextureAnisotropy()
+ *
+ *  This method is used for setting the samples taken along
+ *  textures seen at a glancing angle, 1 for plain trilinear
+ *  filtering.  The shared sampler is replaced, so it is
+ *  bound again or its bindless handles are made again.
+ ***********************************************************/
+void SceneManager::SetTextureAnisotropy(float anisotropy)
+{
+	if (m_textureSamplers.GetSampler(TextureSamplers::SAMPLER_ANISOTROPIC) == 0)
+	{
+		m_textureSamplers.Initialize(anisotropy);
+		return;
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_textureSamplers.SetAnisotropy(anisotropy);
+	MakeTextureHandles();
+	BindGLTextures();
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	std::cout << "INFO: Textures filtered with " << m_textureSamplers.GetAnisotropy() << "x anisotropy" << std::endl;
+}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+/***********************************************************
+ *  RunTextureBenchmark()
+ *
+ *  This method is used for timing the largest scene texture
+ *  drawn at increasing distances with and without its
+ *  mipmaps, once every texture has been uploaded.  The scene
+ *  program and texture bindings are restored afterwards.
+ ***********************************************************/
+void SceneManager::RunTextureBenchmark()
+{
+	UploadDecodedTextures(true);
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	int largestArray = -1;
+	for (int arrayIndex = 0; arrayIndex < (int)m_textureArrays.size(); arrayIndex++)
+	{
+		if ((largestArray < 0) ||
+			(m_textureArrays[arrayIndex].width * m_textureArrays[arrayIndex].height >
+			m_textureArrays[largestArray].width * m_textureArrays[largestArray].height))
+		{
+			largestArray = arrayIndex;
+		}
+	}
+	if (largestArray < 0)
+	{
+		std::cout << "WARNING: no textures are loaded for the texture benchmark" << std::endl;
+		return;
+	}
 
-	//Notepad Ring T2
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.1f, 0.15f);
+	const TEXTURE_ARRAY& textureArray = m_textureArrays[largestArray];
+	m_textureSamplers.RunBenchmark(textureArray.ID, textureArray.width, textureArray.height);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_pShaderManager->use();
+	m_pUniformCache->Invalidate();
+	BindGLTextures();
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-5.8f, -1.22f, 4.25f);
+/***********************************************************
+ *  BuildImpostors()
+ *
+ *  This method is used for finding every distinct shape of
+ *  the opaque curved objects in the render list - the same
+ *  mesh, scale, texture and color - and giving each one an
+ *  impostor.  Objects that only differ by their position,
+ *  rotation or material share one, so a replicated scene
+ *  needs few of them.  The atlas is read from the cache file
+ *  when it still matches the scene, and is otherwise baked
+ *  and written back to it.
+ ***********************************************************/
+void SceneManager::BuildImpostors()
+{
+	m_impostorSources.clear();
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (SCENE_OBJECT& object : m_sceneObjects)
+	{
+		object.impostorIndex = -1;
+		object.bImpostor = false;
+		if ((IsCurvedMesh(object.mesh) == false) || (object.bTranslucent == true))
+		{
+			continue;
+		}
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+		int impostorIndex = 0;
+		while ((impostorIndex < (int)m_impostorSources.size()) &&
+			((m_impostorSources[impostorIndex].mesh != object.mesh) ||
+			(m_impostorSources[impostorIndex].scaleXYZ != object.scaleXYZ) ||
+			(m_impostorSources[impostorIndex].textureSlot != object.textureSlot) ||
+			(m_impostorSources[impostorIndex].uvScale != object.uvScale) ||
+			(m_impostorSources[impostorIndex].color != object.color)))
+		{
+			impostorIndex++;
+		}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+		if (impostorIndex == (int)m_impostorSources.size())
+		{
+			IMPOSTOR_SOURCE source;
+			source.mesh = object.mesh;
+			source.scaleXYZ = object.scaleXYZ;
+			source.textureSlot = object.textureSlot;
+			source.uvScale = object.uvScale;
+			source.color = object.color;
+			source.bakedBounds = TransformBoundingVolume(
+				GetSceneObjectMeshBounds(object.mesh),
+				CalculateModelMatrix(object.scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f)));
+			m_impostorSources.push_back(source);
+		}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+		object.impostorIndex = impostorIndex;
+	}
 
-	//Notepad Ring T3
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.1f, 0.15f);
+	if (m_impostorSources.empty())
+	{
+		return;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	uint64_t cacheKey = GetImpostorCacheKey();
+	int impostorCount = (int)m_impostorSources.size();
+	if (m_impostorAtlas.LoadCache(IMPOSTOR_CACHE_FILE, cacheKey, impostorCount) == true)
+	{
+		std::cout << "INFO: Loaded " << impostorCount << " impostors from " << IMPOSTOR_CACHE_FILE << std::endl;
+	}
+	else
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BakeImpostors();
+		m_impostorAtlas.SaveCache(IMPOSTOR_CACHE_FILE, cacheKey);
+		double bakeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "INFO: Baked " << impostorCount << " impostors in " << bakeMilliseconds << " ms" << std::endl;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-5.96f, -1.53f, 5.1f);
+	std::cout << "INFO: impostor atlas uses " << m_impostorAtlas.GetAtlasBytes() << " bytes" << std::endl;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  BakeImpostors()
+ *
+ *  This method is used for drawing every view of every
+ *  impostor into the atlas.  Each shape is set up as one
+ *  instance with its scale but no rotation or translation,
+ *  along with an indirect command and per-draw values of its
+ *  own, and drawn once per view.  The instance and command
+ *  buffers are written over, so the draw batches are built
+ *  again before the next frame.
+ ***********************************************************/
+void SceneManager::BakeImpostors()
+{
+	std::vector<SceneMeshes::INSTANCE_DATA> instances;
+	std::vector<SceneMeshes::DRAW_COMMAND> commands;
+	std::vector<DRAW_DATA> drawData;
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	for (int i = 0; i < (int)m_impostorSources.size(); i++)
+	{
+		const IMPOSTOR_SOURCE& source = m_impostorSources[i];
 
-	//SetShaderColor(1, 1, 1, 1);
+		SceneMeshes::INSTANCE_DATA instance;
+		instance.modelMatrix = CalculateModelMatrix(source.scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f));
+		instance.color = source.color;
+		instance.materialIndex = -1;
+		instances.push_back(instance);
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+		commands.push_back(GetSceneObjectCommand(source.mesh, 0, 1, i));
+		drawData.push_back(MakeDrawData(source.textureSlot, source.uvScale));
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	m_basicMeshes->SetInstanceData(instances);
+	m_basicMeshes->SetDrawCommands(commands);
 
-	//Notepad Ring T4
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.1f, 0.15f);
+	GLuint bakeDrawDataBuffer = 0;
+	glGenBuffers(1, &bakeDrawDataBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bakeDrawDataBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DRAW_DATA) * drawData.size(), drawData.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, bakeDrawDataBuffer);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_impostorAtlas.BeginBake((int)m_impostorSources.size());
+	for (int i = 0; i < (int)m_impostorSources.size(); i++)
+	{
+		const BOUNDING_VOLUME& bounds = m_impostorSources[i].bakedBounds;
+		for (int view = 0; view < ImpostorAtlas::VIEW_GRID * ImpostorAtlas::VIEW_GRID; view++)
+		{
+			m_impostorAtlas.BakeView(i, view, bounds.sphereCenter, bounds.sphereRadius, i);
+			m_basicMeshes->DrawIndirect(i, 1);
+		}
+	}
+	m_impostorAtlas.EndBake();
+	m_pShaderManager->use();
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-6.11f, -1.8f, 5.8f);
+	glDeleteBuffers(1, &bakeDrawDataBuffer);
+	m_bDrawBatchesDirty = true;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  GetImpostorCacheKey()
+ *
+ *  This method is used for hashing everything the baked
+ *  impostors depend on - the shape of every impostor, the
+ *  index count of its mesh, and the size and modification
+ *  time of every image file they are textured with - so a
+ *  cache file written for a different scene is never used.
+ ***********************************************************/
+uint64_t SceneManager::GetImpostorCacheKey()
+{
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashBytes(hash, &TORUS_THICKNESS, sizeof(TORUS_THICKNESS));
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	for (const IMPOSTOR_SOURCE& source : m_impostorSources)
+	{
+		GLuint meshIndices = GetSceneObjectCommand(source.mesh, 0, 1, 0).count;
+		hash = HashBytes(hash, &source.mesh, sizeof(source.mesh));
+		hash = HashBytes(hash, &source.scaleXYZ, sizeof(source.scaleXYZ));
+		hash = HashBytes(hash, &source.uvScale, sizeof(source.uvScale));
+		hash = HashBytes(hash, &source.color, sizeof(source.color));
+		hash = HashBytes(hash, &meshIndices, sizeof(meshIndices));
+
+		if (source.textureSlot >= 0)
+		{
+			const std::string& filename = m_textureIDs[source.textureSlot].filename;
+			hash = HashBytes(hash, filename.c_str(), filename.size() + 1);
+
+			struct stat fileStatus;
+			if (stat(filename.c_str(), &fileStatus) == 0)
+			{
+				int64_t fileSize = (int64_t)fileStatus.st_size;
+				int64_t modifiedTime = (int64_t)fileStatus.st_mtime;
+				hash = HashBytes(hash, &fileSize, sizeof(fileSize));
+				hash = HashBytes(hash, &modifiedTime, sizeof(modifiedTime));
+			}
+		}
+	}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	return(hash);
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+/***********************************************************
+ *  MakeDrawData()
+ *
+ *  This method is used for making the per-draw values that
+ *  select the texture array layer and UV scale of a draw.
+ ***********************************************************/
+SceneManager::DRAW_DATA SceneManager::MakeDrawData(int textureSlot, const glm::vec2& uvScale) const
+{
+	DRAW_DATA drawData = {};
+	drawData.uvScale = uvScale;
+	drawData.textureArray = -1;
+	if (textureSlot >= 0)
+	{
+		drawData.textureArray = m_textureIDs[textureSlot].arrayIndex;
+		drawData.textureLayer = m_textureIDs[textureSlot].layer;
+	}
 
-//Notepad Ring T5
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.1f, 0.15f);
+	return(drawData);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  IsDepthPrepassing()
+ *
+ *  This method is used for checking whether the opaque draws
+ *  get a depth pre-pass this frame.
+ ***********************************************************/
+bool SceneManager::IsDepthPrepassing() const
+{
+	return(m_bDepthPrepass == true);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-6.19f, -1.98f, 6.3f);
+/***********************************************************
+ *  SetOcclusionCulling()
+ *
+ *  This method is used for turning occlusion culling on or
+ *  off.  Turning it on starts every object out as visible.
+ ***********************************************************/
+void SceneManager::SetOcclusionCulling(bool bEnabled)
+{
+	if ((bEnabled == true) && (m_bOcclusionCulling == false))
+	{
+		m_occlusionCulling.Resize((int)m_sceneObjects.size());
+	}
+	m_bOcclusionCulling = bEnabled;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the nearest render list
+ *  entry whose bounding box is hit by a ray, such as a ray
+ *  cast from the camera through the mouse cursor.
+ ***********************************************************/
+int SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction)
+{
+	float hitDistance = 0.0f;
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	return(m_objectHierarchy.QueryRay(origin, direction, hitDistance));
+}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+/***********************************************************
+ *  FindObjectsNear()
+ *
+ *  This method is used for finding the render list entries
+ *  whose bounding box is within a radius of a point.
+ ***********************************************************/
+void SceneManager::FindObjectsNear(
+	const glm::vec3& center,
+	float radius,
+	std::vector<int>& objectIndices)
+{
+	m_objectHierarchy.QuerySphere(center, radius, objectIndices);
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+/***********************************************************
+ *  SetObjectTransformations()
+ *
+ *  This method is used for changing the transformation values
+ *  of an object in the render list.  The model matrix is not
+ *  recalculated here - the object is flagged dirty and its
+ *  matrix is rebuilt once before the next frame is drawn.
+ ***********************************************************/
+void SceneManager::SetObjectTransformations(
+	int objectIndex,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_sceneObjects.size()))
+	{
+		return;
+	}
 
-	//Tall mug
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.45f, 0.45f, 7.0f);
+	SCENE_OBJECT& object = m_sceneObjects[objectIndex];
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 110.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// the impostor was baked at the old scale
+	if ((object.impostorIndex >= 0) &&
+		(m_impostorSources[object.impostorIndex].scaleXYZ != scaleXYZ))
+	{
+		object.impostorIndex = -1;
+		object.bImpostor = false;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.0f, -0.52f, 2.0f);
+	object.scaleXYZ = scaleXYZ;
+	object.XrotationDegrees = XrotationDegrees;
+	object.YrotationDegrees = YrotationDegrees;
+	object.ZrotationDegrees = ZrotationDegrees;
+	object.positionXYZ = positionXYZ;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// only queue the object once no matter how many times
+	// it is moved before the next frame
+	if (object.bTransformDirty == false)
+	{
+		object.bTransformDirty = true;
+		m_dirtyObjects.push_back(objectIndex);
+	}
+}
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
-	SetShaderTexture("Mug");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+/***********************************************************
+ *  SpinObjects()
+ *
+ *  This method is used for turning a share of the render
+ *  list about the Y axis through SetObjectTransformations(),
+ *  so that only the turned objects have their model matrix
+ *  rebuilt before the next frame.
+ ***********************************************************/
+void SceneManager::SpinObjects(int stride, float degrees)
+{
+	if (stride <= 0)
+	{
+		return;
+	}
 
-	//SetShaderColor(1, 1, 1, 1);
+	for (int i = 0; i < (int)m_sceneObjects.size(); i += stride)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		SetObjectTransformations(
+			i,
+			object.scaleXYZ,
+			object.XrotationDegrees,
+			object.YrotationDegrees + degrees,
+			object.ZrotationDegrees,
+			object.positionXYZ);
+	}
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+/***********************************************************
+ *  UpdateSceneTransforms()
+ *
+ *  This method is used for rebuilding the cached model matrix
+ *  and world bounds of every render list entry that has been
+ *  flagged dirty since the last frame.  Static objects are
+ *  never touched.
+ ***********************************************************/
+void SceneManager::UpdateSceneTransforms()
+{
+	for (int objectIndex : m_dirtyObjects)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+		object.modelMatrix = CalculateModelMatrix(
+			object.scaleXYZ,
+			object.XrotationDegrees,
+			object.YrotationDegrees,
+			object.ZrotationDegrees,
+			object.positionXYZ);
+		object.worldBounds = TransformBoundingVolume(GetSceneObjectMeshBounds(object.mesh), object.modelMatrix);
+		object.bTransformDirty = false;
+	}
 
-	//Tall mug handle
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.45f, 0.45f, 0.3f);
+	// refit the hierarchy above each moved object, or the whole
+	// hierarchy in one sweep when a large share of objects moved
+	if ((int)m_dirtyObjects.size() * 4 > (int)m_sceneObjects.size())
+	{
+		std::vector<BOUNDING_VOLUME> objectBounds;
+		objectBounds.reserve(m_sceneObjects.size());
+		for (const SCENE_OBJECT& object : m_sceneObjects)
+		{
+			objectBounds.push_back(object.worldBounds);
+		}
+		m_objectHierarchy.RefitAll(objectBounds);
+	}
+	else
+	{
+		for (int objectIndex : m_dirtyObjects)
+		{
+			m_objectHierarchy.RefitObject(objectIndex, m_sceneObjects[objectIndex].worldBounds);
+		}
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = -30.0f;
-	ZrotationDegrees = 0.0f;
+	// the GPU culling path keeps its uploaded render list and
+	// only writes over the entries that moved
+	if ((m_bGpuCulling == true) && (m_bDrawBatchesDirty == false))
+	{
+		UpdateCulledObjects();
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.45f, 0.15f, 2.15f);
+	m_renderStats.transformsRebuilt = (int)m_dirtyObjects.size();
+	m_dirtyObjects.clear();
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  UpdateCulledObjects()
+ *
+ *  This method is used for copying the new model matrix and
+ *  world bounds of every moved render list entry into its
+ *  instance in the GPU culling path, and uploading only the
+ *  runs of instances that changed.  Moving an entry does not
+ *  change its batch, so the render list is not sorted or
+ *  uploaded again, and the cost follows the number of moved
+ *  entries rather than the size of the scene.
+ ***********************************************************/
+void SceneManager::UpdateCulledObjects()
+{
+	std::vector<int> movedSlots;
+	movedSlots.reserve(m_dirtyObjects.size());
+	for (int objectIndex : m_dirtyObjects)
+	{
+		if ((objectIndex >= (int)m_instanceSlots.size()) || (m_instanceSlots[objectIndex] < 0))
+		{
+			continue;
+		}
+
+		const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+		int slot = m_instanceSlots[objectIndex];
+		m_instanceData[slot].modelMatrix = object.modelMatrix;
+		m_cullObjects[slot].aabbMin = object.worldBounds.aabbMin;
+		m_cullObjects[slot].aabbMax = object.worldBounds.aabbMax;
+		movedSlots.push_back(slot);
+	}
+	std::sort(movedSlots.begin(), movedSlots.end());
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
-	SetShaderTexture("Mug");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	// neighbouring instances are uploaded together
+	size_t first = 0;
+	while (first < movedSlots.size())
+	{
+		size_t last = first;
+		while ((last + 1 < movedSlots.size()) && (movedSlots[last + 1] == movedSlots[last] + 1))
+		{
+			last++;
+		}
+		m_gpuCulling.UpdateObjects(
+			m_instanceData,
+			m_cullObjects,
+			movedSlots[first],
+			movedSlots[last] - movedSlots[first] + 1);
+		first = last + 1;
+	}
+}
 
-	//SetShaderColor(1, 1, 0, 1);
+/***********************************************************
+ *  BuildObjectHierarchy()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy over the world bounds of every entry in the
+ *  render list.  Moved entries refit it afterwards.
+ ***********************************************************/
+void SceneManager::BuildObjectHierarchy()
+{
+	std::vector<BOUNDING_VOLUME> objectBounds;
+	objectBounds.reserve(m_sceneObjects.size());
+	for (const SCENE_OBJECT& object : m_sceneObjects)
+	{
+		objectBounds.push_back(object.worldBounds);
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	m_objectHierarchy.Build(objectBounds);
+}
 
-	//Tall mug liquid
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.45f, 1.0f, 0.4f);
+/***********************************************************
+ *  SortSceneObjects()
+ *
+ *  This method is used for submitting every render list entry
+ *  that is inside the view frustum to the render queue with a
+ *  key built from its translucency, texture, material and view
+ *  depth, and then sorting them so draws that share state are
+ *  submitted together.  The visible entries are found through
+ *  the bounding volume hierarchy, and when occlusion culling
+ *  is on, the entries that failed their last occlusion test
+ *  are skipped as well.  Entries drawn as impostors are
+ *  collected as impostor instances instead.
+ ***********************************************************/
+void SceneManager::SortSceneObjects()
+{
+	m_renderQueue.Clear();
+	m_impostorInstances.clear();
+	m_renderStats.occludedObjects = 0;
+	bool bImpostors = IsDrawingImpostors();
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 140.0f;
-	ZrotationDegrees = 0.0f;
+	// the GPU culling path culls the whole render list itself
+	if (m_bGpuCulling == true)
+	{
+		m_visibleObjects.resize(m_sceneObjects.size());
+		for (int i = 0; i < (int)m_sceneObjects.size(); i++)
+		{
+			m_visibleObjects[i] = i;
+		}
+	}
+	else
+	{
+		m_objectHierarchy.QueryFrustum(m_frustum, m_visibleObjects);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.0f, -0.22f, 2.15f);
+	// projected radii scale with the vertical focal length and
+	// half the viewport height
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float pixelScale = m_projectionMatrix[1][1] * 0.5f * (float)viewport[3];
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (int i : m_visibleObjects)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[i];
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+		if ((m_bOcclusionCulling == true) && (m_bGpuCulling == false))
+		{
+			bool bOccluded = m_occlusionCulling.IsOccluded(i);
+			// occluded entries still need testing to find out
+			// when they come back into view
+			m_occlusionCulling.QueueTest(i, object.worldBounds);
+			if (bOccluded == true)
+			{
+				m_renderStats.occludedObjects++;
+				continue;
+			}
+		}
 
-	SetShaderTexture("Coffee");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+		// a distant curved object is left out of the queue and
+		// drawn as one quad, turned to the baked view nearest
+		// the camera by the object's rotation
+		if ((bImpostors == true) && (SelectImpostor(object, pixelScale) == true))
+		{
+			const IMPOSTOR_SOURCE& source = m_impostorSources[object.impostorIndex];
+			glm::mat3 rotation(object.modelMatrix);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				rotation[axis] = glm::normalize(rotation[axis]);
+			}
+			glm::quat rotationQuat = glm::quat_cast(rotation);
+			glm::vec3 center = glm::vec3(object.modelMatrix[3]) + rotation * source.bakedBounds.sphereCenter;
+
+			ImpostorAtlas::IMPOSTOR_INSTANCE impostor;
+			impostor.centerRadius = glm::vec4(center, source.bakedBounds.sphereRadius);
+			impostor.rotation = glm::vec4(rotationQuat.x, rotationQuat.y, rotationQuat.z, rotationQuat.w);
+			impostor.layer = object.impostorIndex;
+			impostor.materialIndex = object.materialIndex;
+			m_impostorInstances.push_back(impostor);
+			continue;
+		}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
+		// the view space depth of the object's origin, the
+		// camera looks down the negative Z axis
+		glm::vec4 viewPosition = m_viewMatrix * object.modelMatrix[3];
+		float sortDepth = -viewPosition.z;
+		// weighted blending does not care about the order of the
+		// translucent entries, so they sort by state alone and
+		// camera moves do not force a new sort
+		if ((object.bTranslucent == true) && (m_bWeightedBlendedOit == true))
+		{
+			sortDepth = 0.0f;
+		}
 
-	//Small mug
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.4f, 0.4f, 2.5f);
+		SelectLevelOfDetail(object, pixelScale);
+
+		// each level of detail sorts as a mesh of its own
+		m_renderQueue.Submit(
+			RenderQueue::MakeSortKey(
+				object.bTranslucent,
+				0,
+				object.textureSlot,
+				object.materialIndex,
+				object.mesh * SceneMeshes::MAX_LOD_LEVELS + object.lodLevel,
+				sortDepth),
+			i);
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 110.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_renderQueue.Sort();
+	m_renderStats.impostorsDrawn = (int)m_impostorInstances.size();
+	m_renderStats.visibleObjects = m_renderQueue.GetCount() + m_renderStats.impostorsDrawn;
+	m_renderStats.culledObjects = (int)m_sceneObjects.size() - (int)m_visibleObjects.size();
+	m_renderStats.stateChangesSaved = m_renderQueue.GetStateChangesSaved();
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.0f, -0.52f, 3.5f);
+/***********************************************************
+ *  BuildDrawBatches()
+ *
+ *  This method is used for walking the sorted render list and
+ *  grouping consecutive entries that share the same mesh,
+ *  level of detail, texture and UV scale into one instanced
+ *  draw.  The model matrix, color and material index of every
+ *  entry are collected in draw order and uploaded to the
+ *  instance buffer, so entries with different materials can
+ *  still share a draw.
+ ***********************************************************/
+void SceneManager::BuildDrawBatches()
+{
+	m_instanceData.clear();
+	m_drawBatches.clear();
+	m_cullObjects.clear();
+	m_instanceSlots.clear();
+	if (m_bGpuCulling == true)
+	{
+		m_instanceSlots.resize(m_sceneObjects.size(), -1);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (int i = 0; i < m_renderQueue.GetCount(); i++)
+	{
+		int objectIndex = m_renderQueue.GetObjectIndex(i);
+		const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
-	SetShaderTexture("Mug");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+		bool bNewBatch = true;
+		if (m_drawBatches.empty() == false)
+		{
+			const DRAW_BATCH& lastBatch = m_drawBatches.back();
+			bNewBatch = (lastBatch.mesh != object.mesh) ||
+				(lastBatch.bTranslucent != object.bTranslucent) ||
+				(lastBatch.lodLevel != object.lodLevel) ||
+				(lastBatch.textureSlot != object.textureSlot) ||
+				(lastBatch.uvScale != object.uvScale);
+			// the GPU fills in the instances of a batch in no
+			// particular order, so translucent entries are kept
+			// in batches of their own to stay back to front
+			if ((m_bGpuCulling == true) && (object.bTranslucent == true))
+			{
+				bNewBatch = true;
+			}
+		}
 
-	//SetShaderColor(1, 1, 1, 1);
+		if (bNewBatch)
+		{
+			DRAW_BATCH batch;
+			batch.mesh = object.mesh;
+			batch.bTranslucent = object.bTranslucent;
+			batch.lodLevel = object.lodLevel;
+			batch.textureSlot = object.textureSlot;
+			batch.uvScale = object.uvScale;
+			batch.firstInstance = (int)m_instanceData.size();
+			batch.instanceCount = 0;
+			m_drawBatches.push_back(batch);
+		}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+		SceneMeshes::INSTANCE_DATA instance;
+		instance.modelMatrix = object.modelMatrix;
+		instance.color = object.color;
+		instance.materialIndex = object.materialIndex;
+		m_instanceData.push_back(instance);
+		m_drawBatches.back().instanceCount++;
 
-	//Small mug liquid
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.3f, 0.35f, 0.45f);
+		if (m_bGpuCulling == true)
+		{
+			m_instanceSlots[objectIndex] = (int)m_instanceData.size() - 1;
+
+			GpuCulling::CULL_OBJECT cullObject;
+			cullObject.aabbMin = object.worldBounds.aabbMin;
+			cullObject.commandIndex = (GLuint)(m_drawBatches.size() - 1);
+			cullObject.aabbMax = object.worldBounds.aabbMax;
+			cullObject.padding = 0;
+			m_cullObjects.push_back(cullObject);
+		}
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 30.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_basicMeshes->SetInstanceData(m_instanceData);
+	UploadDrawCommands();
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.0f, -0.52f, 3.5f);
+	if (m_bGpuCulling == true)
+	{
+		m_gpuCulling.SetObjects(m_instanceData, m_cullObjects, m_drawCommands, m_opaqueCommandCount);
+	}
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  DrawIndirectCommands()
+ *
+ *  This method is used for drawing the uploaded indirect
+ *  commands in two passes.  The opaque commands sort front
+ *  to back and are drawn with blending off, so they keep the
+ *  full benefit of early depth testing.  After a depth
+ *  pre-pass they only shade the fragments that match the
+ *  depth already written, and the impostor quads follow
+ *  them.  With GPU culling on, the depth pyramid for the
+ *  next frame is built at that point, from the opaque depth
+ *  alone.  The translucent commands sort back to front and
+ *  are blended over them without writing depth, so they do
+ *  not hide one another, or are blended in any order with
+ *  weighted blended transparency.
+ ***********************************************************/
+void SceneManager::DrawIndirectCommands(bool bDepthPrepass)
+{
+	int commandCount = (int)m_drawCommands.size();
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	if (m_opaqueCommandCount > 0)
+	{
+		if (bDepthPrepass == true)
+		{
+			DepthPrepass::BeginEqualDepth();
+		}
+		DrawCommandRange(false);
+		if (bDepthPrepass == true)
+		{
+			DepthPrepass::EndEqualDepth();
+		}
+	}
+	DrawTessellatedBatches(false);
 
-	SetShaderTexture("Coffee");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	// the impostors are opaque and stand in for entries that
+	// were left out of the indirect commands
+	if (m_impostorInstances.empty() == false)
+	{
+		m_impostorAtlas.Draw(m_impostorInstances);
+		m_pShaderManager->use();
+		m_renderStats.drawCalls++;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
+	// the next frame is culled against this frame's depth, taken
+	// before any translucent surface is drawn, so nothing behind
+	// glass is culled
+	if (m_bGpuCulling == true)
+	{
+		m_gpuCulling.BuildDepthPyramid(m_viewProjection);
+		m_pShaderManager->use();
+	}
 
-	//Big Note pad
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(4.0f, 0.2f, 3.25f);
+	bool bAnyTranslucent = (commandCount > m_opaqueCommandCount);
+	for (const TESSELLATED_DRAW& draw : m_tessellatedDraws)
+	{
+		bAnyTranslucent = bAnyTranslucent || draw.bTranslucent;
+	}
+	if (bAnyTranslucent == false)
+	{
+		return;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 80.0f;
-	ZrotationDegrees = 0.0f;
+	if (m_bWeightedBlendedOit == true)
+	{
+		m_weightedBlendedOit.BeginAccumulation();
+		m_pUniformCache->setBoolValue(g_WeightedBlendedName, true);
+		DrawTranslucentCommands();
+		m_pUniformCache->setBoolValue(g_WeightedBlendedName, false);
+		m_weightedBlendedOit.EndAccumulation();
+
+		m_weightedBlendedOit.Composite();
+		m_pShaderManager->use();
+		m_renderStats.drawCalls++;
+	}
+	else
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+		DrawTranslucentCommands();
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+	}
+}
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(-4.65f, -1.5f, 5.0f);
-	positionXYZ = glm::vec3(0.5f, -2.0f, 5.8f);
+/***********************************************************
+ *  DrawTranslucentCommands()
+ *
+ *  This method is used for drawing the translucent indirect
+ *  commands and tessellated batches with whichever blending
+ *  the caller has set up.
+ ***********************************************************/
+void SceneManager::DrawTranslucentCommands()
+{
+	if ((int)m_drawCommands.size() > m_opaqueCommandCount)
+	{
+		DrawCommandRange(true);
+	}
+	DrawTessellatedBatches(true);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  DrawCommandRange()
+ *
+ *  This method is used for drawing the opaque or the
+ *  translucent indirect commands with one call.  Commands
+ *  compacted by the GPU culling pass are drawn up to the
+ *  draw count the cull wrote for their range.
+ ***********************************************************/
+void SceneManager::DrawCommandRange(bool bTranslucent)
+{
+	int firstCommand = bTranslucent ? m_opaqueCommandCount : 0;
+	int commandCount = bTranslucent ? (int)m_drawCommands.size() - m_opaqueCommandCount : m_opaqueCommandCount;
 
-	SetShaderColor(1, 1, 1, 1);
+	// gl_DrawID starts from 0 again, so the shaders are told
+	// where the per-draw values of these commands start
+	m_pUniformCache->setIntValue(g_FirstDrawIDName, firstCommand);
+	if ((m_bGpuCulling == true) && (m_gpuCulling.IsCompacting() == true))
+	{
+		m_basicMeshes->DrawIndirectCount(
+			m_gpuCulling.GetDrawCountBuffer(),
+			GpuCulling::GetDrawCountOffset(bTranslucent),
+			firstCommand,
+			commandCount);
+	}
+	else
+	{
+		m_basicMeshes->DrawIndirect(firstCommand, commandCount);
+	}
+	m_renderStats.drawCalls++;
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+/***********************************************************
+ *  DrawTessellatedBatches()
+ *
+ *  This method is used for drawing the opaque or the
+ *  translucent batches of the curved shapes as tessellated
+ *  patches, one instanced draw each, reading the same
+ *  instance and per-draw values as the indirect draws.  They
+ *  follow the indirect draw of the same pass, so translucent
+ *  curved shapes blend over the other translucent objects
+ *  rather than in depth order.
+ ***********************************************************/
+void SceneManager::DrawTessellatedBatches(bool bTranslucent)
+{
+	bool bAnyDraws = false;
+	for (const TESSELLATED_DRAW& draw : m_tessellatedDraws)
+	{
+		bAnyDraws = bAnyDraws || (draw.bTranslucent == bTranslucent);
+	}
+	if (bAnyDraws == false)
+	{
+		return;
+	}
 
-	
+	// edge lengths are measured in pixels of the viewport
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
 
-	//Big Note pad cardboard
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(4.01f, 0.13f, 3.4f);
+	m_tessellatedMeshes.BeginDraws(viewport[2], viewport[3], bTranslucent && m_bWeightedBlendedOit);
+	for (const TESSELLATED_DRAW& draw : m_tessellatedDraws)
+	{
+		if (draw.bTranslucent != bTranslucent)
+		{
+			continue;
+		}
+
+		m_renderStats.drawCalls++;
+		switch (draw.mesh)
+		{
+		case MESH_TORUS:
+			m_tessellatedMeshes.DrawTorusPatchesInstanced(draw.drawIndex, draw.instanceCount, draw.firstInstance);
+			break;
+		case MESH_CYLINDER:
+			m_tessellatedMeshes.DrawCylinderPatchesInstanced(draw.drawIndex, draw.instanceCount, draw.firstInstance);
+			break;
+		case MESH_CONE:
+			m_tessellatedMeshes.DrawConePatchesInstanced(draw.drawIndex, draw.instanceCount, draw.firstInstance);
+			break;
+		default:
+			break;
+		}
+	}
+	m_tessellatedMeshes.EndDraws();
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  UploadDrawCommands()
+ *
+ *  This method is used for turning every draw batch into an
+ *  indirect draw command, along with the per-draw texture
+ *  and UV scale values that the shaders look up by gl_DrawID,
+ *  and uploading both so the whole render list is drawn with
+ *  a single call.  When the curved shapes are tessellated,
+ *  their commands are left with no instances and the batches
+ *  are drawn as patches after the indirect draw.
+ ***********************************************************/
+void SceneManager::UploadDrawCommands()
+{
+	m_drawCommands.clear();
+	m_drawData.clear();
+	m_tessellatedDraws.clear();
+	m_opaqueCommandCount = 0;
+	m_renderStats.trianglesDrawn = 0;
+	m_renderStats.trianglesSaved = 0;
+
+	for (const DRAW_BATCH& batch : m_drawBatches)
+	{
+		if (batch.bTranslucent == false)
+		{
+			m_opaqueCommandCount++;
+		}
+
+		if ((IsTessellating() == true) && (IsCurvedMesh(batch.mesh) == true))
+		{
+			TESSELLATED_DRAW draw;
+			draw.mesh = batch.mesh;
+			draw.bTranslucent = batch.bTranslucent;
+			draw.drawIndex = (int)m_drawCommands.size();
+			draw.firstInstance = batch.firstInstance;
+			draw.instanceCount = batch.instanceCount;
+			m_tessellatedDraws.push_back(draw);
+
+			m_drawCommands.push_back(
+				GetSceneObjectCommand(batch.mesh, 0, 0, batch.firstInstance));
+		}
+		else
+		{
+			m_drawCommands.push_back(
+				GetSceneObjectCommand(batch.mesh, batch.lodLevel, batch.instanceCount, batch.firstInstance));
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 80.0f;
-	ZrotationDegrees = 0.0f;
+		// compare against the same batch at the finest level,
+		// the tessellated batches draw no indexed instances
+		int drawnIndices = (int)m_drawCommands.back().count;
+		int drawnInstances = (int)m_drawCommands.back().instanceCount;
+		int finestIndices = (int)GetSceneObjectCommand(batch.mesh, 0, 1, 0).count;
+		m_renderStats.trianglesDrawn += (drawnIndices / 3) * drawnInstances;
+		m_renderStats.trianglesSaved += ((finestIndices - drawnIndices) / 3) * drawnInstances;
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(0.5f, -2.08f, 5.8f);
+		m_drawData.push_back(MakeDrawData(batch.textureSlot, batch.uvScale));
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_basicMeshes->SetDrawCommands(m_drawCommands);
 
-	//SetShaderColor(0.769, 0.384, 1, 0);
-	SetShaderTexture("wood");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	if (m_drawData.empty())
+	{
+		return;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+	if (m_drawDataBuffer == 0)
+	{
+		glGenBuffers(1, &m_drawDataBuffer);
+	}
 
-	//Notepad Ring ***T3***
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.12f, 0.1f, 0.15f);
+	// like the instance buffer, the storage only grows
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+	if (m_drawData.size() > m_drawDataCapacity)
+	{
+		m_drawDataCapacity = m_drawData.size();
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DRAW_DATA) * m_drawDataCapacity, m_drawData.data(), GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DRAW_DATA) * m_drawData.size(), m_drawData.data());
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 100.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SortTranslucentCommands()
+ *
+ *  This method is used for putting the translucent commands
+ *  of the GPU culling path back to front for the current
+ *  view, since that path only sorts the whole render list
+ *  when it changes.  Every translucent entry has a command
+ *  of its own, so only those commands, their per-draw values
+ *  and the command index of their instances are reordered
+ *  and uploaded, and only when the order has changed.  This
+ *  is the part of the path whose CPU cost grows with the
+ *  scene, with the number of glass objects.  Weighted blended transparency does not care about the
+ *  order, so nothing is done with it on.
+ ***********************************************************/
+void SceneManager::SortTranslucentCommands()
+{
+	int translucentCount = (int)m_drawCommands.size() - m_opaqueCommandCount;
+	if ((m_bWeightedBlendedOit == true) || (translucentCount <= 1))
+	{
+		return;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.8f, -1.32f, 4.0f);
+	// the depth of the instance origin, as the render queue
+	// sorts it, the camera looks down the negative Z axis
+	m_translucentOrder.resize(translucentCount);
+	for (int i = 0; i < translucentCount; i++)
+	{
+		const SceneMeshes::DRAW_COMMAND& command = m_drawCommands[m_opaqueCommandCount + i];
+		glm::vec4 viewPosition = m_viewMatrix * m_instanceData[command.baseInstance].modelMatrix[3];
+		m_translucentOrder[i].viewDepth = -viewPosition.z;
+		m_translucentOrder[i].command = i;
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// entries at the same depth keep their last order
+	std::stable_sort(m_translucentOrder.begin(), m_translucentOrder.end(),
+		[](const TRANSLUCENT_ORDER& a, const TRANSLUCENT_ORDER& b) { return(a.viewDepth > b.viewDepth); });
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	bool bReordered = false;
+	for (int i = 0; (i < translucentCount) && (bReordered == false); i++)
+	{
+		bReordered = (m_translucentOrder[i].command != i);
+	}
+	if (bReordered == false)
+	{
+		return;
+	}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	std::vector<SceneMeshes::DRAW_COMMAND> commands(translucentCount);
+	std::vector<DRAW_DATA> drawData(translucentCount);
+	for (int i = 0; i < translucentCount; i++)
+	{
+		commands[i] = m_drawCommands[m_opaqueCommandCount + m_translucentOrder[i].command];
+		drawData[i] = m_drawData[m_opaqueCommandCount + m_translucentOrder[i].command];
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	// the translucent instances come after every opaque one,
+	// so their bounds are one run at the end
+	int firstInstance = (int)m_instanceData.size();
+	for (int i = 0; i < translucentCount; i++)
+	{
+		m_drawCommands[m_opaqueCommandCount + i] = commands[i];
+		m_drawData[m_opaqueCommandCount + i] = drawData[i];
+		m_cullObjects[commands[i].baseInstance].commandIndex = (GLuint)(m_opaqueCommandCount + i);
+		firstInstance = glm::min(firstInstance, (int)commands[i].baseInstance);
+	}
 
-	//Notepad Ring **T2**
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.12f, 0.1f, 0.15f);
+	m_gpuCulling.UpdateCommands(m_drawCommands, m_opaqueCommandCount, translucentCount);
+	m_gpuCulling.UpdateObjects(m_instanceData, m_cullObjects, firstInstance, (int)m_instanceData.size() - firstInstance);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+	glBufferSubData(
+		GL_SHADER_STORAGE_BUFFER,
+		sizeof(DRAW_DATA) * m_opaqueCommandCount,
+		sizeof(DRAW_DATA) * translucentCount,
+		&m_drawData[m_opaqueCommandCount]);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 100.0f;
-	ZrotationDegrees = 0.0f;
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.15f, -1.25f, 3.9f);
+/***********************************************************
+ *  LoadSceneTextures()
+ *
+ *  This method queues textures to be loaded from image files
+ *  on worker threads and binds them to OpenGL texture slots
+ *  for rendering.
+ ***********************************************************/
+void SceneManager::LoadSceneTextures()
+{
+		bool bReturn = false;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		// Load textures for the scene
+		bReturn = CreateGLTexture("texture/Blacktable.jpg", "black");
+		bReturn = CreateGLTexture("texture/Metalclip.jpg", "metal");
+		bReturn = CreateGLTexture("texture/wood.jpg", "wood");
+		bReturn = CreateGLTexture("texture/keyboard.jpeg", "keyboard");
+		bReturn = CreateGLTexture("texture/Screen.jpeg", "Screen");
+		bReturn = CreateGLTexture("texture/MugBLACK.jpg", "Mug");
+		bReturn = CreateGLTexture("texture/Coffee.jpeg", "Coffee");
+		bReturn = CreateGLTexture("texture/PEN.jpg", "Pen");
+		bReturn = CreateGLTexture("texture/Screen2.jpg", "Screen2");
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+		// Create the texture arrays with placeholder layers and
+		// make the arrays visible to the shaders, the decoded
+		// images are uploaded as they arrive while rendering
+		BuildTextureArrays();
+		BindGLTextures();
+	
+}
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	OBJECT_MATERIAL goldMaterial;
+	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.ambientStrength = 0.3f;
+	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	goldMaterial.shininess = 22.0;
+	goldMaterial.opacity = 1.0f;
+	goldMaterial.tag = "metal";
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	m_objectMaterials.push_back(goldMaterial);
 
-	//Notepad Ring *T1*
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.12f, 0.1f, 0.15f);
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.ambientStrength = 0.2f;
+	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.shininess = 0.3;
+	woodMaterial.opacity = 1.0f;
+	woodMaterial.tag = "wood";
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 94.0f;
-	ZrotationDegrees = 0.0f;
+	m_objectMaterials.push_back(woodMaterial);
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-0.45f, -1.23f, 3.8f);
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	glassMaterial.ambientStrength = 0.3f;
+	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	glassMaterial.shininess = 85.0;
+	glassMaterial.opacity = 1.0f;
+	glassMaterial.tag = "glass";
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_objectMaterials.push_back(glassMaterial);
+}
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  There are up to 4 light sources.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	if (NULL == m_pSceneUniforms)
+	{
+		return;
+	}
 
-	//SetShaderColor(1, 1, 1, 1);
+	// this line of code is NEEDED for telling the shaders to render 
+	// the 3D scene with custom lighting - to use the default rendered 
+	// lighting then comment out the following line
+	m_pSceneUniforms->SetUseLighting(true);
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	// the light values are only set once when the scene is prepared,
+	// and every scene program reads them from the same buffer
+	SceneUniformBuffer::LIGHT_SOURCE light;
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	// Light Source 1 (Main overhead light)
+	light.position = glm::vec3(42.0f, 25.0f, 3.0f);       // Positioned directly above the table
+	light.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);     // Ambient light to soften shadows
+	light.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);     // Softer diffuse light
+	light.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);    // Specular reflection for slight shine
+	light.focalStrength = 64.0f;                          // Increased focal strength for wider coverage
+	light.specularIntensity = 0.4f;                       // Slight specular intensity
+	m_pSceneUniforms->SetLightSource(0, light);
 
-	//Notepad Ring T4 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.12f, 0.1f, 0.15f);
+	// Light Source 2 (Side fill light)
+	light.position = glm::vec3(-16.0f, 6.0f, -4.0f);      // Positioned to the side to fill in shadows
+	light.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f);
+	light.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);     // Softer light for shadow fill
+	light.specularColor = glm::vec3(0.15f, 0.15f, 0.15f);
+	light.focalStrength = 48.0f;
+	light.specularIntensity = 0.3f;
+	m_pSceneUniforms->SetLightSource(1, light);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 94.0f;
-	ZrotationDegrees = 0.0f;
+	// Light Source 3 (Front fill light for shadow reduction)
+	light.position = glm::vec3(16.0f, 5.0f, -10.0f);      // Positioned in front to reduce shadows
+	light.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	light.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	light.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	light.focalStrength = 32.0f;
+	light.specularIntensity = 0.2f;
+	m_pSceneUniforms->SetLightSource(2, light);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(1.45f, -1.33f, 4.15f);
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// Load the textures for the 3D scene
+	LoadSceneTextures();
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// define the materials that will be used for the objects
+	// in the 3D scene and upload them for the shaders
+	DefineObjectMaterials();
+	InternMaterialTags();
+	UploadObjectMaterials();
+	// add and defile the light sources for the 3D scene
+	SetupSceneLights();
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadTorusMesh(TORUS_THICKNESS, SceneMeshes::MAX_LOD_LEVELS);
+	m_basicMeshes->LoadBoxMesh();
+	m_basicMeshes->LoadCylinderMesh(SceneMeshes::MAX_LOD_LEVELS);
+	m_basicMeshes->LoadConeMesh(SceneMeshes::MAX_LOD_LEVELS);
+
+	// build the render list once, now that the textures and
+	// materials it references have been loaded
+	BuildSceneObjects();
+	// build the hierarchy used to cull and query the objects
+	BuildObjectHierarchy();
+
+	// prepare the proxy boxes and query state used to test
+	// the objects for occlusion
+	m_occlusionCulling.Initialize(
+		"shaders/proxyVertexShader.glsl",
+		"shaders/proxyFragmentShader.glsl");
+	m_occlusionCulling.Resize((int)m_sceneObjects.size());
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+/***********************************************************
+ *  BuildSceneObjects()
+ *
+ *  This method is used for adding every object in the 3D
+ *  scene to the render list.  Each entry holds the mesh,
+ *  the precomputed transformation, and the texture, UV scale,
+ *  material or color that it is drawn with.
+ ***********************************************************/
+void SceneManager::BuildSceneObjects()
+{
+	m_sceneObjects.clear();
+	m_dirtyObjects.clear();
 
-//Notepad Ring T5 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.12f, 0.1f, 0.15f);
+	//Desk
+	AddTexturedObject(
+		MESH_PLANE,
+		glm::vec3(10.0f, 1.0f, 10.0f),
+		20.0f, 0.0f, 0.0f,
+		glm::vec3(-1.5f, 0.0f, 0.0f),
+		"black",
+		"glass");
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 95.0f;
-	ZrotationDegrees = 0.0f;
+	//Clipboard
+	AddTexturedObject(
+		MESH_BOX,
+		glm::vec3(4.0f, 0.20f, 3.0f),
+		20.0f, 80.0f, 0.0f,
+		glm::vec3(-4.65f, -1.65f, 5.0f),
+		"wood",
+		"wood");
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.1f, -1.33f, 4.27f);
+	//Note pad
+	AddColoredObject(
+		MESH_BOX,
+		glm::vec3(3.5f, 0.10f, 2.75f),
+		20.0f, 80.0f, 0.0f,
+		glm::vec3(-4.65f, -1.5f, 5.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		"wood");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Clipboard Clip
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(1.0f, 1.0f, 0.5f),
+		0.0f, 170.0f, 0.0f,
+		glm::vec3(-4.35f, -1.75f, 3.35f),
+		"metal",
+		"metal");
 
-	//SetShaderColor(0.827, 0.827, 1, 0.827);
+	//Notepad Ring T1
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.15f, 0.1f, 0.15f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(-5.65f, -0.95f, 3.5f),
+		"metal",
+		"metal");
 
-	SetShaderTexture("metal");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	//Notepad Ring T2
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.15f, 0.1f, 0.15f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(-5.8f, -1.22f, 4.25f),
+		"metal",
+		"metal");
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+	//Notepad Ring T3
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.15f, 0.1f, 0.15f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(-5.96f, -1.53f, 5.1f),
+		"metal",
+		"metal");
 
-	//Keyboard
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(4.01f, 0.13f, 2.1f);
+	//Notepad Ring T4
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.15f, 0.1f, 0.15f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(-6.11f, -1.8f, 5.8f),
+		"metal",
+		"metal");
+
+	//Notepad Ring T5
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.15f, 0.1f, 0.15f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(-6.19f, -1.98f, 6.3f),
+		"metal",
+		"metal");
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 21.0f;
-	YrotationDegrees = -9.0f;
-	ZrotationDegrees = 0.0f;
+	//Tall mug
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.45f, 0.45f, 7.0f),
+		110.0f, 0.0f, 0.0f,
+		glm::vec3(-4.0f, -0.52f, 2.0f),
+		"Mug",
+		"glass");
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(-0.15f, -0.65f, 2.0f);
+	//Tall mug handle
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.45f, 0.45f, 0.3f),
+		20.0f, -30.0f, 0.0f,
+		glm::vec3(-4.45f, 0.15f, 2.15f),
+		"Mug",
+		"glass");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Tall mug liquid
+	AddTexturedObject(
+		MESH_CYLINDER,
+		glm::vec3(0.45f, 1.0f, 0.4f),
+		20.0f, 140.0f, 0.0f,
+		glm::vec3(-4.0f, -0.22f, 2.15f),
+		"Coffee",
+		"glass");
 
-	//SetShaderColor(0.27, 0.91, 1, 1.55);
+	//Small mug
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.4f, 0.4f, 2.5f),
+		110.0f, 0.0f, 0.0f,
+		glm::vec3(3.0f, -0.52f, 3.5f),
+		"Mug",
+		"glass");
 
-	SetShaderTexture("keyboard");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	//Small mug liquid
+	AddTexturedObject(
+		MESH_CYLINDER,
+		glm::vec3(0.3f, 0.35f, 0.45f),
+		30.0f, 0.0f, 0.0f,
+		glm::vec3(3.0f, -0.52f, 3.5f),
+		"Coffee",
+		"glass");
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+	//Big Note pad
+	AddColoredObject(
+		MESH_BOX,
+		glm::vec3(4.0f, 0.2f, 3.25f),
+		20.0f, 80.0f, 0.0f,
+		glm::vec3(0.5f, -2.0f, 5.8f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		"glass");
 
-	//Laptop
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(2.5f, 0.13f, 4.01f);
+	//Big Note pad cardboard
+	AddTexturedObject(
+		MESH_BOX,
+		glm::vec3(4.01f, 0.13f, 3.4f),
+		20.0f, 80.0f, 0.0f,
+		glm::vec3(0.5f, -2.08f, 5.8f),
+		"wood",
+		"wood");
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = -144.0f;
-	YrotationDegrees = 97.5f;
-	ZrotationDegrees = 50.0f;
+	//Notepad Ring ***T3***
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.12f, 0.1f, 0.15f),
+		180.0f, 100.0f, 0.0f,
+		glm::vec3(0.8f, -1.32f, 4.0f),
+		"metal",
+		"metal");
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(0.1f, 0.98f, 1.2);
+	//Notepad Ring **T2**
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.12f, 0.1f, 0.15f),
+		180.0f, 100.0f, 0.0f,
+		glm::vec3(0.15f, -1.25f, 3.9f),
+		"metal",
+		"metal");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Notepad Ring *T1*
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.12f, 0.1f, 0.15f),
+		180.0f, 94.0f, 0.0f,
+		glm::vec3(-0.45f, -1.23f, 3.8f),
+		"metal",
+		"metal");
 
-	//SetShaderColor(0.27, 0.91, 1, 1.55);
+	//Notepad Ring T4
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.12f, 0.1f, 0.15f),
+		180.0f, 94.0f, 0.0f,
+		glm::vec3(1.45f, -1.33f, 4.15f),
+		"metal",
+		"metal");
+
+	//Notepad Ring T5
+	AddTexturedObject(
+		MESH_TORUS,
+		glm::vec3(0.12f, 0.1f, 0.15f),
+		180.0f, 95.0f, 0.0f,
+		glm::vec3(2.1f, -1.33f, 4.27f),
+		"metal",
+		"metal");
 
-	SetShaderTexture("Screen2");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	//Keyboard
+	AddTexturedObject(
+		MESH_BOX,
+		glm::vec3(4.01f, 0.13f, 2.1f),
+		21.0f, -9.0f, 0.0f,
+		glm::vec3(-0.15f, -0.65f, 2.0f),
+		"keyboard",
+		"glass");
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+	//Laptop
+	AddTexturedObject(
+		MESH_BOX,
+		glm::vec3(2.5f, 0.13f, 4.01f),
+		-144.0f, 97.5f, 50.0f,
+		glm::vec3(0.1f, 0.98f, 1.2f),
+		"Screen2",
+		"glass");
 
 	//Laptop back
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(2.5f, 0.13f, 4.01f);
+	AddColoredObject(
+		MESH_BOX,
+		glm::vec3(2.5f, 0.13f, 4.01f),
+		-144.0f, 97.5f, 50.0f,
+		glm::vec3(0.1f, 0.98f, 1.15f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		"glass");
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = -144.0f;
-	YrotationDegrees = 97.5f;
-	ZrotationDegrees = 50.0f;
-
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(0.1f, 0.98f, 1.15);
+	//Pen
+	AddTexturedObject(
+		MESH_CYLINDER,
+		glm::vec3(1.5f, 0.1f, 0.1f),
+		20.0f, 120.0f, 0.0f,
+		glm::vec3(0.6f, -1.9f, 5.7f),
+		"Pen",
+		"glass");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Pen
+	AddTexturedObject(
+		MESH_CYLINDER,
+		glm::vec3(1.5f, 0.1f, 0.1f),
+		20.0f, 80.0f, 0.0f,
+		glm::vec3(-2.6f, -1.9f, 5.7f),
+		"Pen",
+		"glass");
+}
 
-	SetShaderColor(1, 1, 1, 1);
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing every entry in the prepared render list, in
+ *  the order of the sorted render queue, with one indirect
+ *  command for each batch of entries that share their state.
+ *  With GPU culling on, compute shaders cull the whole list
+ *  and write the commands, so the CPU work stays the same
+ *  however many objects there are.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	if ((NULL == m_pUniformCache) || (NULL == m_pSceneUniforms))
+	{
+		return;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
+	// send the view and light values of the frame to every
+	// scene program at once
+	m_pSceneUniforms->Upload();
 
-	//Pen
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(1.5f, 0.1f, 0.1f);
+	// copy any images decoded since the last frame into their
+	// texture array layers
+	UploadDecodedTextures(false);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 120.0f;
-	ZrotationDegrees = 0.0f;
+	// the depth pyramid of the GPU culling path replaces the
+	// occlusion queries when both are turned on
+	bool bQueryOcclusion = (m_bOcclusionCulling == true) && (m_bGpuCulling == false);
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(0.6f, -1.9f, 5.7);
+	// read back the occlusion tests issued last frame, the
+	// camera sits at the translation of the inverse view
+	if (bQueryOcclusion == true)
+	{
+		m_occlusionCulling.BeginFrame(glm::vec3(glm::inverse(m_viewMatrix)[3]));
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bring the cached model matrices of any moved objects
+	// up to date before they are drawn
+	UpdateSceneTransforms();
 
-	//SetShaderColor(0.27, 0.91, 1, 1.55);
+	if (m_bGpuCulling == true)
+	{
+		// the whole render list is culled on the GPU, so it is
+		// only ordered and uploaded again when it has changed,
+		// the moved entries were already written in place
+		if (m_bDrawBatchesDirty == true)
+		{
+			SortSceneObjects();
+			BuildDrawBatches();
+			m_bDrawBatchesDirty = false;
+		}
 
-	SetShaderTexture("Pen");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+		// the translucent draws follow the camera every frame
+		SortTranslucentCommands();
+	}
+	else
+	{
+		// cull the objects outside the view frustum and order
+		// the rest to keep texture and mesh switches to a minimum
+		SortSceneObjects();
+
+		// the batches, instance values and indirect commands only
+		// change when the draw order or a model matrix has changed
+		if ((m_renderQueue.WasResorted() == true) ||
+			(m_renderStats.transformsRebuilt > 0) ||
+			(m_bDrawBatchesDirty == true))
+		{
+			BuildDrawBatches();
+			m_bDrawBatchesDirty = false;
+		}
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
+	// material edits are uploaded once, before they are drawn
+	if (m_bMaterialsDirty == true)
+	{
+		UploadObjectMaterials();
+	}
 
-	//Pen
-	// set the XYZ scale for the mesh
-	//scaleXYZ = glm::vec3(3.5f, 0.10f, 2.75f);
-	scaleXYZ = glm::vec3(1.5f, 0.1f, 0.1f);
+	// write the instances and commands that survive culling
+	GLuint drawDataBuffer = m_drawDataBuffer;
+	if (m_bGpuCulling == true)
+	{
+		m_gpuCulling.Cull(
+			m_frustum.GetPlanes(),
+			m_basicMeshes->GetInstanceBuffer(),
+			m_basicMeshes->GetCommandBuffer(),
+			m_drawDataBuffer);
+		m_pShaderManager->use();
+
+		// compacted commands come with their own per-draw values
+		if (m_gpuCulling.IsCompacting() == true)
+		{
+			drawDataBuffer = m_gpuCulling.GetDrawDataBuffer();
+		}
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 80.0f;
-	ZrotationDegrees = 0.0f;
+	// lay down the depth of the opaque draws first, so the
+	// lighting below runs once per pixel they cover
+	m_renderStats.drawCalls = 0;
+	m_renderStats.depthPrepassGpuMilliseconds = 0.0f;
+	bool bDepthPrepass = IsDepthPrepassing();
+	if (bDepthPrepass == true)
+	{
+		m_depthPrepassTimer.Begin();
+		// commands compacted by the GPU culling pass stop at the
+		// draw count of the opaque range
+		if ((m_bGpuCulling == true) && (m_gpuCulling.IsCompacting() == true))
+		{
+			m_depthPrepass.Draw(
+				m_basicMeshes,
+				m_viewMatrix,
+				m_projectionMatrix,
+				m_opaqueCommandCount,
+				m_gpuCulling.GetDrawCountBuffer(),
+				GpuCulling::GetDrawCountOffset(false));
+		}
+		else
+		{
+			m_depthPrepass.Draw(m_basicMeshes, m_viewMatrix, m_projectionMatrix, m_opaqueCommandCount);
+		}
+		m_depthPrepassTimer.End();
+		m_pShaderManager->use();
+		m_renderStats.drawCalls += (m_opaqueCommandCount > 0) ? 1 : 0;
+		m_renderStats.depthPrepassGpuMilliseconds = m_depthPrepassTimer.GetMilliseconds();
+	}
 
-	// set the XYZ position for the mesh
-	//positionXYZ = glm::vec3(0.5f, -1.9f, 5.8f);
-	positionXYZ = glm::vec3(-2.6f, -1.9f, 5.7f);
+	// every batch is one command in the indirect buffer, so the
+	// whole render list is drawn with the same few calls no
+	// matter how many objects are in the scene
+	m_sceneTimer.Begin();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, drawDataBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BINDING, m_materialBuffer);
+	DrawIndirectCommands(bDepthPrepass);
+	m_sceneTimer.End();
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_renderStats.drawCommands = (int)m_drawCommands.size();
+	m_renderStats.sceneGpuMilliseconds = m_sceneTimer.GetMilliseconds();
 
-	//SetShaderColor(0.27, 0.91, 1, 1.55);
+	if (m_bGpuCulling == true)
+	{
+		// the survivors are counted on the GPU and read back
+		// once the frame has finished, so these trail the frame
+		// being drawn by one or two frames
+		m_renderStats.visibleObjects = m_gpuCulling.GetVisibleCount();
+		m_renderStats.occludedObjects = m_gpuCulling.GetOccludedCount();
+		m_renderStats.culledObjects = glm::max(
+			(int)m_sceneObjects.size() - m_renderStats.visibleObjects - m_renderStats.occludedObjects, 0);
+	}
 
-	SetShaderTexture("Pen");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	// test the objects against the finished depth buffer,
+	// the results are read back next frame
+	m_renderStats.occlusionQueries = 0;
+	if (bQueryOcclusion == true)
+	{
+		m_occlusionCulling.IssueQueries(m_viewProjection);
+		m_renderStats.occlusionQueries = m_occlusionCulling.GetQueriesIssued();
+		m_pShaderManager->use();
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
-}
+	// the view values are set before the scene is rendered,
+	// so these counters cover every state call in the frame
+	m_renderStats.stateCallsIssued = m_pUniformCache->GetIssuedCalls();
+	m_renderStats.stateCallsSkipped = m_pUniformCache->GetSkippedCalls();
+}
\ No newline at end of file
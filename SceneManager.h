@@ -10,9 +10,28 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "SceneMeshes.h"
+#include "UniformCache.h"
+#include "SceneUniformBuffer.h"
+#include "RenderQueue.h"
+#include "TagTable.h"
+#include "Frustum.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCulling.h"
+#include "GpuCulling.h"
+#include "TessellatedMeshes.h"
+#include "GpuTimer.h"
+#include "DepthPrepass.h"
+#include "WeightedBlendedOit.h"
+#include "ImpostorAtlas.h"
+#include "DecodedTextureCache.h"
+#include "PixelUploadRing.h"
+#include "TextureLoader.h"
+#include "TextureSamplers.h"
 
+#include <chrono>
 #include <string>
+#include <thread>
 #include <vector>
 
 /***********************************************************
@@ -25,14 +44,22 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache, SceneUniformBuffer* pSceneUniforms);
 	// destructor
 	~SceneManager();
 
 	struct TEXTURE_INFO
 	{
 		std::string tag;
+		// image file the texture was loaded from
+		std::string filename;
+		// texture array that holds the image
 		uint32_t ID;
+		int arrayIndex;
+		// layer of the image within the texture array
+		int layer;
+		// the image has been uploaded to its layer
+		bool bLoaded;
 	};
 
 	struct OBJECT_MATERIAL
@@ -42,60 +69,436 @@ public:
 		glm::vec3 diffuseColor;
 		glm::vec3 specularColor;
 		float shininess;
+		// 1 for opaque, below 1 the objects drawn with the
+		// material are blended over the scene behind them
+		float opacity;
 		std::string tag;
 	};
 
+	// basic mesh shapes that can be drawn from the render list
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_TORUS,
+		MESH_CYLINDER,
+		MESH_CONE
+	};
+
+	// one draw record in the prepared render list
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		// transformation values the model matrix is built from
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		// cached model matrix, rebuilt only when flagged dirty
+		glm::mat4 modelMatrix;
+		bool bTransformDirty;
+		// world space bounds, rebuilt with the model matrix
+		BOUNDING_VOLUME worldBounds;
+		// index of the loaded texture, or -1 when drawn with
+		// the flat color
+		int textureSlot;
+		glm::vec2 uvScale;
+		// index into the defined materials, or -1 for none
+		int materialIndex;
+		glm::vec4 color;
+		// drawn after the opaque objects, back to front and
+		// blended, set from the color alpha and the material
+		bool bTranslucent;
+		// level of detail drawn last frame, kept so the level
+		// only changes once the size leaves the hysteresis band
+		int lodLevel;
+		// baked impostor standing in for the object when it is
+		// small on screen, -1 for none
+		int impostorIndex;
+		// drawn as its impostor last frame, kept for the same
+		// hysteresis as the level of detail
+		bool bImpostor;
+	};
+
+	// counters collected while rendering the last frame
+	struct RENDER_STATS
+	{
+		// model matrices rebuilt for dirty objects
+		int transformsRebuilt;
+		// uniform and texture calls passed through to OpenGL
+		int stateCallsIssued;
+		// redundant uniform and texture calls that were skipped
+		int stateCallsSkipped;
+		// texture and mesh switches avoided by sorting
+		int stateChangesSaved;
+		// draw calls issued for the render list
+		int drawCalls;
+		// indirect draw commands submitted by those draw calls
+		int drawCommands;
+		// render list entries inside the view frustum
+		int visibleObjects;
+		// render list entries skipped by frustum culling
+		int culledObjects;
+		// entries inside the frustum skipped by occlusion culling
+		int occludedObjects;
+		// occlusion queries issued for the entries
+		int occlusionQueries;
+		// triangles submitted for the render list, not counting
+		// the tessellated shapes, which are subdivided on the GPU
+		int trianglesDrawn;
+		// triangles avoided by drawing coarser levels of detail
+		int trianglesSaved;
+		// distant objects drawn as impostor quads
+		int impostorsDrawn;
+		// GPU time of the scene draws, from a frame or two ago
+		float sceneGpuMilliseconds;
+		// GPU time of the depth pre-pass, 0 when it is off
+		float depthPrepassGpuMilliseconds;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to resolved shader uniform locations
+	UniformCache* m_pUniformCache;
+	// pointer to the view and light values shared by the
+	// scene shader programs
+	SceneUniformBuffer* m_pSceneUniforms;
 	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
+	SceneMeshes* m_basicMeshes;
+	// images of the same size and format share a texture
+	// array, one layer per image
+	struct TEXTURE_ARRAY
+	{
+		GLuint ID;
+		int width;
+		int height;
+		// GL_RGBA8, or the block compressed format of images
+		// read from their compressed cache
+		GLenum format;
+		int layers;
+		// bindless handle, when bindless textures are used
+		GLuint64 handle;
+	};
+
 	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture tags, the handle of each is its texture slot
+	TagTable m_textureTags;
+	// texture arrays holding the loaded textures
+	std::vector<TEXTURE_ARRAY> m_textureArrays;
+	// decodes the image files on worker threads
+	TextureLoader m_textureLoader;
+	// decoded images waiting for a free upload slot
+	std::vector<TextureLoader::DECODED_IMAGE> m_pendingUploads;
+	// mapped pixel buffers the images are streamed through
+	PixelUploadRing m_pixelUploadRing;
+	// sampler objects the texture arrays are read through
+	TextureSamplers m_textureSamplers;
+	// time the first image file was queued for decoding
+	std::chrono::steady_clock::time_point m_textureLoadStart;
+	// true when the shaders read the texture arrays through
+	// bindless handles instead of texture units
+	bool m_bBindlessTextures;
+	// shader storage buffer holding the bindless handles
+	GLuint m_textureHandleBuffer;
+	// true when the images are read from, and written to,
+	// block compressed caches beside the image files
+	bool m_bCompressedTextures;
+	// decoded images and mipmaps of the last run, mapped
+	// into memory while the textures load
+	DecodedTextureCache m_decodedTextureCache;
+	// true when an image had to be decoded, so the decoded
+	// cache is written again once all of them are loaded
+	bool m_bDecodedCacheStale;
+	// uncompressed images and mipmaps kept from the uploads
+	// for writing the decoded cache
+	std::vector<DecodedTextureCache::WRITE_ENTRY> m_decodedCacheEntries;
+	// thread writing the decoded cache to disk
+	std::thread m_decodedCacheWriter;
+	// where each image came from, for telling a cold start
+	// from a warm one
+	enum TEXTURE_SOURCE
+	{
+		TEXTURE_DECODED = 0,
+		TEXTURE_FROM_COMPRESSED_CACHE,
+		TEXTURE_FROM_DECODED_CACHE,
+		TEXTURE_SOURCE_COUNT
+	};
+	int m_textureLoadCounts[TEXTURE_SOURCE_COUNT];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// material tags, the handle of each is its material index
+	TagTable m_materialTags;
+	// prepared render list for the 3D scene
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// render list entries waiting for their model matrix to be rebuilt
+	std::vector<int> m_dirtyObjects;
+	// counters for the last rendered frame
+	RENDER_STATS m_renderStats;
+	// render list entries ordered by their state sort keys
+	RenderQueue m_renderQueue;
+	// view, projection and view-projection matrices of the
+	// frame being rendered
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::mat4 m_viewProjection;
+	// view frustum of the frame being rendered
+	Frustum m_frustum;
+	// hierarchy over the world bounds of the render list
+	BoundingVolumeHierarchy m_objectHierarchy;
+	// render list entries inside the frustum this frame
+	std::vector<int> m_visibleObjects;
+	// occlusion tests of the render list entries
+	OcclusionCulling m_occlusionCulling;
+	bool m_bOcclusionCulling;
+	// frustum and depth pyramid culling on the GPU
+	GpuCulling m_gpuCulling;
+	bool m_bGpuCulling;
+	// true when the draw batches have to be built again even
+	// though the draw order has not changed
+	bool m_bDrawBatchesDirty;
+	// bounds of each instance for the GPU culling path
+	std::vector<GpuCulling::CULL_OBJECT> m_cullObjects;
+	// instance of each render list entry in the GPU culling
+	// path, so a moved entry is written in place
+	std::vector<int> m_instanceSlots;
+	// view depth of a translucent command in the GPU culling
+	// path, for putting them back to front each frame
+	struct TRANSLUCENT_ORDER
+	{
+		float viewDepth;
+		int command;
+	};
+	std::vector<TRANSLUCENT_ORDER> m_translucentOrder;
+	// curved shapes subdivided on the GPU instead of drawn
+	// from the precomputed meshes
+	TessellatedMeshes m_tessellatedMeshes;
+	bool m_bTessellation;
+	// GPU time of the scene draws
+	GpuTimer m_sceneTimer;
+	// depth-only pass over the opaque draws before they are lit
+	DepthPrepass m_depthPrepass;
+	bool m_bDepthPrepass;
+	GpuTimer m_depthPrepassTimer;
+	// order-independent blending of the translucent draws
+	WeightedBlendedOit m_weightedBlendedOit;
+	bool m_bWeightedBlendedOit;
+	// pre-rendered stand-ins for the distant curved objects
+	ImpostorAtlas m_impostorAtlas;
+	bool m_bImpostors;
+	// bounding sphere radius in pixels below which an object
+	// is drawn as its impostor
+	float m_impostorPixelRadius;
 
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	// distinct object shape an impostor is baked from, the
+	// material is left out since the impostors are lit when
+	// they are drawn
+	struct IMPOSTOR_SOURCE
+	{
+		MESH_TYPE mesh;
+		glm::vec3 scaleXYZ;
+		int textureSlot;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+		// bounds of the scaled mesh before it is rotated
+		BOUNDING_VOLUME bakedBounds;
+	};
+
+	// shapes of the baked impostors, indexed by atlas layer
+	std::vector<IMPOSTOR_SOURCE> m_impostorSources;
+	// impostor quads drawn this frame
+	std::vector<ImpostorAtlas::IMPOSTOR_INSTANCE> m_impostorInstances;
+
+	// consecutive sorted entries that share a mesh, level of
+	// detail, texture and UV scale, drawn with one instanced
+	// call - each instance carries its own material index
+	struct DRAW_BATCH
+	{
+		MESH_TYPE mesh;
+		bool bTranslucent;
+		int lodLevel;
+		int textureSlot;
+		glm::vec2 uvScale;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// per-draw values read by the shaders through gl_DrawID,
+	// laid out to match the std430 DrawData shader struct and
+	// sized as one uvec4 for the GPU culling path to copy
+	struct DRAW_DATA
+	{
+		glm::vec2 uvScale;
+		int textureArray;                  // -1 for the flat color
+		int textureLayer;
+	};
+
+	// material values laid out to match the std430
+	// MaterialData shader struct
+	struct MATERIAL_DATA
+	{
+		glm::vec4 ambientColorStrength;    // rgb color, a strength
+		glm::vec4 diffuseColor;            // rgb color, a opacity
+		glm::vec4 specularColorShininess;  // rgb color, a shininess
+	};
+
+	// per-instance values of the sorted render list entries
+	std::vector<SceneMeshes::INSTANCE_DATA> m_instanceData;
+	// instanced draws for the sorted render list
+	std::vector<DRAW_BATCH> m_drawBatches;
+	// indirect draw command for each draw batch
+	std::vector<SceneMeshes::DRAW_COMMAND> m_drawCommands;
+	// per-draw values for each draw batch
+	std::vector<DRAW_DATA> m_drawData;
+	// the opaque batches sort first, the commands from this
+	// count on are translucent
+	int m_opaqueCommandCount;
+
+	// draw batch of a curved shape drawn as tessellated
+	// patches, its indirect command is left with no instances
+	// so the per-draw values still line up with gl_DrawID
+	struct TESSELLATED_DRAW
+	{
+		MESH_TYPE mesh;
+		bool bTranslucent;
+		int drawIndex;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// tessellated draws for the sorted render list
+	std::vector<TESSELLATED_DRAW> m_tessellatedDraws;
+	// shader storage buffer holding the per-draw values
+	GLuint m_drawDataBuffer;
+	// number of draws the per-draw buffer can hold
+	size_t m_drawDataCapacity;
+	// shader storage buffer holding every defined material,
+	// indexed by material index
+	GLuint m_materialBuffer;
+	// true when a material has been defined or changed since
+	// the material buffer was last uploaded
+	bool m_bMaterialsDirty;
+
+	// queue a texture image to be decoded and give it a layer
+	// of the texture array for its image size
+	bool CreateGLTexture(const char* filename, const std::string& tag);
+	// create the texture arrays, filled with a placeholder
+	// until the images are decoded
+	void BuildTextureArrays();
+	// make the bindless handles of the texture arrays with
+	// the shared sampler and upload them for the shaders
+	void MakeTextureHandles();
+	// copy the images decoded since the last call into their
+	// texture array layers, first waiting for all of them when
+	// asked to
+	void UploadDecodedTextures(bool bWaitForAll);
+	// write the uncompressed images kept from the uploads to
+	// the decoded texture cache on a background thread
+	void WriteDecodedTextureCache();
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const std::string& tag);
+	int FindTextureSlot(const std::string& tag);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(const std::string& tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(const std::string& tag);
+	// intern the tags of the defined materials
+	void InternMaterialTags();
 
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
+	// calculate the model matrix from the transformation values
+	glm::mat4 CalculateModelMatrix(
 		glm::vec3 scaleXYZ,
 		float XrotationDegrees,
 		float YrotationDegrees,
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
+	// add a textured object to the render list
+	void AddTexturedObject(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		const std::string& textureTag,
+		const std::string& materialTag,
+		glm::vec2 uvScale = glm::vec2(1.0f, 1.0f));
 
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
+	// add a flat colored object to the render list
+	void AddColoredObject(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		const std::string& materialTag);
 
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	// get the local bounding volume of a basic mesh
+	const BOUNDING_VOLUME& GetSceneObjectMeshBounds(MESH_TYPE mesh);
+	// get the number of levels of detail loaded for a basic mesh
+	int GetSceneObjectMeshLevels(MESH_TYPE mesh);
+	// make the indirect command that draws a draw batch
+	SceneMeshes::DRAW_COMMAND GetSceneObjectCommand(MESH_TYPE mesh, int lodLevel, int count, int firstInstance);
+	// get the radius of an entry's bounding sphere in pixels,
+	// -1 when it is not in front of the camera
+	float GetPixelRadius(const SCENE_OBJECT& object, float pixelScale) const;
+	// pick the level of detail of an entry from its size on screen
+	void SelectLevelOfDetail(SCENE_OBJECT& object, float pixelScale);
+	// true when an entry is small enough on screen to be drawn
+	// as its impostor
+	bool SelectImpostor(SCENE_OBJECT& object, float pixelScale);
+	// true when the distant objects are drawn as impostors
+	bool IsDrawingImpostors() const;
+	// find the distinct shapes of the curved objects and load
+	// or bake an impostor for each
+	void BuildImpostors();
+	// render every view of every impostor into the atlas
+	void BakeImpostors();
+	// hash everything the baked impostors depend on
+	uint64_t GetImpostorCacheKey();
+	// make the per-draw values of a texture and UV scale
+	DRAW_DATA MakeDrawData(int textureSlot, const glm::vec2& uvScale) const;
+	// true for the shapes that can be drawn as tessellated patches
+	static bool IsCurvedMesh(MESH_TYPE mesh);
+	// draw the opaque or the translucent batches of the curved
+	// shapes as tessellated patches
+	void DrawTessellatedBatches(bool bTranslucent);
+	// draw the uploaded indirect commands, the opaque ones
+	// without blending and then the translucent ones with it
+	void DrawIndirectCommands(bool bDepthPrepass);
+	// draw the translucent commands and tessellated batches
+	void DrawTranslucentCommands();
+	// draw the opaque or the translucent range of the indirect
+	// commands with one call
+	void DrawCommandRange(bool bTranslucent);
+	// write the instance values and bounds of the moved entries
+	// over their uploaded copies in the GPU culling path
+	void UpdateCulledObjects();
+	// put the translucent commands of the GPU culling path back
+	// to front for the current view
+	void SortTranslucentCommands();
+	// true when an object with this color and material blends
+	bool IsTranslucent(const glm::vec4& color, int materialIndex) const;
+	// rebuild the model matrices of the dirty render list entries
+	void UpdateSceneTransforms();
+	// build the bounding volume hierarchy over the render list
+	void BuildObjectHierarchy();
+	// queue and sort the render list entries for the frame
+	void SortSceneObjects();
+	// group the sorted entries into instanced draw batches
+	void BuildDrawBatches();
+	// upload the indirect commands and per-draw values
+	void UploadDrawCommands();
+	// upload every defined material to the material buffer
+	void UploadObjectMaterials();
 
 public:
 
@@ -110,4 +513,71 @@ public:
 	void DefineObjectMaterials();
 	// add and define the light sources before rendering
 	void SetupSceneLights();
+	// build the render list of all the objects in the 3D scene
+	void BuildSceneObjects();
+
+	// move an object in the render list, flagging its model
+	// matrix to be rebuilt before the next frame is drawn
+	void SetObjectTransformations(
+		int objectIndex,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// turn every stride-th object of the render list about its
+	// Y axis, so the frames with moving objects can be timed
+	void SpinObjects(int stride, float degrees);
+
+	// change the values of a defined material, which are
+	// uploaded again before the next frame is drawn
+	bool SetObjectMaterial(
+		const std::string& materialTag,
+		const OBJECT_MATERIAL& material);
+
+	// find the nearest object hit by a ray, -1 for none
+	int PickObject(const glm::vec3& origin, const glm::vec3& direction);
+	// find the objects within a radius of a point
+	void FindObjectsNear(
+		const glm::vec3& center,
+		float radius,
+		std::vector<int>& objectIndices);
+
+	// set the view and projection matrices used to cull and
+	// order the frame's draws
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+	// skip objects hidden behind others, tested with occlusion queries
+	void SetOcclusionCulling(bool bEnabled);
+	// cull on the GPU with compute shaders, when supported
+	void SetGpuCulling(bool bEnabled);
+	// draw the torus, cylinder and cone as patches subdivided
+	// on the GPU by their size on screen, when supported
+	void SetTessellatedMeshes(bool bEnabled);
+	// write the depth of the opaque draws before shading them,
+	// so overlapping objects are only lit once per pixel
+	void SetDepthPrepass(bool bEnabled);
+	// true when the curved shapes are drawn as tessellated patches
+	bool IsTessellating() const;
+	// true when the opaque draws get a depth pre-pass this frame
+	bool IsDepthPrepassing() const;
+	// blend the translucent draws with weighted blended
+	// order-independent transparency instead of sorting them
+	void SetWeightedBlendedOit(bool bEnabled);
+	// draw the distant torus, cylinder and cone objects as
+	// quads showing pre-rendered views of them
+	void SetImpostors(bool bEnabled);
+	// set the bounding sphere radius in pixels below which
+	// objects are drawn as impostors
+	void SetImpostorPixelRadius(float pixels);
+	// use the block compressed texture caches, when supported -
+	// this has to be set before the scene is prepared
+	void SetCompressedTextures(bool bEnabled);
+	// set the anisotropy the textures are filtered with
+	void SetTextureAnisotropy(float anisotropy);
+	// time the largest texture drawn at a distance with each
+	// filtering mode and print the results
+	void RunTextureBenchmark();
+
+	// get the counters for the last rendered frame
+	const RENDER_STATS& GetRenderStats() const { return(m_renderStats); }
 };
\ No newline at end of file
@@ -0,0 +1,888 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.cpp
+// ============
+// basic shape meshes in shared buffers with instanced and indirect draws
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneMeshes.h"
+
+#include <cmath>
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	// floats per vertex - position, normal and texture coordinate
+	const int FLOATS_PER_VERTEX = 8;
+	const int FLOATS_PER_POSITION = 3;
+	const int FLOATS_PER_NORMAL = 3;
+	const int FLOATS_PER_UV = 2;
+
+	// vertex attribute locations used by the shaders
+	const GLuint POSITION_ATTRIBUTE = 0;
+	const GLuint NORMAL_ATTRIBUTE = 1;
+	const GLuint UV_ATTRIBUTE = 2;
+	// the model matrix takes four attribute locations
+	const GLuint INSTANCE_MODEL_ATTRIBUTE = 3;
+	const GLuint INSTANCE_COLOR_ATTRIBUTE = 7;
+	const GLuint INSTANCE_MATERIAL_ATTRIBUTE = 8;
+
+	const float PI = 3.14159265358979f;
+
+	/***********************************************************
+	 *  AddVertex()
+	 *
+	 *  Append one vertex to an interleaved vertex list.
+	 ***********************************************************/
+	void AddVertex(
+		std::vector<GLfloat>& vertices,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v)
+	{
+		vertices.push_back(x);
+		vertices.push_back(y);
+		vertices.push_back(z);
+		vertices.push_back(nx);
+		vertices.push_back(ny);
+		vertices.push_back(nz);
+		vertices.push_back(u);
+		vertices.push_back(v);
+	}
+
+	/***********************************************************
+	 *  BuildPlane()
+	 *
+	 *  A flat plane from -1 to 1 on the X and Z axes, facing up.
+	 ***********************************************************/
+	void BuildPlane(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+	{
+		AddVertex(vertices, -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f);
+		AddVertex(vertices, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f);
+		AddVertex(vertices, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f);
+		AddVertex(vertices, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+
+		GLuint planeIndices[] = { 0, 3, 1, 1, 3, 2 };
+		indices.insert(indices.end(), planeIndices, planeIndices + 6);
+	}
+
+	/***********************************************************
+	 *  BuildBox()
+	 *
+	 *  A unit cube centered on the origin, with its own normal
+	 *  and full texture coordinates on each of the six faces.
+	 ***********************************************************/
+	void BuildBox(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+	{
+		// face normal, then the face's U and V directions
+		const float faces[6][9] =
+		{
+			{ 0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 0.0f,    0.0f, 1.0f, 0.0f },
+			{ 0.0f, 0.0f, -1.0f,  -1.0f, 0.0f, 0.0f,    0.0f, 1.0f, 0.0f },
+			{ 1.0f, 0.0f, 0.0f,    0.0f, 0.0f, -1.0f,   0.0f, 1.0f, 0.0f },
+			{ -1.0f, 0.0f, 0.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f,    1.0f, 0.0f, 0.0f,    0.0f, 0.0f, -1.0f },
+			{ 0.0f, -1.0f, 0.0f,   1.0f, 0.0f, 0.0f,    0.0f, 0.0f, 1.0f }
+		};
+		const float corners[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+		for (int face = 0; face < 6; face++)
+		{
+			const float* f = faces[face];
+			GLuint firstVertex = (GLuint)(vertices.size() / FLOATS_PER_VERTEX);
+
+			for (int corner = 0; corner < 4; corner++)
+			{
+				float u = corners[corner][0];
+				float v = corners[corner][1];
+				float x = 0.5f * f[0] + (u - 0.5f) * f[3] + (v - 0.5f) * f[6];
+				float y = 0.5f * f[1] + (u - 0.5f) * f[4] + (v - 0.5f) * f[7];
+				float z = 0.5f * f[2] + (u - 0.5f) * f[5] + (v - 0.5f) * f[8];
+				AddVertex(vertices, x, y, z, f[0], f[1], f[2], u, v);
+			}
+
+			GLuint faceIndices[] = { 0, 1, 2, 0, 2, 3 };
+			for (GLuint index : faceIndices)
+			{
+				indices.push_back(firstVertex + index);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildTorus()
+	 *
+	 *  A torus around the Z axis with a main radius of 1 and
+	 *  the passed in tube thickness.
+	 ***********************************************************/
+	void BuildTorus(
+		std::vector<GLfloat>& vertices,
+		std::vector<GLuint>& indices,
+		float thickness,
+		int mainSegments,
+		int tubeSegments)
+	{
+		const float mainRadius = 1.0f;
+
+		for (int i = 0; i <= mainSegments; i++)
+		{
+			float mainAngle = 2.0f * PI * i / mainSegments;
+			float cosMain = cosf(mainAngle);
+			float sinMain = sinf(mainAngle);
+
+			for (int j = 0; j <= tubeSegments; j++)
+			{
+				float tubeAngle = 2.0f * PI * j / tubeSegments;
+				float cosTube = cosf(tubeAngle);
+				float sinTube = sinf(tubeAngle);
+				float ringRadius = mainRadius + thickness * cosTube;
+
+				AddVertex(vertices,
+					ringRadius * cosMain, ringRadius * sinMain, thickness * sinTube,
+					cosTube * cosMain, cosTube * sinMain, sinTube,
+					(float)i / mainSegments, (float)j / tubeSegments);
+			}
+		}
+
+		for (int i = 0; i < mainSegments; i++)
+		{
+			for (int j = 0; j < tubeSegments; j++)
+			{
+				GLuint a = i * (tubeSegments + 1) + j;
+				GLuint b = (i + 1) * (tubeSegments + 1) + j;
+
+				indices.push_back(a);
+				indices.push_back(b);
+				indices.push_back(a + 1);
+				indices.push_back(b);
+				indices.push_back(b + 1);
+				indices.push_back(a + 1);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildCylinder()
+	 *
+	 *  A cylinder with a radius of 1 standing from 0 to 1 on
+	 *  the Y axis, with a top and a bottom cap.
+	 ***********************************************************/
+	void BuildCylinder(
+		std::vector<GLfloat>& vertices,
+		std::vector<GLuint>& indices,
+		int sectors)
+	{
+		// sides
+		for (int i = 0; i <= sectors; i++)
+		{
+			float angle = 2.0f * PI * i / sectors;
+			float x = cosf(angle);
+			float z = sinf(angle);
+			float u = (float)i / sectors;
+
+			AddVertex(vertices, x, 0.0f, z, x, 0.0f, z, u, 0.0f);
+			AddVertex(vertices, x, 1.0f, z, x, 0.0f, z, u, 1.0f);
+		}
+		for (int i = 0; i < sectors; i++)
+		{
+			GLuint a = i * 2;
+			indices.push_back(a);
+			indices.push_back(a + 1);
+			indices.push_back(a + 2);
+			indices.push_back(a + 1);
+			indices.push_back(a + 3);
+			indices.push_back(a + 2);
+		}
+
+		// bottom and top caps
+		for (int cap = 0; cap < 2; cap++)
+		{
+			float y = (float)cap;
+			float ny = (cap == 0) ? -1.0f : 1.0f;
+			GLuint center = (GLuint)(vertices.size() / FLOATS_PER_VERTEX);
+
+			AddVertex(vertices, 0.0f, y, 0.0f, 0.0f, ny, 0.0f, 0.5f, 0.5f);
+			for (int i = 0; i <= sectors; i++)
+			{
+				float angle = 2.0f * PI * i / sectors;
+				float x = cosf(angle);
+				float z = sinf(angle);
+				AddVertex(vertices, x, y, z, 0.0f, ny, 0.0f, 0.5f + 0.5f * x, 0.5f + 0.5f * z);
+			}
+			for (int i = 0; i < sectors; i++)
+			{
+				indices.push_back(center);
+				if (cap == 0)
+				{
+					indices.push_back(center + 1 + i);
+					indices.push_back(center + 2 + i);
+				}
+				else
+				{
+					indices.push_back(center + 2 + i);
+					indices.push_back(center + 1 + i);
+				}
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildCone()
+	 *
+	 *  A cone with a base radius of 1 at 0 on the Y axis and its
+	 *  apex at 1, with a bottom cap.  The side has one apex
+	 *  vertex per sector so each can carry the normal of its
+	 *  own sector.
+	 ***********************************************************/
+	void BuildCone(
+		std::vector<GLfloat>& vertices,
+		std::vector<GLuint>& indices,
+		int sectors)
+	{
+		// the side slopes at 45 degrees, so the normals lean up
+		// by the same amount they point out
+		const float slope = 0.70710678f;
+
+		// sides
+		for (int i = 0; i <= sectors; i++)
+		{
+			float angle = 2.0f * PI * i / sectors;
+			float x = cosf(angle);
+			float z = sinf(angle);
+			float u = (float)i / sectors;
+
+			AddVertex(vertices, x, 0.0f, z, x * slope, slope, z * slope, u, 0.0f);
+			AddVertex(vertices, 0.0f, 1.0f, 0.0f, x * slope, slope, z * slope, u, 1.0f);
+		}
+		for (int i = 0; i < sectors; i++)
+		{
+			GLuint a = i * 2;
+			indices.push_back(a);
+			indices.push_back(a + 1);
+			indices.push_back(a + 2);
+		}
+
+		// bottom cap
+		GLuint center = (GLuint)(vertices.size() / FLOATS_PER_VERTEX);
+		AddVertex(vertices, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f);
+		for (int i = 0; i <= sectors; i++)
+		{
+			float angle = 2.0f * PI * i / sectors;
+			float x = cosf(angle);
+			float z = sinf(angle);
+			AddVertex(vertices, x, 0.0f, z, 0.0f, -1.0f, 0.0f, 0.5f + 0.5f * x, 0.5f + 0.5f * z);
+		}
+		for (int i = 0; i < sectors; i++)
+		{
+			indices.push_back(center);
+			indices.push_back(center + 1 + i);
+			indices.push_back(center + 2 + i);
+		}
+	}
+}
+/***********************************************************
+ *  SceneMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneMeshes::SceneMeshes()
+{
+	m_planeMesh = {};
+	m_boxMesh = {};
+	for (int level = 0; level < MAX_LOD_LEVELS; level++)
+	{
+		m_torusMesh[level] = {};
+		m_cylinderMesh[level] = {};
+		m_coneMesh[level] = {};
+	}
+	m_torusLevels = 0;
+	m_cylinderLevels = 0;
+	m_coneLevels = 0;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_positionVao = 0;
+	m_positionBuffer = 0;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+	m_commandBuffer = 0;
+	m_commandCapacity = 0;
+	m_commandCount = 0;
+}
+
+/***********************************************************
+ *  ~SceneMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneMeshes::~SceneMeshes()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+		glDeleteBuffers(1, &m_commandBuffer);
+		glDeleteVertexArrays(1, &m_positionVao);
+		glDeleteBuffers(1, &m_positionBuffer);
+		m_vao = 0;
+	}
+
+	m_vertices.clear();
+	m_indices.clear();
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for building the plane mesh.
+ ***********************************************************/
+void SceneMeshes::LoadPlaneMesh()
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+
+	BuildPlane(vertices, indices);
+	AppendMesh(m_planeMesh, vertices, indices);
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for building the box mesh.
+ ***********************************************************/
+void SceneMeshes::LoadBoxMesh()
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+
+	BuildBox(vertices, indices);
+	AppendMesh(m_boxMesh, vertices, indices);
+}
+
+/***********************************************************
+ *  LoadTorusMesh()
+ *
+ *  This method is used for building the torus mesh with the
+ *  passed in tube thickness, at the passed in number of
+ *  levels of detail.  Level 0 has 30 segments around the
+ *  main ring and the tube, and every following level has
+ *  half as many, down to a floor that still reads as a ring.
+ ***********************************************************/
+void SceneMeshes::LoadTorusMesh(float thickness, int levels)
+{
+	m_torusLevels = glm::clamp(levels, 1, MAX_LOD_LEVELS);
+
+	for (int level = 0; level < m_torusLevels; level++)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+
+		int mainSegments = glm::max(30 >> level, 6);
+		int tubeSegments = glm::max(30 >> level, 4);
+		BuildTorus(vertices, indices, thickness, mainSegments, tubeSegments);
+		AppendMesh(m_torusMesh[level], vertices, indices);
+	}
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for building the cylinder mesh at the
+ *  passed in number of levels of detail.  Level 0 has 36
+ *  sectors and every following level has half as many, down
+ *  to a floor of six.
+ ***********************************************************/
+void SceneMeshes::LoadCylinderMesh(int levels)
+{
+	m_cylinderLevels = glm::clamp(levels, 1, MAX_LOD_LEVELS);
+
+	for (int level = 0; level < m_cylinderLevels; level++)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+
+		BuildCylinder(vertices, indices, glm::max(36 >> level, 6));
+		AppendMesh(m_cylinderMesh[level], vertices, indices);
+	}
+}
+
+/***********************************************************
+ *  LoadConeMesh()
+ *
+ *  This method is used for building the cone mesh at the
+ *  passed in number of levels of detail, with the same
+ *  sectors per level as the cylinder.
+ ***********************************************************/
+void SceneMeshes::LoadConeMesh(int levels)
+{
+	m_coneLevels = glm::clamp(levels, 1, MAX_LOD_LEVELS);
+
+	for (int level = 0; level < m_coneLevels; level++)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+
+		BuildCone(vertices, indices, glm::max(36 >> level, 6));
+		AppendMesh(m_coneMesh[level], vertices, indices);
+	}
+}
+
+/***********************************************************
+ *  AppendMesh()
+ *
+ *  This method is used for appending the vertex and index
+ *  data of a mesh to the shared buffers.  The indices of
+ *  each mesh stay relative to its own first vertex, and the
+ *  base vertex recorded for the mesh offsets them when it is
+ *  drawn.  The local bounding volume of the mesh is also
+ *  calculated here.  The meshes are only loaded while the
+ *  scene is prepared, so the shared buffers are simply
+ *  uploaded again with every mesh that is added.
+ ***********************************************************/
+void SceneMeshes::AppendMesh(
+	MESH_RANGE& mesh,
+	const std::vector<GLfloat>& vertices,
+	const std::vector<GLuint>& indices)
+{
+	if (m_vao == 0)
+	{
+		CreateVertexArray();
+	}
+
+	mesh.firstIndex = (GLuint)m_indices.size();
+	mesh.nIndices = (GLuint)indices.size();
+	mesh.baseVertex = (GLint)(m_vertices.size() / FLOATS_PER_VERTEX);
+	mesh.nVertices = (GLuint)(vertices.size() / FLOATS_PER_VERTEX);
+	mesh.bounds = CalculateBoundingVolume(vertices.data(), (int)mesh.nVertices, FLOATS_PER_VERTEX);
+
+	m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+	m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
+
+	// the positions alone, in the same vertex order so the same
+	// indices and base vertices address them
+	std::vector<GLfloat> positions;
+	positions.reserve((m_vertices.size() / FLOATS_PER_VERTEX) * FLOATS_PER_POSITION);
+	for (size_t vertex = 0; vertex < m_vertices.size(); vertex += FLOATS_PER_VERTEX)
+	{
+		positions.insert(positions.end(), m_vertices.begin() + vertex, m_vertices.begin() + vertex + FLOATS_PER_POSITION);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * positions.size(), positions.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the index buffer binding is part of the vertex array state
+	glBindVertexArray(m_vao);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  CreateVertexArray()
+ *
+ *  This method is used for creating the single vertex array
+ *  object and the shared buffers, and configuring the vertex
+ *  attributes and the per-instance attributes that are read
+ *  from the shared instance buffer.  A second vertex array
+ *  object reads the positions from their own buffer instead.
+ ***********************************************************/
+void SceneMeshes::CreateVertexArray()
+{
+	const GLsizei stride = sizeof(GLfloat) * FLOATS_PER_VERTEX;
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vertexBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+	glGenBuffers(1, &m_instanceBuffer);
+	glGenBuffers(1, &m_commandBuffer);
+	glGenVertexArrays(1, &m_positionVao);
+	glGenBuffers(1, &m_positionBuffer);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+	// per-vertex position, normal and texture coordinate
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glVertexAttribPointer(POSITION_ATTRIBUTE, FLOATS_PER_POSITION, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+	glVertexAttribPointer(NORMAL_ATTRIBUTE, FLOATS_PER_NORMAL, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * FLOATS_PER_POSITION));
+	glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+	glVertexAttribPointer(UV_ATTRIBUTE, FLOATS_PER_UV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * (FLOATS_PER_POSITION + FLOATS_PER_NORMAL)));
+	glEnableVertexAttribArray(UV_ATTRIBUTE);
+
+	SetupInstanceAttributes();
+
+	// positions only, at the same attribute location
+	glBindVertexArray(m_positionVao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+	glVertexAttribPointer(POSITION_ATTRIBUTE, FLOATS_PER_POSITION, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * FLOATS_PER_POSITION, (void*)0);
+	glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+	SetupInstanceAttributes();
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetupInstanceAttributes()
+ *
+ *  This method is used for pointing the per-instance model
+ *  matrix, color and material index attributes of the bound
+ *  vertex array object at the shared instance buffer.  The
+ *  attributes advance once per drawn instance.
+ ***********************************************************/
+void SceneMeshes::SetupInstanceAttributes() const
+{
+	// the model matrix takes one attribute per column
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(
+			INSTANCE_MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE,
+			sizeof(INSTANCE_DATA),
+			(void*)(offsetof(INSTANCE_DATA, modelMatrix) + sizeof(glm::vec4) * column));
+		glEnableVertexAttribArray(INSTANCE_MODEL_ATTRIBUTE + column);
+		glVertexAttribDivisor(INSTANCE_MODEL_ATTRIBUTE + column, 1);
+	}
+	glVertexAttribPointer(
+		INSTANCE_COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE,
+		sizeof(INSTANCE_DATA),
+		(void*)offsetof(INSTANCE_DATA, color));
+	glEnableVertexAttribArray(INSTANCE_COLOR_ATTRIBUTE);
+	glVertexAttribDivisor(INSTANCE_COLOR_ATTRIBUTE, 1);
+	glVertexAttribIPointer(
+		INSTANCE_MATERIAL_ATTRIBUTE, 1, GL_INT,
+		sizeof(INSTANCE_DATA),
+		(void*)offsetof(INSTANCE_DATA, materialIndex));
+	glEnableVertexAttribArray(INSTANCE_MATERIAL_ATTRIBUTE);
+	glVertexAttribDivisor(INSTANCE_MATERIAL_ATTRIBUTE, 1);
+}
+
+/***********************************************************
+ *  SetInstanceData()
+ *
+ *  This method is used for uploading the per-instance values
+ *  that the following draws read from.  The buffer storage
+ *  only grows, so uploads after the first one reuse the
+ *  existing allocation.
+ ***********************************************************/
+void SceneMeshes::SetInstanceData(const std::vector<INSTANCE_DATA>& instances)
+{
+	if ((m_instanceBuffer == 0) || (instances.empty()))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (instances.size() > m_instanceCapacity)
+	{
+		m_instanceCapacity = instances.size();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(INSTANCE_DATA) * m_instanceCapacity, instances.data(), GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(INSTANCE_DATA) * instances.size(), instances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  MakeDrawCommand()
+ *
+ *  This method is used for making the indirect command that
+ *  draws instances of a mesh from the shared buffers.
+ ***********************************************************/
+SceneMeshes::DRAW_COMMAND SceneMeshes::MakeDrawCommand(const MESH_RANGE& mesh, int count, int firstInstance) const
+{
+	DRAW_COMMAND command;
+
+	command.count = mesh.nIndices;
+	command.instanceCount = (count > 0) ? (GLuint)count : 0;
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = mesh.baseVertex;
+	command.baseInstance = (GLuint)firstInstance;
+
+	return(command);
+}
+
+/***********************************************************
+ *  Get*MeshCommand()
+ *
+ *  These methods are used for making the indirect command
+ *  that draws instances of each of the basic shape meshes.
+ ***********************************************************/
+SceneMeshes::DRAW_COMMAND SceneMeshes::GetPlaneMeshCommand(int count, int firstInstance) const
+{
+	return(MakeDrawCommand(m_planeMesh, count, firstInstance));
+}
+
+SceneMeshes::DRAW_COMMAND SceneMeshes::GetBoxMeshCommand(int count, int firstInstance) const
+{
+	return(MakeDrawCommand(m_boxMesh, count, firstInstance));
+}
+
+SceneMeshes::DRAW_COMMAND SceneMeshes::GetTorusMeshCommand(int count, int firstInstance, int level) const
+{
+	level = glm::clamp(level, 0, glm::max(m_torusLevels - 1, 0));
+	return(MakeDrawCommand(m_torusMesh[level], count, firstInstance));
+}
+
+SceneMeshes::DRAW_COMMAND SceneMeshes::GetCylinderMeshCommand(int count, int firstInstance, int level) const
+{
+	level = glm::clamp(level, 0, glm::max(m_cylinderLevels - 1, 0));
+	return(MakeDrawCommand(m_cylinderMesh[level], count, firstInstance));
+}
+
+SceneMeshes::DRAW_COMMAND SceneMeshes::GetConeMeshCommand(int count, int firstInstance, int level) const
+{
+	level = glm::clamp(level, 0, glm::max(m_coneLevels - 1, 0));
+	return(MakeDrawCommand(m_coneMesh[level], count, firstInstance));
+}
+
+/***********************************************************
+ *  SetDrawCommands()
+ *
+ *  This method is used for uploading the commands that the
+ *  next indirect draw submits.  Like the instance buffer, the
+ *  command buffer storage only grows.
+ ***********************************************************/
+void SceneMeshes::SetDrawCommands(const std::vector<DRAW_COMMAND>& commands)
+{
+	m_commandCount = (GLsizei)commands.size();
+	if ((m_commandBuffer == 0) || (commands.empty()))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	if (commands.size() > m_commandCapacity)
+	{
+		m_commandCapacity = commands.size();
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DRAW_COMMAND) * m_commandCapacity, commands.data(), GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DRAW_COMMAND) * commands.size(), commands.data());
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing every uploaded command in
+ *  order with a single call.  The shaders can tell the draws
+ *  apart by gl_DrawID, the index of the command being drawn.
+ ***********************************************************/
+void SceneMeshes::DrawIndirect()
+{
+	MultiDrawIndirect(m_vao, 0, m_commandCount);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands with a single call, such as only the opaque or
+ *  only the translucent draws.  gl_DrawID starts again from
+ *  0 at the first command of the range.
+ ***********************************************************/
+void SceneMeshes::DrawIndirect(int firstCommand, int commandCount)
+{
+	MultiDrawIndirect(m_vao, firstCommand, commandCount);
+}
+
+/***********************************************************
+ *  DrawIndirectPositions()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands from the packed positions, for passes that only
+ *  write depth and have no use for normals or texture
+ *  coordinates.
+ ***********************************************************/
+void SceneMeshes::DrawIndirectPositions(int firstCommand, int commandCount)
+{
+	MultiDrawIndirect(m_positionVao, firstCommand, commandCount);
+}
+
+/***********************************************************
+ *  MultiDrawIndirect()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands through one of the vertex array objects.
+ ***********************************************************/
+void SceneMeshes::MultiDrawIndirect(GLuint vao, int firstCommand, int commandCount)
+{
+	firstCommand = glm::max(firstCommand, 0);
+	commandCount = glm::min(commandCount, (int)m_commandCount - firstCommand);
+	if ((vao == 0) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(DRAW_COMMAND) * firstCommand),
+		commandCount,
+		0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawIndirectCount()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands with a single call, stopping at the draw count
+ *  held in a buffer so that the GPU decides how many of them
+ *  are drawn.  gl_DrawID starts again from 0 at the first
+ *  command of the range.
+ ***********************************************************/
+void SceneMeshes::DrawIndirectCount(GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount)
+{
+	MultiDrawIndirectCount(m_vao, drawCountBuffer, drawCountOffset, firstCommand, maxCommandCount);
+}
+
+/***********************************************************
+ *  DrawIndirectPositionsCount()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands up to the draw count held in a buffer, with the
+ *  vertex array that reads only the positions and the
+ *  instance values.
+ ***********************************************************/
+void SceneMeshes::DrawIndirectPositionsCount(GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount)
+{
+	MultiDrawIndirectCount(m_positionVao, drawCountBuffer, drawCountOffset, firstCommand, maxCommandCount);
+}
+
+/***********************************************************
+ *  MultiDrawIndirectCount()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands through one of the vertex array objects, as many
+ *  of them as the draw count in a buffer says.
+ ***********************************************************/
+void SceneMeshes::MultiDrawIndirectCount(GLuint vao, GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount)
+{
+	firstCommand = glm::max(firstCommand, 0);
+	maxCommandCount = glm::min(maxCommandCount, (int)m_commandCount - firstCommand);
+	if ((vao == 0) || (maxCommandCount <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+	// core since OpenGL 4.6, an extension before that
+	if (GLEW_VERSION_4_6)
+	{
+		glMultiDrawElementsIndirectCount(
+			GL_TRIANGLES,
+			GL_UNSIGNED_INT,
+			(void*)(sizeof(DRAW_COMMAND) * firstCommand),
+			drawCountOffset,
+			maxCommandCount,
+			0);
+	}
+	else
+	{
+		glMultiDrawElementsIndirectCountARB(
+			GL_TRIANGLES,
+			GL_UNSIGNED_INT,
+			(void*)(sizeof(DRAW_COMMAND) * firstCommand),
+			drawCountOffset,
+			maxCommandCount,
+			0);
+	}
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing instances of a mesh with
+ *  the instance values starting at firstInstance.
+ ***********************************************************/
+void SceneMeshes::DrawMeshInstanced(const MESH_RANGE& mesh, int count, int firstInstance)
+{
+	if ((m_vao == 0) || (mesh.nIndices == 0) || (count <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_vao);
+	glDrawElementsInstancedBaseVertexBaseInstance(
+		GL_TRIANGLES,
+		mesh.nIndices,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(GLuint) * mesh.firstIndex),
+		count,
+		mesh.baseVertex,
+		firstInstance);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Draw*MeshInstanced()
+ *
+ *  These methods are used for drawing instances of each of
+ *  the basic shape meshes.
+ ***********************************************************/
+void SceneMeshes::DrawPlaneMeshInstanced(int count, int firstInstance)
+{
+	DrawMeshInstanced(m_planeMesh, count, firstInstance);
+}
+
+void SceneMeshes::DrawBoxMeshInstanced(int count, int firstInstance)
+{
+	DrawMeshInstanced(m_boxMesh, count, firstInstance);
+}
+
+void SceneMeshes::DrawTorusMeshInstanced(int count, int firstInstance)
+{
+	DrawMeshInstanced(m_torusMesh[0], count, firstInstance);
+}
+
+void SceneMeshes::DrawCylinderMeshInstanced(int count, int firstInstance)
+{
+	DrawMeshInstanced(m_cylinderMesh[0], count, firstInstance);
+}
+
+void SceneMeshes::DrawConeMeshInstanced(int count, int firstInstance)
+{
+	DrawMeshInstanced(m_coneMesh[0], count, firstInstance);
+}
+
+/***********************************************************
+ *  GetMeshBytes()
+ *
+ *  This method is used for adding up the vertex and index
+ *  data held in the shared buffers for the levels of detail
+ *  of a mesh, for comparing against other ways of drawing it.
+ ***********************************************************/
+size_t SceneMeshes::GetMeshBytes(const MESH_RANGE* levels, int levelCount)
+{
+	size_t bytes = 0;
+
+	for (int level = 0; level < levelCount; level++)
+	{
+		bytes += sizeof(GLfloat) * FLOATS_PER_VERTEX * levels[level].nVertices;
+		bytes += sizeof(GLuint) * levels[level].nIndices;
+	}
+
+	return(bytes);
+}
@@ -0,0 +1,202 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.h
+// ============
+// basic shape meshes in shared buffers with instanced and indirect draws
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolume.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneMeshes
+ *
+ *  This class builds the same plane, box, torus and cylinder
+ *  primitives as ShapeMeshes, plus a cone.  Every mesh is
+ *  suballocated from one shared vertex buffer and one shared
+ *  index buffer behind a single vertex array object.  Every mesh also reads
+ *  a per-instance model matrix, color and material index from
+ *  a shared instance buffer, so any number of copies of any of
+ *  the meshes can be drawn with a single multi-draw indirect
+ *  call.  The positions are also kept in a tightly packed
+ *  buffer of their own, so depth-only passes fetch a third of
+ *  the vertex data.
+ ***********************************************************/
+class SceneMeshes
+{
+public:
+	// constructor
+	SceneMeshes();
+	// destructor
+	~SceneMeshes();
+
+	// per-instance values read by the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 modelMatrix;
+		glm::vec4 color;
+		// index into the material buffer, or -1 for none
+		GLint materialIndex;
+	};
+
+	// one draw in the indirect command buffer, laid out as
+	// glMultiDrawElementsIndirect expects
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// most levels of detail a curved mesh can be built with
+	static const int MAX_LOD_LEVELS = 4;
+
+	// build the meshes into the shared buffers, the curved
+	// meshes with up to MAX_LOD_LEVELS levels of detail that
+	// halve the number of segments from one level to the next
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadTorusMesh(float thickness = 0.1f, int levels = 1);
+	void LoadCylinderMesh(int levels = 1);
+	void LoadConeMesh(int levels = 1);
+
+	// get the number of loaded levels of detail of each mesh
+	int GetTorusMeshLevels() const { return(m_torusLevels); }
+	int GetCylinderMeshLevels() const { return(m_cylinderLevels); }
+	int GetConeMeshLevels() const { return(m_coneLevels); }
+
+	// get the bytes of vertex and index data held for every
+	// loaded level of detail of each curved mesh
+	size_t GetTorusMeshBytes() const { return(GetMeshBytes(m_torusMesh, m_torusLevels)); }
+	size_t GetCylinderMeshBytes() const { return(GetMeshBytes(m_cylinderMesh, m_cylinderLevels)); }
+	size_t GetConeMeshBytes() const { return(GetMeshBytes(m_coneMesh, m_coneLevels)); }
+
+	// get the local bounding volume of each mesh, the bounds
+	// of the finest level enclose the coarser levels
+	const BOUNDING_VOLUME& GetPlaneMeshBounds() const { return(m_planeMesh.bounds); }
+	const BOUNDING_VOLUME& GetBoxMeshBounds() const { return(m_boxMesh.bounds); }
+	const BOUNDING_VOLUME& GetTorusMeshBounds() const { return(m_torusMesh[0].bounds); }
+	const BOUNDING_VOLUME& GetCylinderMeshBounds() const { return(m_cylinderMesh[0].bounds); }
+	const BOUNDING_VOLUME& GetConeMeshBounds() const { return(m_coneMesh[0].bounds); }
+
+	// upload the per-instance values for the next draws
+	void SetInstanceData(const std::vector<INSTANCE_DATA>& instances);
+
+	// make the indirect command that draws count copies of a
+	// mesh, reading the instance values starting at firstInstance,
+	// at a level of detail where the mesh has them
+	DRAW_COMMAND GetPlaneMeshCommand(int count, int firstInstance = 0) const;
+	DRAW_COMMAND GetBoxMeshCommand(int count, int firstInstance = 0) const;
+	DRAW_COMMAND GetTorusMeshCommand(int count, int firstInstance = 0, int level = 0) const;
+	DRAW_COMMAND GetCylinderMeshCommand(int count, int firstInstance = 0, int level = 0) const;
+	DRAW_COMMAND GetConeMeshCommand(int count, int firstInstance = 0, int level = 0) const;
+
+	// upload the commands for the next indirect draw
+	void SetDrawCommands(const std::vector<DRAW_COMMAND>& commands);
+	// draw every uploaded command with one call
+	void DrawIndirect();
+	// draw a range of the uploaded commands with one call, the
+	// shaders see gl_DrawID counting from 0 at firstCommand
+	void DrawIndirect(int firstCommand, int commandCount);
+	// draw a range of the uploaded commands reading only the
+	// vertex positions and the instance values, for depth passes
+	void DrawIndirectPositions(int firstCommand, int commandCount);
+	// draw a range of the uploaded commands with one call, as
+	// many of them as the draw count at an offset in a buffer
+	// says, for commands written on the GPU
+	void DrawIndirectCount(GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount);
+	// draw a range of the uploaded commands up to a draw count
+	// in a buffer, reading only the vertex positions and the
+	// instance values, for depth passes
+	void DrawIndirectPositionsCount(GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount);
+
+	// buffers the instance values and commands are read from,
+	// for culling passes that write them on the GPU
+	GLuint GetInstanceBuffer() const { return(m_instanceBuffer); }
+	GLuint GetCommandBuffer() const { return(m_commandBuffer); }
+	// set up the per-instance attributes of the bound vertex
+	// array object to read the shared instance buffer, so other
+	// geometry can be drawn with the same instances
+	void SetupInstanceAttributes() const;
+
+	// draw count copies of a mesh, reading the instance values
+	// starting at firstInstance in the instance buffer
+	void DrawPlaneMeshInstanced(int count, int firstInstance = 0);
+	void DrawBoxMeshInstanced(int count, int firstInstance = 0);
+	void DrawTorusMeshInstanced(int count, int firstInstance = 0);
+	void DrawCylinderMeshInstanced(int count, int firstInstance = 0);
+	void DrawConeMeshInstanced(int count, int firstInstance = 0);
+
+private:
+	// the range of the shared buffers that holds a given mesh
+	struct MESH_RANGE
+	{
+		GLuint firstIndex;  // offset of the first index in the index buffer
+		GLuint nIndices;    // number of indices for the mesh
+		GLint baseVertex;   // offset of the first vertex in the vertex buffer
+		GLuint nVertices;   // number of vertices for the mesh
+		BOUNDING_VOLUME bounds;  // bounds of the vertices in model space
+	};
+
+	MESH_RANGE m_planeMesh;
+	MESH_RANGE m_boxMesh;
+	// curved meshes, one range per level of detail
+	MESH_RANGE m_torusMesh[MAX_LOD_LEVELS];
+	MESH_RANGE m_cylinderMesh[MAX_LOD_LEVELS];
+	MESH_RANGE m_coneMesh[MAX_LOD_LEVELS];
+	int m_torusLevels;
+	int m_cylinderLevels;
+	int m_coneLevels;
+
+	// vertex and index data of every loaded mesh, kept so the
+	// shared buffers can be uploaded again as meshes are added
+	std::vector<GLfloat> m_vertices;
+	std::vector<GLuint> m_indices;
+
+	// vertex array object and shared buffers for all the meshes
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// vertex array object reading only the positions, from a
+	// buffer of their own, and the same index buffer
+	GLuint m_positionVao;
+	GLuint m_positionBuffer;
+	// per-instance values shared by all the meshes
+	GLuint m_instanceBuffer;
+	// number of instances the instance buffer can hold
+	size_t m_instanceCapacity;
+	// indirect draw commands and how many of them are uploaded
+	GLuint m_commandBuffer;
+	size_t m_commandCapacity;
+	GLsizei m_commandCount;
+
+	// append the vertex and index data of a mesh to the shared
+	// buffers and record where it was placed
+	void AppendMesh(
+		MESH_RANGE& mesh,
+		const std::vector<GLfloat>& vertices,
+		const std::vector<GLuint>& indices);
+	// create the vertex array object and set up the vertex and
+	// instance attributes of the shared buffers
+	void CreateVertexArray();
+	// make the indirect command for instances of a mesh
+	DRAW_COMMAND MakeDrawCommand(const MESH_RANGE& mesh, int count, int firstInstance) const;
+	// draw instances of a loaded mesh
+	void DrawMeshInstanced(const MESH_RANGE& mesh, int count, int firstInstance);
+	// draw a range of the uploaded commands through a vertex array
+	void MultiDrawIndirect(GLuint vao, int firstCommand, int commandCount);
+	// draw a range of the uploaded commands through a vertex
+	// array, up to the draw count held in a buffer
+	void MultiDrawIndirectCount(GLuint vao, GLuint drawCountBuffer, GLintptr drawCountOffset, int firstCommand, int maxCommandCount);
+	// add up the vertex and index bytes of the levels of a mesh
+	static size_t GetMeshBytes(const MESH_RANGE* levels, int levelCount);
+};
@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneuniformbuffer.cpp
+// ============
+// hold the view and light values read by every scene shader program in
+// one uniform buffer
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneUniformBuffer.h"
+
+/***********************************************************
+ *  SceneUniformBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneUniformBuffer::SceneUniformBuffer()
+{
+	m_buffer = 0;
+	m_values = SCENE_UNIFORMS();
+	m_values.view = glm::mat4(1.0f);
+	m_values.projection = glm::mat4(1.0f);
+	m_bDirty = true;
+}
+
+/***********************************************************
+ *  ~SceneUniformBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneUniformBuffer::~SceneUniformBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the uniform buffer with
+ *  room for the whole block.  The buffer is written once a
+ *  frame at most, so it is marked for dynamic use.
+ ***********************************************************/
+bool SceneUniformBuffer::Initialize()
+{
+	// the block in the shaders is 464 bytes, any other size
+	// means the padding no longer follows the std140 layout
+	static_assert(sizeof(SCENE_UNIFORMS) == 464, "SCENE_UNIFORMS does not match the SceneUniforms block");
+
+	if (m_buffer != 0)
+	{
+		return(true);
+	}
+
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferData(m_buffer, sizeof(SCENE_UNIFORMS), &m_values, GL_DYNAMIC_DRAW);
+	m_bDirty = false;
+
+	return(m_buffer != 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for deleting the uniform buffer.
+ ***********************************************************/
+void SceneUniformBuffer::Destroy()
+{
+	if (m_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the buffer to the binding
+ *  point of the SceneUniforms block, where it is read by any
+ *  program that declares the block.
+ ***********************************************************/
+void SceneUniformBuffer::Bind() const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_UNIFORM_BINDING, m_buffer);
+}
+
+/***********************************************************
+ *  SetView()
+ *
+ *  This method is used for setting the view and projection
+ *  matrices and the camera position of the frame.
+ ***********************************************************/
+void SceneUniformBuffer::SetView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition)
+{
+	if ((view != m_values.view) || (projection != m_values.projection) || (viewPosition != m_values.viewPosition))
+	{
+		m_values.view = view;
+		m_values.projection = projection;
+		m_values.viewPosition = viewPosition;
+		m_bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetUseLighting()
+ *
+ *  This method is used for setting whether the scene is lit
+ *  by the light sources or drawn in its plain colors.
+ ***********************************************************/
+void SceneUniformBuffer::SetUseLighting(bool bUseLighting)
+{
+	GLint value = bUseLighting ? 1 : 0;
+	if (value != m_values.bUseLighting)
+	{
+		m_values.bUseLighting = value;
+		m_bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetLightSource()
+ *
+ *  This method is used for setting the values of one of the
+ *  light sources.  Light sources that are never set stay
+ *  black and add nothing to the scene.
+ ***********************************************************/
+void SceneUniformBuffer::SetLightSource(int index, const LIGHT_SOURCE& light)
+{
+	if ((index < 0) || (index >= TOTAL_LIGHTS))
+	{
+		return;
+	}
+
+	LIGHT_SOURCE_DATA& data = m_values.lightSources[index];
+	data.position = light.position;
+	data.ambientColor = light.ambientColor;
+	data.diffuseColor = light.diffuseColor;
+	data.specularColor = light.specularColor;
+	data.focalStrength = light.focalStrength;
+	data.specularIntensity = light.specularIntensity;
+	m_bDirty = true;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for writing the whole block to the
+ *  buffer when any value has changed since the last upload.
+ *  The block is small enough that writing it all costs no
+ *  more than tracking which parts changed.
+ ***********************************************************/
+void SceneUniformBuffer::Upload()
+{
+	if ((m_buffer == 0) || (m_bDirty == false))
+	{
+		return;
+	}
+
+	glNamedBufferSubData(m_buffer, 0, sizeof(SCENE_UNIFORMS), &m_values);
+	m_bDirty = false;
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneuniformbuffer.h
+// ============
+// hold the view and light values read by every scene shader program in
+// one uniform buffer
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// uniform buffer binding of the SceneUniforms block declared
+// by the scene shaders
+const GLuint SCENE_UNIFORM_BINDING = 0;
+
+/***********************************************************
+ *  SceneUniformBuffer
+ *
+ *  This class keeps the view, projection, camera position
+ *  and light sources in a std140 uniform buffer that every
+ *  program drawing the scene reads through the same block,
+ *  so a pass that switches programs has nothing to copy or
+ *  set again.  The values are gathered on the CPU and the
+ *  buffer is only written when one of them has changed.
+ ***********************************************************/
+class SceneUniformBuffer
+{
+public:
+	// constructor
+	SceneUniformBuffer();
+	// destructor
+	~SceneUniformBuffer();
+
+	// most light sources the shaders add up, TOTAL_LIGHTS in
+	// the shaders
+	static const int TOTAL_LIGHTS = 4;
+
+	// values of one light source
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// create the uniform buffer
+	bool Initialize();
+	// free the uniform buffer
+	void Destroy();
+	// bind the buffer to the binding of the SceneUniforms block
+	void Bind() const;
+
+	// set the camera values of the frame
+	void SetView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition);
+	// set whether the scene is lit by the light sources
+	void SetUseLighting(bool bUseLighting);
+	// set the values of one of the light sources
+	void SetLightSource(int index, const LIGHT_SOURCE& light);
+
+	// write the values to the buffer when any of them changed
+	// since the last upload
+	void Upload();
+
+private:
+	// a light source laid out by the std140 rules, where every
+	// vec3 starts on 16 bytes and a float may fill the gap
+	struct LIGHT_SOURCE_DATA
+	{
+		glm::vec3 position;
+		float padding0;
+		glm::vec3 ambientColor;
+		float padding1;
+		glm::vec3 diffuseColor;
+		float padding2;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+		float padding3[3];
+	};
+
+	// the SceneUniforms block laid out by the std140 rules
+	struct SCENE_UNIFORMS
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec3 viewPosition;
+		GLint bUseLighting;
+		LIGHT_SOURCE_DATA lightSources[TOTAL_LIGHTS];
+	};
+
+	GLuint m_buffer;
+	SCENE_UNIFORMS m_values;
+	// true when the values changed since the last upload
+	bool m_bDirty;
+};
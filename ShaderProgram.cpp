@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.cpp
+// ============
+// build shader programs from any set of stages, for the passes that go
+// beyond the vertex and fragment shaders loaded by ShaderManager
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderProgram.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CompileShaderFiles()
+ *
+ *  This function is used for compiling a shader stage from
+ *  the text of one or more files, passed to the compiler as
+ *  separate strings in order.  This lets stages share common
+ *  functions kept in a file of their own.
+ ***********************************************************/
+GLuint CompileShaderFiles(
+	GLenum shaderType,
+	const char* const* filenames,
+	int fileCount)
+{
+	std::vector<std::string> sources;
+	std::vector<const char*> sourceTexts;
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		std::ifstream shaderFile(filenames[i]);
+		if (shaderFile.is_open() == false)
+		{
+			std::cout << "ERROR: could not open shader file " << filenames[i] << std::endl;
+			return(0);
+		}
+
+		std::stringstream shaderStream;
+		shaderStream << shaderFile.rdbuf();
+		sources.push_back(shaderStream.str());
+	}
+	for (const std::string& source : sources)
+	{
+		sourceTexts.push_back(source.c_str());
+	}
+
+	GLuint shader = glCreateShader(shaderType);
+	glShaderSource(shader, (GLsizei)sourceTexts.size(), sourceTexts.data(), NULL);
+	glCompileShader(shader);
+
+	GLint success = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		char infoLog[1024];
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: shader " << filenames[fileCount - 1] << " failed to compile\n" << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  LinkShaderProgram()
+ *
+ *  This function is used for linking compiled stages into a
+ *  program.  The stages are deleted either way, since the
+ *  program keeps what it needs from them.
+ ***********************************************************/
+GLuint LinkShaderProgram(
+	const GLuint* shaders,
+	int shaderCount)
+{
+	bool bComplete = true;
+	for (int i = 0; i < shaderCount; i++)
+	{
+		if (shaders[i] == 0)
+		{
+			bComplete = false;
+		}
+	}
+
+	GLuint program = 0;
+	if (bComplete == true)
+	{
+		program = glCreateProgram();
+		for (int i = 0; i < shaderCount; i++)
+		{
+			glAttachShader(program, shaders[i]);
+		}
+		glLinkProgram(program);
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR: shader program failed to link\n" << infoLog << std::endl;
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	for (int i = 0; i < shaderCount; i++)
+	{
+		if (shaders[i] != 0)
+		{
+			glDeleteShader(shaders[i]);
+		}
+	}
+
+	return(program);
+}
@@ -0,0 +1,26 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.h
+// ============
+// build shader programs from any set of stages, for the passes that go
+// beyond the vertex and fragment shaders loaded by ShaderManager
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+// compile one shader stage from the concatenated text of one or
+// more files, the first of which has to hold the #version line,
+// 0 when a file cannot be read or the shader does not compile
+GLuint CompileShaderFiles(
+	GLenum shaderType,
+	const char* const* filenames,
+	int fileCount);
+
+// link compiled shader stages into a program and release the
+// stages, 0 when a stage is missing or the program does not link
+GLuint LinkShaderProgram(
+	const GLuint* shaders,
+	int shaderCount);
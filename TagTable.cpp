@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagtable.cpp
+// ============
+// intern string tags into dense integer handles
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagTable.h"
+
+/***********************************************************
+ *  TagTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TagTable::TagTable()
+{
+}
+
+/***********************************************************
+ *  ~TagTable()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TagTable::~TagTable()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Intern()
+ *
+ *  This method is used for getting the handle for a tag.  A
+ *  tag that has not been seen before is given the next dense
+ *  handle.
+ ***********************************************************/
+int TagTable::Intern(const std::string& tag)
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_handles.find(tag);
+	if (found != m_handles.end())
+	{
+		return(found->second);
+	}
+
+	int handle = (int)m_tags.size();
+	m_handles[tag] = handle;
+	m_tags.push_back(tag);
+
+	return(handle);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the handle for a tag that
+ *  has already been interned, or -1 when it has not.
+ ***********************************************************/
+int TagTable::Find(const std::string& tag) const
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_handles.find(tag);
+	if (found == m_handles.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the interned tags.
+ ***********************************************************/
+void TagTable::Clear()
+{
+	m_handles.clear();
+	m_tags.clear();
+}
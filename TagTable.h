@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagtable.h
+// ============
+// intern string tags into dense integer handles
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TagTable
+ *
+ *  This class turns the string tags that name textures and
+ *  materials into dense integer handles.  Tags are interned
+ *  once, in the order their resources are loaded, so that
+ *  handle N refers to the Nth loaded resource, and are then
+ *  looked up with a single hash instead of a linear scan of
+ *  string compares.
+ ***********************************************************/
+class TagTable
+{
+public:
+	// constructor
+	TagTable();
+	// destructor
+	~TagTable();
+
+	// get the handle for a tag, adding the tag with the next
+	// handle when it has not been interned yet
+	int Intern(const std::string& tag);
+	// get the handle for an interned tag, -1 when not found
+	int Find(const std::string& tag) const;
+	// get the tag for a handle
+	const std::string& GetTag(int handle) const { return(m_tags[handle]); }
+	// number of interned tags
+	int GetCount() const { return((int)m_tags.size()); }
+	// remove all the interned tags
+	void Clear();
+
+private:
+	// handle of every interned tag
+	std::unordered_map<std::string, int> m_handles;
+	// tag of every handle
+	std::vector<std::string> m_tags;
+};
@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellatedmeshes.cpp
+// ============
+// curved shapes drawn as coarse parametric patches that the GPU subdivides
+// to match their size on screen
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TessellatedMeshes.h"
+#include "TextureUnits.h"
+
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// floats per patch corner - surface U and V, and surface id
+	const int FLOATS_PER_CORNER = 3;
+	const int CORNERS_PER_PATCH = 4;
+	const GLuint PATCH_CORNER_ATTRIBUTE = 0;
+
+	// surfaces evaluated by the tessellation shaders, these
+	// have to match the SURFACE_ defines of the surface file
+	const float SURFACE_TORUS = 0.0f;
+	const float SURFACE_CYLINDER_SIDE = 1.0f;
+	const float SURFACE_CYLINDER_BOTTOM = 2.0f;
+	const float SURFACE_CYLINDER_TOP = 3.0f;
+	const float SURFACE_CONE_SIDE = 4.0f;
+	const float SURFACE_CONE_BOTTOM = 5.0f;
+
+	// patches around every shape, enough that a patch stays
+	// close to flat when it is only subdivided a little
+	const int PATCHES_AROUND = 8;
+	const int TORUS_TUBE_PATCHES = 4;
+
+	/***********************************************************
+	 *  AddPatchGrid()
+	 *
+	 *  Append a grid of quad patches covering the whole U and V
+	 *  range of a surface, with the corners of each patch in
+	 *  the order the control and evaluation shaders expect.
+	 ***********************************************************/
+	void AddPatchGrid(
+		std::vector<GLfloat>& corners,
+		float surface,
+		int uPatches,
+		int vPatches)
+	{
+		const float cornerOffsets[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+		for (int i = 0; i < uPatches; i++)
+		{
+			for (int j = 0; j < vPatches; j++)
+			{
+				for (int corner = 0; corner < CORNERS_PER_PATCH; corner++)
+				{
+					corners.push_back((i + cornerOffsets[corner][0]) / uPatches);
+					corners.push_back((j + cornerOffsets[corner][1]) / vPatches);
+					corners.push_back(surface);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TessellatedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TessellatedMeshes::TessellatedMeshes()
+{
+	m_torusPatches = {};
+	m_cylinderPatches = {};
+	m_conePatches = {};
+	m_program = 0;
+	m_viewportSizeLocation = -1;
+	m_targetEdgePixelsLocation = -1;
+	m_drawIndexLocation = -1;
+	m_weightedBlendedLocation = -1;
+	m_targetEdgePixels = 8.0f;
+	m_vao = 0;
+	m_patchBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TessellatedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TessellatedMeshes::~TessellatedMeshes()
+{
+	if (m_program != 0)
+	{
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_patchBuffer);
+		m_vao = 0;
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that the driver can run
+ *  tessellation shaders, core since OpenGL 4.0.
+ ***********************************************************/
+bool TessellatedMeshes::IsSupported()
+{
+	return(GLEW_ARB_tessellation_shader ? true : false);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the patches of every
+ *  shape into one patch buffer and linking the tessellation
+ *  program.  The patch buffer shares the instance attributes
+ *  of the scene meshes, so the same instance values drive
+ *  both ways of drawing.  Calling it again once it has
+ *  succeeded does nothing.
+ ***********************************************************/
+bool TessellatedMeshes::Initialize(
+	const SceneMeshes* pSceneMeshes,
+	float torusThickness,
+	const char* surfaceShaderFile,
+	const char* vertexShaderFile,
+	const char* controlShaderFile,
+	const char* evaluationShaderFile,
+	const char* fragmentShaderFile)
+{
+	if (m_program != 0)
+	{
+		return(true);
+	}
+	if (NULL == pSceneMeshes)
+	{
+		return(false);
+	}
+
+	const char* controlFiles[] = { surfaceShaderFile, controlShaderFile };
+	const char* evaluationFiles[] = { surfaceShaderFile, evaluationShaderFile };
+	GLuint shaders[4];
+	shaders[0] = CompileShaderFiles(GL_VERTEX_SHADER, &vertexShaderFile, 1);
+	shaders[1] = CompileShaderFiles(GL_TESS_CONTROL_SHADER, controlFiles, 2);
+	shaders[2] = CompileShaderFiles(GL_TESS_EVALUATION_SHADER, evaluationFiles, 2);
+	shaders[3] = CompileShaderFiles(GL_FRAGMENT_SHADER, &fragmentShaderFile, 1);
+	m_program = LinkShaderProgram(shaders, 4);
+	if (m_program == 0)
+	{
+		return(false);
+	}
+
+	m_viewportSizeLocation = glGetUniformLocation(m_program, "viewportSize");
+	m_targetEdgePixelsLocation = glGetUniformLocation(m_program, "targetEdgePixels");
+	m_drawIndexLocation = glGetUniformLocation(m_program, "drawIndex");
+	m_weightedBlendedLocation = glGetUniformLocation(m_program, "bWeightedBlended");
+	glProgramUniform1f(m_program, glGetUniformLocation(m_program, "torusThickness"), torusThickness);
+	glProgramUniform1f(m_program, m_targetEdgePixelsLocation, m_targetEdgePixels);
+
+	// without bindless handles each texture array is read from
+	// the texture unit of the same number, as in the main program
+	for (GLuint unit = 0; unit < SCENE_TEXTURE_ARRAY_UNITS; unit++)
+	{
+		std::string elementName = "textureArrays[" + std::to_string(unit) + "]";
+		glProgramUniform1i(m_program, glGetUniformLocation(m_program, elementName.c_str()), (GLint)unit);
+	}
+
+	// the torus wraps in both directions, the cylinder and the
+	// cone are one ring of patches per side and cap
+	std::vector<GLfloat> corners;
+	m_torusPatches.firstVertex = 0;
+	AddPatchGrid(corners, SURFACE_TORUS, PATCHES_AROUND, TORUS_TUBE_PATCHES);
+	m_torusPatches.nVertices = (GLsizei)(corners.size() / FLOATS_PER_CORNER) - m_torusPatches.firstVertex;
+
+	m_cylinderPatches.firstVertex = (GLint)(corners.size() / FLOATS_PER_CORNER);
+	AddPatchGrid(corners, SURFACE_CYLINDER_SIDE, PATCHES_AROUND, 1);
+	AddPatchGrid(corners, SURFACE_CYLINDER_BOTTOM, PATCHES_AROUND, 1);
+	AddPatchGrid(corners, SURFACE_CYLINDER_TOP, PATCHES_AROUND, 1);
+	m_cylinderPatches.nVertices = (GLsizei)(corners.size() / FLOATS_PER_CORNER) - m_cylinderPatches.firstVertex;
+
+	m_conePatches.firstVertex = (GLint)(corners.size() / FLOATS_PER_CORNER);
+	AddPatchGrid(corners, SURFACE_CONE_SIDE, PATCHES_AROUND, 1);
+	AddPatchGrid(corners, SURFACE_CONE_BOTTOM, PATCHES_AROUND, 1);
+	m_conePatches.nVertices = (GLsizei)(corners.size() / FLOATS_PER_CORNER) - m_conePatches.firstVertex;
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_patchBuffer);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_patchBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * corners.size(), corners.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(PATCH_CORNER_ATTRIBUTE, FLOATS_PER_CORNER, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * FLOATS_PER_CORNER, (void*)0);
+	glEnableVertexAttribArray(PATCH_CORNER_ATTRIBUTE);
+	pSceneMeshes->SetupInstanceAttributes();
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetTargetEdgePixels()
+ *
+ *  This method is used for setting the length in pixels that
+ *  the patch edges are subdivided down to.  Smaller values
+ *  give smoother silhouettes for more triangles.
+ ***********************************************************/
+void TessellatedMeshes::SetTargetEdgePixels(float pixels)
+{
+	m_targetEdgePixels = (pixels > 1.0f) ? pixels : 1.0f;
+	if (m_program != 0)
+	{
+		glProgramUniform1f(m_program, m_targetEdgePixelsLocation, m_targetEdgePixels);
+	}
+}
+
+/***********************************************************
+ *  BeginDraws()
+ *
+ *  This method is used for switching to the tessellation
+ *  program.  The view, projection and light values come from
+ *  the scene uniform buffer and the samplers were set when
+ *  the program was linked, so the patches are lit and
+ *  textured like the rest of the scene with only the values
+ *  of this pass to set.
+ ***********************************************************/
+void TessellatedMeshes::BeginDraws(int viewportWidth, int viewportHeight, bool bWeightedBlended)
+{
+	if (m_program == 0)
+	{
+		return;
+	}
+
+	glUseProgram(m_program);
+	glUniform2f(m_viewportSizeLocation, (float)viewportWidth, (float)viewportHeight);
+	glUniform1i(m_weightedBlendedLocation, bWeightedBlended ? 1 : 0);
+	glBindVertexArray(m_vao);
+	glPatchParameteri(GL_PATCH_VERTICES, CORNERS_PER_PATCH);
+}
+
+/***********************************************************
+ *  DrawPatchesInstanced()
+ *
+ *  This method is used for drawing instances of the patches
+ *  of a shape.  The patch draws are not part of the indirect
+ *  command buffer, so the index of their per-draw values is
+ *  passed in as a uniform instead of read from gl_DrawID.
+ ***********************************************************/
+void TessellatedMeshes::DrawPatchesInstanced(const PATCH_RANGE& patches, int drawIndex, int count, int firstInstance)
+{
+	if ((m_program == 0) || (patches.nVertices == 0) || (count <= 0))
+	{
+		return;
+	}
+
+	glUniform1i(m_drawIndexLocation, drawIndex);
+	glDrawArraysInstancedBaseInstance(
+		GL_PATCHES,
+		patches.firstVertex,
+		patches.nVertices,
+		count,
+		(GLuint)firstInstance);
+}
+
+/***********************************************************
+ *  Draw*PatchesInstanced()
+ *
+ *  These methods are used for drawing instances of each of
+ *  the tessellated shapes.
+ ***********************************************************/
+void TessellatedMeshes::DrawTorusPatchesInstanced(int drawIndex, int count, int firstInstance)
+{
+	DrawPatchesInstanced(m_torusPatches, drawIndex, count, firstInstance);
+}
+
+void TessellatedMeshes::DrawCylinderPatchesInstanced(int drawIndex, int count, int firstInstance)
+{
+	DrawPatchesInstanced(m_cylinderPatches, drawIndex, count, firstInstance);
+}
+
+void TessellatedMeshes::DrawConePatchesInstanced(int drawIndex, int count, int firstInstance)
+{
+	DrawPatchesInstanced(m_conePatches, drawIndex, count, firstInstance);
+}
+
+/***********************************************************
+ *  EndDraws()
+ *
+ *  This method is used for unbinding the patch vertex array
+ *  once the patches have been drawn.
+ ***********************************************************/
+void TessellatedMeshes::EndDraws()
+{
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  GetPatchBytes()
+ *
+ *  This method is used for getting the size of the patch
+ *  buffer, for comparing against the precomputed meshes.
+ ***********************************************************/
+size_t TessellatedMeshes::GetPatchBytes() const
+{
+	size_t corners = (size_t)m_torusPatches.nVertices +
+		(size_t)m_cylinderPatches.nVertices +
+		(size_t)m_conePatches.nVertices;
+
+	return(sizeof(GLfloat) * FLOATS_PER_CORNER * corners);
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellatedmeshes.h
+// ============
+// curved shapes drawn as coarse parametric patches that the GPU subdivides
+// to match their size on screen
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneMeshes.h"
+#include "ShaderProgram.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TessellatedMeshes
+ *
+ *  This class is another way of drawing the torus, cylinder
+ *  and cone of SceneMeshes.  Instead of precomputed meshes
+ *  at a few fixed levels of detail, each shape is a handful
+ *  of quad patches over its parametric surface, and the
+ *  tessellation control shader subdivides every patch edge
+ *  by its length in pixels.  Neighboring patches measure
+ *  their shared edge the same way, so they always agree on
+ *  its subdivision and no cracks open between them.
+ *
+ *  The patches are drawn with the instances and per-draw
+ *  values of the render list, and shaded by the same
+ *  fragment shader as the rest of the scene, whose uniform
+ *  values are copied over from the main program.
+ ***********************************************************/
+class TessellatedMeshes
+{
+public:
+	// constructor
+	TessellatedMeshes();
+	// destructor
+	~TessellatedMeshes();
+
+	// true when the driver has tessellation shaders
+	static bool IsSupported();
+
+	// build the patches and load the shader stages, the
+	// surface file is shared by the tessellation stages and
+	// holds the #version line and the surface functions
+	bool Initialize(
+		const SceneMeshes* pSceneMeshes,
+		float torusThickness,
+		const char* surfaceShaderFile,
+		const char* vertexShaderFile,
+		const char* controlShaderFile,
+		const char* evaluationShaderFile,
+		const char* fragmentShaderFile);
+
+	// length in pixels the patch edges are subdivided down to
+	void SetTargetEdgePixels(float pixels);
+
+	// switch to the tessellation program, ready for the draws,
+	// with the fragments weighted for blended transparency or not
+	void BeginDraws(int viewportWidth, int viewportHeight, bool bWeightedBlended);
+	// draw count copies of the patches of a shape, reading the
+	// instance values starting at firstInstance and the
+	// per-draw values at drawIndex
+	void DrawTorusPatchesInstanced(int drawIndex, int count, int firstInstance);
+	void DrawCylinderPatchesInstanced(int drawIndex, int count, int firstInstance);
+	void DrawConePatchesInstanced(int drawIndex, int count, int firstInstance);
+	// restore the vertex array binding after the draws, the
+	// caller switches back to its own program
+	void EndDraws();
+
+	// bytes of patch data held for all the shapes
+	size_t GetPatchBytes() const;
+
+private:
+	// the range of the patch buffer that holds a given shape
+	struct PATCH_RANGE
+	{
+		GLint firstVertex;
+		GLsizei nVertices;
+	};
+
+	PATCH_RANGE m_torusPatches;
+	PATCH_RANGE m_cylinderPatches;
+	PATCH_RANGE m_conePatches;
+
+	// program and the uniforms set on it directly
+	GLuint m_program;
+	GLint m_viewportSizeLocation;
+	GLint m_targetEdgePixelsLocation;
+	GLint m_drawIndexLocation;
+	GLint m_weightedBlendedLocation;
+	float m_targetEdgePixels;
+
+	// patch corners and the instance attributes they are
+	// drawn with
+	GLuint m_vao;
+	GLuint m_patchBuffer;
+
+	// draw instances of the patches of one shape
+	void DrawPatchesInstanced(const PATCH_RANGE& patches, int drawIndex, int count, int firstInstance);
+};
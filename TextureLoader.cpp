@@ -0,0 +1,504 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture image files on a pool of worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "DecodedTextureCache.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+// declaration of the global variables and defines
+namespace
+{
+	// most worker threads started, the decodes are also
+	// limited by how fast the files can be read
+	const int MAX_WORKER_THREADS = 8;
+
+	// source pixels and their weights for one target pixel
+	struct RESAMPLE_TAP
+	{
+		int first;
+		std::vector<float> weights;
+	};
+
+	/***********************************************************
+	 *  MakeResampleTaps()
+	 *
+	 *  Work out the source pixels read for every target pixel
+	 *  along one axis, weighted by a tent filter as wide as a
+	 *  target pixel when shrinking and as wide as a source
+	 *  pixel when growing, so no source pixel is skipped.
+	 ***********************************************************/
+	void MakeResampleTaps(int sourceSize, int targetSize, std::vector<RESAMPLE_TAP>& taps)
+	{
+		float scale = (float)sourceSize / targetSize;
+		float radius = std::max(scale, 1.0f);
+
+		taps.resize(targetSize);
+		for (int i = 0; i < targetSize; i++)
+		{
+			float center = (i + 0.5f) * scale;
+			int first = std::max((int)floorf(center - radius), 0);
+			int last = std::min((int)ceilf(center + radius), sourceSize - 1);
+
+			RESAMPLE_TAP& tap = taps[i];
+			tap.first = first;
+			tap.weights.clear();
+			float total = 0.0f;
+			for (int source = first; source <= last; source++)
+			{
+				float weight = std::max(1.0f - fabsf(source + 0.5f - center) / radius, 0.0f);
+				tap.weights.push_back(weight);
+				total += weight;
+			}
+			for (float& weight : tap.weights)
+			{
+				weight /= total;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  ResampleImage()
+	 *
+	 *  Resample RGBA pixels to another size, across the rows
+	 *  first and then down the columns, into a buffer of the
+	 *  target size.
+	 ***********************************************************/
+	void ResampleImage(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int targetWidth,
+		int targetHeight,
+		unsigned char* resampled)
+	{
+		std::vector<RESAMPLE_TAP> columnTaps;
+		std::vector<RESAMPLE_TAP> rowTaps;
+		MakeResampleTaps(width, targetWidth, columnTaps);
+		MakeResampleTaps(height, targetHeight, rowTaps);
+
+		std::vector<float> rows((size_t)targetWidth * height * 4);
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < targetWidth; x++)
+			{
+				const RESAMPLE_TAP& tap = columnTaps[x];
+				float* target = &rows[((size_t)y * targetWidth + x) * 4];
+				for (size_t i = 0; i < tap.weights.size(); i++)
+				{
+					const unsigned char* source = &pixels[((size_t)y * width + tap.first + i) * 4];
+					for (int channel = 0; channel < 4; channel++)
+					{
+						target[channel] += source[channel] * tap.weights[i];
+					}
+				}
+			}
+		}
+
+		for (int y = 0; y < targetHeight; y++)
+		{
+			const RESAMPLE_TAP& tap = rowTaps[y];
+			for (int x = 0; x < targetWidth; x++)
+			{
+				float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (size_t i = 0; i < tap.weights.size(); i++)
+				{
+					const float* source = &rows[((size_t)(tap.first + i) * targetWidth + x) * 4];
+					for (int channel = 0; channel < 4; channel++)
+					{
+						sum[channel] += source[channel] * tap.weights[i];
+					}
+				}
+
+				unsigned char* target = &resampled[((size_t)y * targetWidth + x) * 4];
+				for (int channel = 0; channel < 4; channel++)
+				{
+					target[channel] = (unsigned char)std::min(std::max(sum[channel] + 0.5f, 0.0f), 255.0f);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_busyWorkers = 0;
+	m_outstanding = 0;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class.  The worker threads finish
+ *  the files they are decoding, the files still queued are
+ *  dropped, and any images never taken are freed.
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobQueued.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	for (DECODED_IMAGE& image : m_decoded)
+	{
+		FreePixels(image);
+	}
+	m_decoded.clear();
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used for starting one worker thread for
+ *  every core but the one running the context thread.  The
+ *  decoder flips every image vertically, which is set once
+ *  here since the setting is shared by all threads.
+ ***********************************************************/
+void TextureLoader::StartWorkers()
+{
+	stbi_set_flip_vertically_on_load(true);
+
+	int threadCount = (int)std::thread::hardware_concurrency() - 1;
+	if (threadCount < 1)
+	{
+		threadCount = 1;
+	}
+	if (threadCount > MAX_WORKER_THREADS)
+	{
+		threadCount = MAX_WORKER_THREADS;
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  Queue()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded by the next free worker thread.
+ ***********************************************************/
+void TextureLoader::Queue(
+	int textureSlot,
+	const std::string& filename,
+	const CompressedTextureCache::CACHE_INFO* pCache)
+{
+	DECODE_JOB job;
+	job.textureSlot = textureSlot;
+	job.filename = filename;
+	job.bUseCache = (NULL != pCache);
+	if (NULL != pCache)
+	{
+		job.cache = *pCache;
+	}
+	job.resizeWidth = 0;
+	job.resizeHeight = 0;
+	job.resizeFormat = GL_RGBA8;
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueResized()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded and then resampled to the size of a texture array
+ *  made for images of another size, and block compressed
+ *  again when the array holds compressed blocks.  Neither
+ *  cache is read or written for the image.
+ ***********************************************************/
+void TextureLoader::QueueResized(
+	int textureSlot,
+	const std::string& filename,
+	int width,
+	int height,
+	GLenum format)
+{
+	DECODE_JOB job;
+	job.textureSlot = textureSlot;
+	job.filename = filename;
+	job.bUseCache = false;
+	job.cache.bValid = false;
+	job.resizeWidth = width;
+	job.resizeHeight = height;
+	job.resizeFormat = format;
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueJob()
+ *
+ *  This method is used for adding a job to the queue, for the
+ *  next free worker thread.
+ ***********************************************************/
+void TextureLoader::QueueJob(const DECODE_JOB& job)
+{
+	if (m_workers.empty())
+	{
+		StartWorkers();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+		m_outstanding++;
+	}
+	m_jobQueued.notify_one();
+}
+
+/***********************************************************
+ *  TakeDecoded()
+ *
+ *  This method is used for handing the images decoded so far
+ *  over to the caller, who then owns their pixels.
+ ***********************************************************/
+void TextureLoader::TakeDecoded(std::vector<DECODED_IMAGE>& images)
+{
+	images.clear();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	images.swap(m_decoded);
+	m_outstanding -= (int)images.size();
+}
+
+/***********************************************************
+ *  WaitForAll()
+ *
+ *  This method is used for blocking until no file is queued
+ *  or being decoded, for code that needs every texture in
+ *  place before it can go on.
+ ***********************************************************/
+void TextureLoader::WaitForAll()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobFinished.wait(lock, [this]()
+	{
+		return(m_jobs.empty() && (m_busyWorkers == 0));
+	});
+}
+
+/***********************************************************
+ *  GetOutstandingCount()
+ *
+ *  This method is used for getting the number of queued
+ *  images that have not been taken yet.
+ ***********************************************************/
+int TextureLoader::GetOutstandingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_outstanding);
+}
+
+/***********************************************************
+ *  FreePixels()
+ *
+ *  This method is used for freeing the pixels of a taken
+ *  image once they have been uploaded, unless they belong
+ *  to a mapped cache file.
+ ***********************************************************/
+void TextureLoader::FreePixels(DECODED_IMAGE& image)
+{
+	if (NULL == image.pixels)
+	{
+		return;
+	}
+
+	// mapped pixels go away when the cache file is unmapped
+	if (image.bMapped == false)
+	{
+		delete[] image.pixels;
+	}
+	image.pixels = NULL;
+}
+
+/***********************************************************
+ *  DecodeChain()
+ *
+ *  This method is used for decoding an image, resampling it
+ *  to the size of the job when it asks for one, and working
+ *  out every mipmap level below it, so neither the context
+ *  thread nor the GPU has to generate them.  The file is
+ *  read once and hashed from memory before it is decoded, so
+ *  the caches are written with the hash of the very bytes
+ *  the pixels came from.  The pixels are left NULL when the
+ *  file cannot be decoded.
+ ***********************************************************/
+void TextureLoader::DecodeChain(const DECODE_JOB& job, DECODED_IMAGE& image)
+{
+	if (CompressedTextureCache::GetFileStatus(job.filename.c_str(), image.sourceSize, image.modifiedTime) == false)
+	{
+		return;
+	}
+	std::ifstream file(job.filename, std::ios::binary);
+	std::vector<unsigned char> fileBytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	image.contentHash = CompressedTextureCache::HashBytes(fileBytes.data(), fileBytes.size());
+
+	int width = 0;
+	int height = 0;
+	unsigned char* pixels = stbi_load_from_memory(fileBytes.data(), (int)fileBytes.size(), &width, &height, &image.channels, STBI_rgb_alpha);
+	if (NULL == pixels)
+	{
+		return;
+	}
+
+	image.bResized = (job.resizeWidth > 0);
+	image.width = image.bResized ? job.resizeWidth : width;
+	image.height = image.bResized ? job.resizeHeight : height;
+	image.pixels = new unsigned char[DecodedTextureCache::GetChainBytes(image.width, image.height)];
+	if (image.bResized)
+	{
+		ResampleImage(pixels, width, height, image.width, image.height, image.pixels);
+	}
+	else
+	{
+		memcpy(image.pixels, pixels, (size_t)width * height * 4);
+	}
+	stbi_image_free(pixels);
+
+	DecodedTextureCache::BuildChain(image.pixels, image.width, image.height, image.levelBytes);
+}
+
+/***********************************************************
+ *  EncodeChain()
+ *
+ *  This method is used for replacing the RGBA mipmap chain
+ *  of a decoded image with the compressed blocks of every
+ *  level, for a texture array that holds compressed blocks.
+ ***********************************************************/
+void TextureLoader::EncodeChain(GLenum format, DECODED_IMAGE& image)
+{
+	std::vector<std::vector<unsigned char>> levelBlocks;
+	bool bAlpha = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	CompressedTextureCache::EncodeLevels(image.pixels, image.width, image.height, bAlpha, levelBlocks);
+
+	size_t totalBytes = 0;
+	for (const std::vector<unsigned char>& blocks : levelBlocks)
+	{
+		totalBytes += blocks.size();
+	}
+	delete[] image.pixels;
+	image.pixels = new unsigned char[totalBytes];
+	image.bCompressed = true;
+	image.levelBytes.clear();
+
+	size_t offset = 0;
+	for (const std::vector<unsigned char>& blocks : levelBlocks)
+	{
+		memcpy(image.pixels + offset, blocks.data(), blocks.size());
+		image.levelBytes.push_back(blocks.size());
+		offset += blocks.size();
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running a worker thread.  Each
+ *  file is decoded without holding the lock, expanded to
+ *  RGBA so every layer of a texture array has one format,
+ *  with its mipmaps worked out, or read from its valid
+ *  compressed cache.  A cache that is out of date is encoded
+ *  again from the decoded chain before it is handed over.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_jobQueued.wait(lock, [this]()
+		{
+			return(m_bStopping || (m_jobs.empty() == false));
+		});
+		if (m_bStopping)
+		{
+			return;
+		}
+
+		DECODE_JOB job = m_jobs.front();
+		m_jobs.pop_front();
+		m_busyWorkers++;
+		lock.unlock();
+
+		DECODED_IMAGE image;
+		image.textureSlot = job.textureSlot;
+		image.filename = job.filename;
+		image.pixels = NULL;
+		image.bCompressed = false;
+		image.bMapped = false;
+		image.width = 0;
+		image.height = 0;
+		image.channels = 0;
+		image.sourceSize = 0;
+		image.modifiedTime = 0;
+		image.contentHash = 0;
+		image.encodeMilliseconds = 0.0;
+		image.bResized = false;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if ((job.bUseCache == true) && (job.cache.bValid == true))
+		{
+			image.pixels = CompressedTextureCache::ReadLevels(job.cache);
+			image.bCompressed = true;
+			image.width = job.cache.width;
+			image.height = job.cache.height;
+			image.channels = (job.cache.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+			for (const CompressedTextureCache::CACHE_LEVEL& level : job.cache.levels)
+			{
+				image.levelBytes.push_back(level.bytes);
+			}
+		}
+		else
+		{
+			DecodeChain(job, image);
+			if ((NULL != image.pixels) && (job.resizeWidth > 0) && (job.resizeFormat != GL_RGBA8))
+			{
+				EncodeChain(job.resizeFormat, image);
+			}
+		}
+		image.decodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if ((job.bUseCache == true) && (job.cache.bValid == false) && (NULL != image.pixels))
+		{
+			start = std::chrono::steady_clock::now();
+			bool bAlpha = (image.channels == 2) || (image.channels == 4);
+			if (CompressedTextureCache::WriteCache(job.cache, image.pixels, image.width, image.height, bAlpha, image.contentHash) == true)
+			{
+				image.encodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			}
+		}
+
+		lock.lock();
+		m_decoded.push_back(image);
+		m_busyWorkers--;
+		m_jobFinished.notify_all();
+	}
+}
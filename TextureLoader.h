@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture image files on a pool of worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CompressedTextureCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class decodes image files into RGBA pixels on a
+ *  pool of worker threads, so the thread that owns the GL
+ *  context never waits on an image decoder.  The decoded
+ *  images are collected as they finish, and the context
+ *  thread takes them whenever it is ready to upload them.
+ *  An image with a valid compressed cache file is read from
+ *  the cache instead, and one whose cache is missing or out
+ *  of date has its cache written once it is decoded.  No GL
+ *  calls are made by this class.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// image decoded by a worker thread, waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		int textureSlot;
+		std::string filename;
+		// RGBA pixels or compressed blocks of every mipmap level,
+		// NULL when the file could not be decoded
+		unsigned char* pixels;
+		bool bCompressed;
+		// the pixels belong to a mapped cache file and are not
+		// freed with the image
+		bool bMapped;
+		// bytes of each mipmap level in the pixels
+		std::vector<size_t> levelBytes;
+		int width;
+		int height;
+		// channels in the file, before expanding to RGBA
+		int channels;
+		// size and modification time of the file, taken before
+		// it was read, and the hash of the bytes decoded, for
+		// writing the caches without reading the file again
+		uint64_t sourceSize;
+		int64_t modifiedTime;
+		uint64_t contentHash;
+		// time the worker thread spent decoding the file
+		double decodeMilliseconds;
+		// time spent writing a new compressed cache file, 0
+		// when none was written
+		double encodeMilliseconds;
+		// the image was resampled to fit a texture array made
+		// for images of another size
+		bool bResized;
+	};
+
+	// queue an image file to be decoded on a worker thread,
+	// starting the worker threads the first time - with a
+	// cache, the image is read from the cache when it is valid
+	// and the cache is written when it is not
+	void Queue(
+		int textureSlot,
+		const std::string& filename,
+		const CompressedTextureCache::CACHE_INFO* pCache = NULL);
+	// queue an image file to be decoded and resampled to the
+	// size and format of a texture array made for another size
+	void QueueResized(
+		int textureSlot,
+		const std::string& filename,
+		int width,
+		int height,
+		GLenum format);
+	// take the images decoded since the last call, without
+	// waiting for the ones still being decoded
+	void TakeDecoded(std::vector<DECODED_IMAGE>& images);
+	// block until every queued image has been decoded
+	void WaitForAll();
+	// queued images that have not been taken yet
+	int GetOutstandingCount() const;
+	// number of worker threads decoding images
+	int GetThreadCount() const { return((int)m_workers.size()); }
+
+	// free the pixels of a taken image
+	static void FreePixels(DECODED_IMAGE& image);
+
+private:
+	struct DECODE_JOB
+	{
+		int textureSlot;
+		std::string filename;
+		bool bUseCache;
+		CompressedTextureCache::CACHE_INFO cache;
+		// size and format to resample the image to, a width
+		// of 0 keeps the image as it is
+		int resizeWidth;
+		int resizeHeight;
+		GLenum resizeFormat;
+	};
+
+	std::vector<std::thread> m_workers;
+	// files waiting for a worker thread
+	std::deque<DECODE_JOB> m_jobs;
+	// decoded images waiting to be taken
+	std::vector<DECODED_IMAGE> m_decoded;
+	// guards the job and decoded lists and the counters
+	mutable std::mutex m_mutex;
+	// signalled when a job is queued or the workers stop
+	std::condition_variable m_jobQueued;
+	// signalled when a worker finishes a job
+	std::condition_variable m_jobFinished;
+	// workers in the middle of decoding a file
+	int m_busyWorkers;
+	// queued images that have not been taken yet
+	int m_outstanding;
+	bool m_bStopping;
+
+	// start the pool of worker threads
+	void StartWorkers();
+	// add a job to the queue and wake a worker thread for it
+	void QueueJob(const DECODE_JOB& job);
+	// decode an image into an RGBA mipmap chain, resampled to
+	// the size of the job when it has one
+	static void DecodeChain(const DECODE_JOB& job, DECODED_IMAGE& image);
+	// replace the chain of an image with compressed blocks
+	static void EncodeChain(GLenum format, DECODED_IMAGE& image);
+	// take jobs off the queue and decode them until stopped
+	void WorkerLoop();
+};
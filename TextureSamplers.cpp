@@ -0,0 +1,288 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturesamplers.cpp
+// ============
+// sampler objects shared by every scene texture, and a benchmark of the
+// texture bandwidth each filtering mode costs at a distance
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureSamplers.h"
+#include "ShaderProgram.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* const SAMPLER_MODE_NAMES[] = { "bilinear", "trilinear", "anisotropic" };
+
+	// texels per pixel across the screen the benchmark draws
+	// the texture at, from close up to far away
+	const float BENCHMARK_MINIFICATIONS[] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f };
+	// texels per pixel down the screen for every one across,
+	// like a table top seen at a glancing angle
+	const float BENCHMARK_ASPECT = 4.0f;
+	// full screen draws timed for each measurement
+	const int BENCHMARK_DRAWS = 50;
+
+	/***********************************************************
+	 *  ClampAnisotropy()
+	 *
+	 *  Keep an anisotropy between 1 and the hardware limit.
+	 ***********************************************************/
+	float ClampAnisotropy(float anisotropy)
+	{
+		float maxAnisotropy = TextureSamplers::GetMaxAnisotropy();
+		if (anisotropy > maxAnisotropy)
+		{
+			anisotropy = maxAnisotropy;
+		}
+		if (anisotropy < 1.0f)
+		{
+			anisotropy = 1.0f;
+		}
+		return(anisotropy);
+	}
+}
+
+/***********************************************************
+ *  TextureSamplers()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureSamplers::TextureSamplers()
+{
+	for (int i = 0; i < SAMPLER_MODE_COUNT; i++)
+	{
+		m_samplers[i] = 0;
+	}
+	m_anisotropy = 1.0f;
+}
+
+/***********************************************************
+ *  ~TextureSamplers()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureSamplers::~TextureSamplers()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the sampler object for
+ *  every filtering mode.
+ ***********************************************************/
+void TextureSamplers::Initialize(float anisotropy)
+{
+	Destroy();
+
+	m_anisotropy = ClampAnisotropy(anisotropy);
+	for (int i = 0; i < SAMPLER_MODE_COUNT; i++)
+	{
+		m_samplers[i] = CreateSampler((SAMPLER_MODE)i);
+	}
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the sampler objects.
+ ***********************************************************/
+void TextureSamplers::Destroy()
+{
+	for (int i = 0; i < SAMPLER_MODE_COUNT; i++)
+	{
+		if (m_samplers[i] != 0)
+		{
+			glDeleteSamplers(1, &m_samplers[i]);
+			m_samplers[i] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  SetAnisotropy()
+ *
+ *  This method is used for changing the anisotropy of the
+ *  anisotropic sampler.  A new sampler object is made rather
+ *  than changing the old one, whose state cannot change once
+ *  a bindless handle has been made with it, so the caller
+ *  has to bind the sampler or make its handles again.
+ ***********************************************************/
+void TextureSamplers::SetAnisotropy(float anisotropy)
+{
+	m_anisotropy = ClampAnisotropy(anisotropy);
+
+	if (m_samplers[SAMPLER_ANISOTROPIC] != 0)
+	{
+		glDeleteSamplers(1, &m_samplers[SAMPLER_ANISOTROPIC]);
+		m_samplers[SAMPLER_ANISOTROPIC] = CreateSampler(SAMPLER_ANISOTROPIC);
+	}
+}
+
+/***********************************************************
+ *  GetMaxAnisotropy()
+ *
+ *  This method is used for getting the highest anisotropy
+ *  the hardware supports, which is core from OpenGL 4.6.
+ ***********************************************************/
+float TextureSamplers::GetMaxAnisotropy()
+{
+	if ((GLEW_VERSION_4_6 == false) &&
+		(GLEW_ARB_texture_filter_anisotropic == false) &&
+		(GLEW_EXT_texture_filter_anisotropic == false))
+	{
+		return(1.0f);
+	}
+
+	GLfloat maxAnisotropy = 1.0f;
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+	return(maxAnisotropy);
+}
+
+/***********************************************************
+ *  CreateSampler()
+ *
+ *  This method is used for creating the sampler object for
+ *  one filtering mode, repeating the texture in both
+ *  directions like the scene textures expect.
+ ***********************************************************/
+GLuint TextureSamplers::CreateSampler(SAMPLER_MODE mode) const
+{
+	GLuint sampler = 0;
+	glCreateSamplers(1, &sampler);
+
+	// set the texture wrapping parameters
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (mode == SAMPLER_BILINEAR)
+	{
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	}
+	else
+	{
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	}
+
+	if ((mode == SAMPLER_ANISOTROPIC) && (m_anisotropy > 1.0f))
+	{
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, m_anisotropy);
+	}
+
+	return(sampler);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing full screen draws of a
+ *  texture array layer with each filtering mode, with the
+ *  texture shrunk further for every row of results.  The
+ *  shader does nothing but sample the texture, so the GPU
+ *  time follows the texture bandwidth - without mipmaps the
+ *  texels fetched for neighboring pixels spread further
+ *  apart as the texture shrinks and miss the texture cache,
+ *  while the mipmapped modes keep reading a level about the
+ *  size of the screen.  The draws are timed from the CPU
+ *  with the pipeline drained on both sides rather than with
+ *  a timer query, since software renderers such as llvmpipe
+ *  only count the command submission in the query and
+ *  rasterize later.  The texture array is left bound to
+ *  texture unit 0 with no sampler.
+ ***********************************************************/
+void TextureSamplers::RunBenchmark(GLuint textureArray, int textureWidth, int textureHeight)
+{
+	const char* vertexFiles[] = { "shaders/textureBenchmarkVertexShader.glsl" };
+	const char* fragmentFiles[] = { "shaders/textureBenchmarkFragmentShader.glsl" };
+	GLuint shaders[2];
+	shaders[0] = CompileShaderFiles(GL_VERTEX_SHADER, vertexFiles, 1);
+	shaders[1] = CompileShaderFiles(GL_FRAGMENT_SHADER, fragmentFiles, 1);
+	GLuint program = LinkShaderProgram(shaders, 2);
+	if ((program == 0) || (textureArray == 0))
+	{
+		std::cout << "ERROR: the texture benchmark could not be set up" << std::endl;
+		if (program != 0)
+		{
+			glDeleteProgram(program);
+		}
+		return;
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	GLuint vao = 0;
+	glGenVertexArrays(1, &vao);
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "textureArray"), 0);
+	GLint uvScaleLocation = glGetUniformLocation(program, "uvScale");
+	glBindTextureUnit(0, textureArray);
+	glBindVertexArray(vao);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	std::cout << "INFO: texture benchmark, " << textureWidth << "x" << textureHeight << " texture on a "
+		<< viewport[2] << "x" << viewport[3] << " viewport, " << BENCHMARK_ASPECT << ":1 footprint, "
+		<< m_anisotropy << "x anisotropy, ms for " << BENCHMARK_DRAWS << " draws" << std::endl;
+
+	for (float minification : BENCHMARK_MINIFICATIONS)
+	{
+		// texture coordinates across the viewport for the number
+		// of texels per pixel
+		float uvScaleX = minification * viewport[2] / textureWidth;
+		float uvScaleY = minification * BENCHMARK_ASPECT * viewport[3] / textureHeight;
+		glUniform2f(uvScaleLocation, uvScaleX, uvScaleY);
+
+		double milliseconds[SAMPLER_MODE_COUNT];
+		for (int mode = 0; mode < SAMPLER_MODE_COUNT; mode++)
+		{
+			glBindSampler(0, m_samplers[mode]);
+
+			// one untimed draw so the first mode does not pay
+			// for warming up the texture cache
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glFinish();
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int draw = 0; draw < BENCHMARK_DRAWS; draw++)
+			{
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+			glFinish();
+			milliseconds[mode] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// the mipmap level is picked by the longer side of the
+		// footprint, or by the longer side divided by the samples
+		// anisotropic filtering takes along it
+		float majorTexels = minification * BENCHMARK_ASPECT;
+		float anisotropicSamples = (m_anisotropy < BENCHMARK_ASPECT) ? m_anisotropy : BENCHMARK_ASPECT;
+		std::cout << "INFO:   " << minification << "x" << majorTexels << " texels per pixel (mipmap level "
+			<< std::log2(majorTexels) << " trilinear, " << std::log2(majorTexels / anisotropicSamples) << " anisotropic)";
+		for (int mode = 0; mode < SAMPLER_MODE_COUNT; mode++)
+		{
+			std::cout << ", " << SAMPLER_MODE_NAMES[mode] << " " << milliseconds[mode] << " ms";
+		}
+		if (milliseconds[SAMPLER_BILINEAR] > 0.0)
+		{
+			std::cout << ", trilinear saves "
+				<< (100.0 * (1.0 - milliseconds[SAMPLER_TRILINEAR] / milliseconds[SAMPLER_BILINEAR])) << "%";
+		}
+		std::cout << std::endl;
+	}
+
+	glBindSampler(0, 0);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(program);
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturesamplers.h
+// ============
+// sampler objects shared by every scene texture, and a benchmark of the
+// texture bandwidth each filtering mode costs at a distance
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TextureSamplers
+ *
+ *  This class holds one sampler object for each filtering
+ *  mode, so the filtering of a texture is chosen by the
+ *  sampler bound with it instead of being set on every
+ *  texture with glTexParameteri.  The scene textures all
+ *  share the anisotropic sampler, which reads the mipmap
+ *  levels with trilinear filtering and, when the hardware
+ *  supports it, takes more samples along surfaces seen at
+ *  a glancing angle.
+ ***********************************************************/
+class TextureSamplers
+{
+public:
+	// constructor
+	TextureSamplers();
+	// destructor
+	~TextureSamplers();
+
+	enum SAMPLER_MODE
+	{
+		// the full size image only, the mipmaps are never read
+		SAMPLER_BILINEAR = 0,
+		// blended between the two nearest mipmap levels
+		SAMPLER_TRILINEAR,
+		// trilinear with the configured anisotropy
+		SAMPLER_ANISOTROPIC,
+		SAMPLER_MODE_COUNT
+	};
+
+	// create the sampler objects, with the anisotropy clamped
+	// to what the hardware supports
+	void Initialize(float anisotropy);
+	// free the sampler objects
+	void Destroy();
+
+	// change the anisotropy of the anisotropic sampler, which
+	// is created again since a bindless handle freezes the
+	// state of the sampler it was made with
+	void SetAnisotropy(float anisotropy);
+	float GetAnisotropy() const { return(m_anisotropy); }
+
+	GLuint GetSampler(SAMPLER_MODE mode) const { return(m_samplers[mode]); }
+
+	// highest anisotropy the hardware supports, 1 for none
+	static float GetMaxAnisotropy();
+
+	// time drawing a texture array layer at increasing
+	// distances with each filtering mode and print the results
+	void RunBenchmark(GLuint textureArray, int textureWidth, int textureHeight);
+
+private:
+	GLuint m_samplers[SAMPLER_MODE_COUNT];
+	float m_anisotropy;
+
+	// create the sampler object for one filtering mode
+	GLuint CreateSampler(SAMPLER_MODE mode) const;
+};
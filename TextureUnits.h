@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureunits.h
+// ============
+// texture units shared by every shader program drawn in a frame
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  Texture units
+ *
+ *  Textures are bound straight to their units, so the units
+ *  of every pass are listed here to keep any two passes from
+ *  binding over each other.  The scene texture arrays take
+ *  the first units, one each when there are no bindless
+ *  handles, matching TOTAL_TEXTURE_ARRAYS in the scene
+ *  fragment shaders.  The shaders are told the other units
+ *  when their programs are loaded.
+ ***********************************************************/
+const GLuint SCENE_TEXTURE_ARRAY_UNITS = 16;
+// depth pyramid read by the culling compute shaders, and the
+// depth copy its first level is reduced from
+const GLuint DEPTH_PYRAMID_TEXTURE_UNIT = 16;
+// weighted blended transparency targets read by the composite
+const GLuint ACCUMULATION_TEXTURE_UNIT = 17;
+const GLuint REVEALAGE_TEXTURE_UNIT = 18;
+// baked impostor views
+const GLuint COLOR_ATLAS_TEXTURE_UNIT = 19;
+const GLuint NORMAL_ATLAS_TEXTURE_UNIT = 20;
@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// resolve shader uniform locations once, set uniform values by handle,
+// and filter out redundant uniform and texture binding calls
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_activeTextureUnit = -1;
+	m_issuedCalls = 0;
+	m_skippedCalls = 0;
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_locations.clear();
+	m_values.clear();
+	m_boundTextures.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for resolving the locations of every
+ *  active uniform in the currently used shader program.  It
+ *  must be called after the shaders have been linked and the
+ *  program has been made current.
+ ***********************************************************/
+bool UniformCache::Initialize()
+{
+	GLint programID = 0;
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+
+	m_locations.clear();
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if (programID == 0)
+	{
+		std::cout << "ERROR: no shader program is in use for resolving uniforms" << std::endl;
+		return(false);
+	}
+
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> name(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+
+		glGetActiveUniform(programID, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+		GLint location = glGetUniformLocation(programID, name.data());
+
+		// uniforms in uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		AddLocation(HashUniformName(name.data()), location);
+
+		// arrays of basic types are reported as "name[0]", so
+		// also register the plain array name and every element
+		if ((length > 3) && (strcmp(&name[length - 3], "[0]") == 0))
+		{
+			name[length - 3] = '\0';
+			AddLocation(HashUniformName(name.data()), location);
+
+			for (GLint element = 1; element < size; element++)
+			{
+				std::string elementName = std::string(name.data()) + "[" + std::to_string(element) + "]";
+				AddLocation(
+					HashUniformName(elementName.c_str()),
+					glGetUniformLocation(programID, elementName.c_str()));
+			}
+		}
+	}
+
+	std::sort(m_locations.begin(), m_locations.end(),
+		[](const UNIFORM_LOCATION& a, const UNIFORM_LOCATION& b) { return(a.hash < b.hash); });
+
+	// two names with the same hash would silently share a location
+	for (size_t i = 1; i < m_locations.size(); i++)
+	{
+		if (m_locations[i].hash == m_locations[i - 1].hash)
+		{
+			std::cout << "ERROR: shader uniform name hash collision for location " << m_locations[i].location << std::endl;
+		}
+	}
+
+	// size the remembered values to cover the highest location
+	GLint maxLocation = -1;
+	for (const UNIFORM_LOCATION& entry : m_locations)
+	{
+		maxLocation = std::max(maxLocation, entry.location);
+	}
+	m_values.resize(maxLocation + 1);
+	Invalidate();
+
+	std::cout << "INFO: Resolved " << m_locations.size() << " shader uniform locations" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddLocation()
+ *
+ *  This method is used for adding a resolved uniform location
+ *  to the lookup table.
+ ***********************************************************/
+void UniformCache::AddLocation(uint32_t hash, GLint location)
+{
+	UNIFORM_LOCATION entry;
+	entry.hash = hash;
+	entry.location = location;
+	m_locations.push_back(entry);
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for getting the resolved location of
+ *  a uniform from its hashed name.  Debug builds report each
+ *  unknown name once instead of silently returning -1.
+ ***********************************************************/
+GLint UniformCache::GetLocation(const UNIFORM_NAME& uniformName)
+{
+	auto entry = std::lower_bound(m_locations.begin(), m_locations.end(), uniformName.hash,
+		[](const UNIFORM_LOCATION& a, uint32_t hash) { return(a.hash < hash); });
+
+	if ((entry != m_locations.end()) && (entry->hash == uniformName.hash))
+	{
+		return(entry->location);
+	}
+
+#ifdef _DEBUG
+	if (std::find(m_reportedNames.begin(), m_reportedNames.end(), uniformName.hash) == m_reportedNames.end())
+	{
+		m_reportedNames.push_back(uniformName.hash);
+		std::cout << "WARNING: unknown shader uniform: " << uniformName.name << std::endl;
+	}
+#endif
+
+	return(-1);
+}
+
+/***********************************************************
+ *  IsRedundant()
+ *
+ *  This method is used for checking whether a uniform value
+ *  is the same as the last value sent to the location.  When
+ *  it is not, the new value is remembered and counted as an
+ *  issued call.
+ ***********************************************************/
+bool UniformCache::IsRedundant(GLint location, const void* value, size_t size)
+{
+	// a location of -1 is ignored by OpenGL, so there is
+	// nothing to send or remember
+	if (location < 0)
+	{
+		return(true);
+	}
+
+	if (location >= (GLint)m_values.size())
+	{
+		m_issuedCalls++;
+		return(false);
+	}
+
+	UNIFORM_VALUE& lastValue = m_values[location];
+	if ((lastValue.bValid == true) && (memcmp(lastValue.data, value, size) == 0))
+	{
+		m_skippedCalls++;
+		return(true);
+	}
+
+	memcpy(lastValue.data, value, size);
+	lastValue.bValid = true;
+	m_issuedCalls++;
+
+	return(false);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to a texture
+ *  unit, skipping the unit switch and the bind when they
+ *  would not change anything.
+ ***********************************************************/
+void UniformCache::BindTexture(int textureUnit, GLuint textureID, GLenum target)
+{
+	if (textureUnit >= (int)m_boundTextures.size())
+	{
+		m_boundTextures.resize(textureUnit + 1, 0);
+	}
+
+	if (m_boundTextures[textureUnit] == textureID)
+	{
+		m_skippedCalls++;
+		return;
+	}
+
+	if (m_activeTextureUnit != textureUnit)
+	{
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		m_activeTextureUnit = textureUnit;
+		m_issuedCalls++;
+	}
+
+	glBindTexture(target, textureID);
+	m_boundTextures[textureUnit] = textureID;
+	m_issuedCalls++;
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting every remembered
+ *  uniform value and texture binding, so the next call for
+ *  each one is always passed through to OpenGL.
+ ***********************************************************/
+void UniformCache::Invalidate()
+{
+	for (UNIFORM_VALUE& value : m_values)
+	{
+		value.bValid = false;
+	}
+	m_boundTextures.clear();
+	m_activeTextureUnit = -1;
+}
+
+/***********************************************************
+ *  ResetFrameCounters()
+ *
+ *  This method is used for resetting the issued and skipped
+ *  call counters at the start of a new frame.
+ ***********************************************************/
+void UniformCache::ResetFrameCounters()
+{
+	m_issuedCalls = 0;
+	m_skippedCalls = 0;
+}
+
+/***********************************************************
+ *  Uniform setters by hashed name
+ *
+ *  These methods resolve the hashed name from the table and
+ *  then set the value at the resolved location.
+ ***********************************************************/
+void UniformCache::setBoolValue(const UNIFORM_NAME& uniformName, bool value)
+{
+	setIntValue(GetLocation(uniformName), (int)value);
+}
+
+void UniformCache::setIntValue(const UNIFORM_NAME& uniformName, int value)
+{
+	setIntValue(GetLocation(uniformName), value);
+}
+
+void UniformCache::setFloatValue(const UNIFORM_NAME& uniformName, float value)
+{
+	setFloatValue(GetLocation(uniformName), value);
+}
+
+void UniformCache::setVec2Value(const UNIFORM_NAME& uniformName, const glm::vec2& value)
+{
+	setVec2Value(GetLocation(uniformName), value);
+}
+
+void UniformCache::setVec3Value(const UNIFORM_NAME& uniformName, const glm::vec3& value)
+{
+	setVec3Value(GetLocation(uniformName), value);
+}
+
+void UniformCache::setVec3Value(const UNIFORM_NAME& uniformName, float x, float y, float z)
+{
+	setVec3Value(GetLocation(uniformName), glm::vec3(x, y, z));
+}
+
+void UniformCache::setVec4Value(const UNIFORM_NAME& uniformName, const glm::vec4& value)
+{
+	setVec4Value(GetLocation(uniformName), value);
+}
+
+void UniformCache::setMat4Value(const UNIFORM_NAME& uniformName, const glm::mat4& value)
+{
+	setMat4Value(GetLocation(uniformName), value);
+}
+
+void UniformCache::setSampler2DValue(const UNIFORM_NAME& uniformName, int value)
+{
+	setIntValue(GetLocation(uniformName), value);
+}
+
+/***********************************************************
+ *  Uniform setters by resolved location
+ *
+ *  These methods set the value at an already resolved
+ *  location in the currently used shader program, unless
+ *  the location already holds that value.
+ ***********************************************************/
+void UniformCache::setIntValue(GLint location, int value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniform1i(location, value);
+	}
+}
+
+void UniformCache::setFloatValue(GLint location, float value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniform1f(location, value);
+	}
+}
+
+void UniformCache::setVec2Value(GLint location, const glm::vec2& value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniform2fv(location, 1, glm::value_ptr(value));
+	}
+}
+
+void UniformCache::setVec3Value(GLint location, const glm::vec3& value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniform3fv(location, 1, glm::value_ptr(value));
+	}
+}
+
+void UniformCache::setVec4Value(GLint location, const glm::vec4& value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniform4fv(location, 1, glm::value_ptr(value));
+	}
+}
+
+void UniformCache::setMat4Value(GLint location, const glm::mat4& value)
+{
+	if (IsRedundant(location, &value, sizeof(value)) == false)
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// resolve shader uniform locations once, set uniform values by handle,
+// and filter out redundant uniform and texture binding calls
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  HashUniformName()
+ *
+ *  FNV-1a hash of a uniform name.  This is constexpr so that
+ *  the hash of a string literal is calculated at compile time.
+ ***********************************************************/
+constexpr uint32_t HashUniformName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	while (*name != '\0')
+	{
+		hash = (hash ^ (uint8_t)(*name)) * 16777619u;
+		name++;
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  UNIFORM_NAME
+ *
+ *  A shader uniform name paired with its hash.  Declare these
+ *  as constexpr so no string is hashed or compared at runtime,
+ *  the name is only kept for reporting unknown uniforms.
+ ***********************************************************/
+struct UNIFORM_NAME
+{
+	uint32_t hash;
+	const char* name;
+
+	constexpr UNIFORM_NAME(const char* uniformName)
+		: hash(HashUniformName(uniformName)), name(uniformName)
+	{
+	}
+};
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class resolves the locations of all the active
+ *  uniforms in the linked shader program once, and then
+ *  sets uniform values by hashed name or resolved location
+ *  without calling glGetUniformLocation for every value.
+ *
+ *  The last value sent to every uniform and the texture
+ *  bound to every texture unit are remembered, so a call
+ *  that would not change any state is skipped.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+	// destructor
+	~UniformCache();
+
+	// resolve the locations of the active uniforms in the
+	// currently used shader program
+	bool Initialize();
+
+	// get the resolved location for a uniform, -1 when the
+	// shader program has no active uniform with that name
+	GLint GetLocation(const UNIFORM_NAME& uniformName);
+
+	// set uniform values by hashed name
+	void setBoolValue(const UNIFORM_NAME& uniformName, bool value);
+	void setIntValue(const UNIFORM_NAME& uniformName, int value);
+	void setFloatValue(const UNIFORM_NAME& uniformName, float value);
+	void setVec2Value(const UNIFORM_NAME& uniformName, const glm::vec2& value);
+	void setVec3Value(const UNIFORM_NAME& uniformName, const glm::vec3& value);
+	void setVec3Value(const UNIFORM_NAME& uniformName, float x, float y, float z);
+	void setVec4Value(const UNIFORM_NAME& uniformName, const glm::vec4& value);
+	void setMat4Value(const UNIFORM_NAME& uniformName, const glm::mat4& value);
+	void setSampler2DValue(const UNIFORM_NAME& uniformName, int value);
+
+	// set uniform values by pre-resolved location
+	void setIntValue(GLint location, int value);
+	void setFloatValue(GLint location, float value);
+	void setVec2Value(GLint location, const glm::vec2& value);
+	void setVec3Value(GLint location, const glm::vec3& value);
+	void setVec4Value(GLint location, const glm::vec4& value);
+	void setMat4Value(GLint location, const glm::mat4& value);
+
+	// bind a texture to a texture unit
+	void BindTexture(int textureUnit, GLuint textureID, GLenum target = GL_TEXTURE_2D);
+
+	// forget all remembered state, for when the uniforms or
+	// bindings have been changed outside of this class
+	void Invalidate();
+
+	// reset the issued and skipped call counters for a new frame
+	void ResetFrameCounters();
+	// calls passed through to OpenGL since the counters were reset
+	int GetIssuedCalls() const { return(m_issuedCalls); }
+	// redundant calls skipped since the counters were reset
+	int GetSkippedCalls() const { return(m_skippedCalls); }
+
+private:
+	struct UNIFORM_LOCATION
+	{
+		uint32_t hash;
+		GLint location;
+	};
+
+	// last value sent to a uniform location
+	struct UNIFORM_VALUE
+	{
+		bool bValid;
+		unsigned char data[sizeof(glm::mat4)];
+	};
+
+	// resolved uniform locations sorted by name hash
+	std::vector<UNIFORM_LOCATION> m_locations;
+	// last values indexed by uniform location
+	std::vector<UNIFORM_VALUE> m_values;
+	// texture bound to each texture unit, 0 when unknown
+	std::vector<GLuint> m_boundTextures;
+	// currently active texture unit, -1 when unknown
+	int m_activeTextureUnit;
+	// counters for the current frame
+	int m_issuedCalls;
+	int m_skippedCalls;
+#ifdef _DEBUG
+	// unknown uniform names that have already been reported
+	std::vector<uint32_t> m_reportedNames;
+#endif
+
+	// add a resolved location to the sorted table
+	void AddLocation(uint32_t hash, GLint location);
+	// check a new uniform value against the last one sent,
+	// remembering it when it differs
+	bool IsRedundant(GLint location, const void* value, size_t size);
+};
@@ -20,8 +20,6 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -51,7 +49,10 @@ ViewManager::ViewManager(
 {
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
+	m_pSceneUniforms = NULL;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -69,6 +70,7 @@ ViewManager::~ViewManager()
 {
 	// free up allocated memory
 	m_pShaderManager = NULL;
+	m_pSceneUniforms = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
 	{
@@ -106,15 +108,25 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// blending is left off here, the scene manager turns it
+	// on only for the translucent draws
 
 	m_pWindow = window;
 
 	return(window);
 }
 
+/***********************************************************
+ *  SetSceneUniforms()
+ *
+ *  This method is used to pass in the uniform buffer that
+ *  shares the view values with every scene shader program.
+ ***********************************************************/
+void ViewManager::SetSceneUniforms(SceneUniformBuffer* pSceneUniforms)
+{
+	m_pSceneUniforms = pSceneUniforms;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -276,14 +288,15 @@ void ViewManager::PrepareSceneView()
 		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
 	}
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// keep the matrices for the scene to order and cull against
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
+	// if the scene uniform buffer is valid
+	if (NULL != m_pSceneUniforms)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		// set the view and projection matrices and the view position
+		// of the camera for every scene shader program
+		m_pSceneUniforms->SetView(view, projection, g_pCamera->Position);
 	}
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "SceneUniformBuffer.h"
 #include "camera.h"
 
 // GLFW library
@@ -30,8 +31,13 @@ public:
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the view values shared by the scene shaders
+	SceneUniformBuffer* m_pSceneUniforms;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// view and projection matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -39,7 +45,13 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// set the buffer the view values are shared through
+	void SetSceneUniforms(SceneUniformBuffer* pSceneUniforms);
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// get the view and projection matrices of the current frame
+	const glm::mat4& GetViewMatrix() const { return(m_viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projectionMatrix); }
 };
\ No newline at end of file
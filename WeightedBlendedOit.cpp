@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////
+// weightedblendedoit.cpp
+// ============
+// order-independent transparency by weighted blending into two render
+// targets and one composite over the opaque scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WeightedBlendedOit.h"
+#include "TextureUnits.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_AccumulationName = "accumulationTexture";
+	const char* g_RevealageName = "revealageTexture";
+	const char* g_ViewportOriginName = "viewportOrigin";
+}
+
+/***********************************************************
+ *  WeightedBlendedOit()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WeightedBlendedOit::WeightedBlendedOit()
+{
+	m_pCompositeShader = NULL;
+	m_viewportOriginLocation = -1;
+	m_vao = 0;
+	m_framebuffer = 0;
+	m_accumulationTexture = 0;
+	m_revealageTexture = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_viewport[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~WeightedBlendedOit()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+WeightedBlendedOit::~WeightedBlendedOit()
+{
+	if (NULL != m_pCompositeShader)
+	{
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+
+	CreateTargets(0, 0);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the shaders that blend
+ *  the accumulated color over the scene.  The targets are
+ *  created when accumulation first starts, at the size of
+ *  the viewport.
+ ***********************************************************/
+bool WeightedBlendedOit::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (NULL == m_pCompositeShader)
+	{
+		m_pCompositeShader = new ShaderManager();
+		GLuint programID = m_pCompositeShader->LoadShaders(vertexShaderFile, fragmentShaderFile);
+		if (programID == 0)
+		{
+			delete m_pCompositeShader;
+			m_pCompositeShader = NULL;
+			return(false);
+		}
+
+		m_pCompositeShader->use();
+		m_pCompositeShader->setIntValue(g_AccumulationName, ACCUMULATION_TEXTURE_UNIT);
+		m_pCompositeShader->setIntValue(g_RevealageName, REVEALAGE_TEXTURE_UNIT);
+		// the viewport origin is set on every composite, so its
+		// location is resolved once instead of by name each time
+		m_viewportOriginLocation = glGetUniformLocation(programID, g_ViewportOriginName);
+
+		glGenVertexArrays(1, &m_vao);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginAccumulation()
+ *
+ *  This method is used for starting the translucent draws.
+ *  The opaque depth is copied out of the default framebuffer
+ *  first, so the translucent fragments behind opaque ones are
+ *  still rejected.  The accumulated color starts at zero and
+ *  the revealage at one, fully revealing the opaque scene.
+ ***********************************************************/
+void WeightedBlendedOit::BeginAccumulation()
+{
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	if ((m_viewport[2] <= 0) || (m_viewport[3] <= 0))
+	{
+		return;
+	}
+	if ((m_viewport[2] != m_width) || (m_viewport[3] != m_height))
+	{
+		CreateTargets(m_viewport[2], m_viewport[3]);
+	}
+
+	glCopyTextureSubImage2D(m_depthTexture, 0, 0, 0, m_viewport[0], m_viewport[1], m_width, m_height);
+
+	const GLfloat clearAccumulation[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearRevealage[] = { 1.0f, 0.0f, 0.0f, 0.0f };
+	glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, 0, clearAccumulation);
+	glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, 1, clearRevealage);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	// the accumulation adds up, the revealage multiplies down
+	// by the transparency of every fragment
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunci(0, GL_ONE, GL_ONE);
+	glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+/***********************************************************
+ *  EndAccumulation()
+ *
+ *  This method is used for going back to the default
+ *  framebuffer and the viewport it was drawn with.
+ ***********************************************************/
+void WeightedBlendedOit::EndAccumulation()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+}
+
+/***********************************************************
+ *  Composite()
+ *
+ *  This method is used for drawing one fullscreen triangle
+ *  that blends the average translucent color over the opaque
+ *  scene, keeping as much of the scene as the revealage says
+ *  shows through.
+ ***********************************************************/
+void WeightedBlendedOit::Composite()
+{
+	if ((NULL == m_pCompositeShader) || (m_framebuffer == 0))
+	{
+		return;
+	}
+
+	m_pCompositeShader->use();
+	glUniform2f(m_viewportOriginLocation, (float)m_viewport[0], (float)m_viewport[1]);
+	glBindTextureUnit(ACCUMULATION_TEXTURE_UNIT, m_accumulationTexture);
+	glBindTextureUnit(REVEALAGE_TEXTURE_UNIT, m_revealageTexture);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the framebuffer and its
+ *  targets for a viewport size.  The accumulated color needs
+ *  the range of half floats, since the weights run far past
+ *  one.
+ ***********************************************************/
+void WeightedBlendedOit::CreateTargets(int width, int height)
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(1, &m_accumulationTexture);
+		glDeleteTextures(1, &m_revealageTexture);
+		glDeleteTextures(1, &m_depthTexture);
+		m_framebuffer = 0;
+		m_accumulationTexture = 0;
+		m_revealageTexture = 0;
+		m_depthTexture = 0;
+	}
+
+	m_width = width;
+	m_height = height;
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_accumulationTexture);
+	glTextureStorage2D(m_accumulationTexture, 1, GL_RGBA16F, width, height);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_revealageTexture);
+	glTextureStorage2D(m_revealageTexture, 1, GL_R16F, width, height);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT24, width, height);
+
+	const GLuint textures[] = { m_accumulationTexture, m_revealageTexture };
+	for (GLuint texture : textures)
+	{
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glCreateFramebuffers(1, &m_framebuffer);
+	glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_accumulationTexture, 0);
+	glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT1, m_revealageTexture, 0);
+	glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+	glNamedFramebufferDrawBuffers(m_framebuffer, 2, drawBuffers);
+
+	if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: the transparency framebuffer is not complete" << std::endl;
+	}
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// weightedblendedoit.h
+// ============
+// order-independent transparency by weighted blending into two render
+// targets and one composite over the opaque scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  WeightedBlendedOit
+ *
+ *  This class blends the translucent draws without sorting
+ *  them.  Every translucent fragment adds its premultiplied
+ *  color, weighted by its alpha and depth, to an accumulation
+ *  target, and multiplies its transparency into a revealage
+ *  target.  A fullscreen pass then divides the accumulated
+ *  color by the accumulated weight and blends the average
+ *  over the opaque scene by the revealage.  The result does
+ *  not depend on the order the fragments arrive in, so
+ *  intersecting translucent objects blend correctly and no
+ *  back to front sort is needed.
+ *
+ *  The translucent draws are depth tested against a copy of
+ *  the opaque depth buffer, taken when accumulation starts.
+ ***********************************************************/
+class WeightedBlendedOit
+{
+public:
+	// constructor
+	WeightedBlendedOit();
+	// destructor
+	~WeightedBlendedOit();
+
+	// load the composite shaders
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// copy the opaque depth, clear the accumulation targets and
+	// draw into them with the weighted blend functions
+	void BeginAccumulation();
+	// go back to drawing into the default framebuffer
+	void EndAccumulation();
+	// blend the accumulated translucent color over the default
+	// framebuffer, the caller has to make its own shader
+	// program current again afterwards
+	void Composite();
+
+private:
+	// shaders that draw the fullscreen composite
+	ShaderManager* m_pCompositeShader;
+	GLint m_viewportOriginLocation;
+	// the composite triangle is made up in the vertex shader,
+	// but core profiles still need a vertex array to draw
+	GLuint m_vao;
+
+	// framebuffer with the accumulation and revealage targets
+	// and the copy of the opaque depth
+	GLuint m_framebuffer;
+	GLuint m_accumulationTexture;
+	GLuint m_revealageTexture;
+	GLuint m_depthTexture;
+	int m_width;
+	int m_height;
+	// viewport of the default framebuffer being drawn
+	GLint m_viewport[4];
+
+	// create the targets for a viewport size, or release them
+	// when the size is zero
+	void CreateTargets(int width, int height);
+};
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// compactComputeShader.glsl
+// ============
+// pack the indirect draw commands that still draw any instances after
+// culling, in their original order, along with their per-draw values,
+// keeping the opaque and the translucent commands in ranges of their own
+///////////////////////////////////////////////////////////////////////////////
+#version 450 core
+
+// one work group scans all the commands in chunks of its size
+layout (local_size_x = 256) in;
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 6) readonly buffer WorkingCommandBuffer
+{
+	DrawCommand commands[];
+};
+layout (std430, binding = 7) writeonly buffer CommandBuffer
+{
+	DrawCommand outputCommands[];
+};
+// the per-draw values are copied as plain words
+layout (std430, binding = 8) readonly buffer DrawDataBuffer
+{
+	uvec4 drawData[];
+};
+layout (std430, binding = 9) writeonly buffer CompactDrawDataBuffer
+{
+	uvec4 outputDrawData[];
+};
+// draw counts of the opaque and of the translucent range
+layout (std430, binding = 10) writeonly buffer DrawCountBuffer
+{
+	uint drawCounts[2];
+};
+
+uniform uint commandCount;
+// the opaque commands come first, the translucent ones are packed
+// from this index on so the two can be drawn with different state
+uniform uint opaqueCommandCount;
+// false when the driver cannot draw with a draw count, so every
+// command is kept and the culled ones draw no instances
+uniform bool bCompact;
+
+shared uint scan[256];
+
+void main()
+{
+	uint lane = gl_LocalInvocationID.x;
+
+	if (bCompact == false)
+	{
+		for (uint i = lane; i < commandCount; i += 256u)
+		{
+			outputCommands[i] = commands[i];
+		}
+		return;
+	}
+
+	for (uint range = 0u; range < 2u; range++)
+	{
+		uint rangeStart = (range == 0u) ? 0u : opaqueCommandCount;
+		uint rangeEnd = (range == 0u) ? opaqueCommandCount : commandCount;
+
+		uint base = rangeStart;
+		for (uint first = rangeStart; first < rangeEnd; first += 256u)
+		{
+			uint i = first + lane;
+			uint keep = ((i < rangeEnd) && (commands[i].instanceCount > 0u)) ? 1u : 0u;
+
+			// inclusive prefix sum of the kept commands in this chunk
+			scan[lane] = keep;
+			barrier();
+			for (uint offset = 1u; offset < 256u; offset <<= 1u)
+			{
+				uint value = (lane >= offset) ? scan[lane - offset] : 0u;
+				barrier();
+				scan[lane] += value;
+				barrier();
+			}
+
+			if (keep == 1u)
+			{
+				uint slot = base + scan[lane] - 1u;
+				outputCommands[slot] = commands[i];
+				outputDrawData[slot] = drawData[i];
+			}
+
+			base += scan[255];
+			barrier();
+		}
+
+		if (lane == 0u)
+		{
+			drawCounts[range] = base - rangeStart;
+		}
+	}
+}
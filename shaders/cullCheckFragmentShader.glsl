@@ -0,0 +1,16 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullCheckFragmentShader.glsl
+// ============
+// write the index of the box that covers each pixel, so the images of
+// the GPU culling check can be compared exactly
+///////////////////////////////////////////////////////////////////////////////
+#version 450 core
+
+flat in int fragmentIndex;
+
+layout (location = 0) out int fragmentColor;
+
+void main()
+{
+	fragmentColor = fragmentIndex;
+}
@@ -0,0 +1,23 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullCheckVertexShader.glsl
+// ============
+// place the boxes of the GPU culling check, passing on the index each
+// instance keeps in its material index
+///////////////////////////////////////////////////////////////////////////////
+#version 450 core
+
+layout (location = 0) in vec3 inVertexPosition;
+// per-instance model matrix, taking locations 1 to 4
+layout (location = 1) in mat4 inInstanceModel;
+layout (location = 5) in int inInstanceIndex;
+
+flat out int fragmentIndex;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+	fragmentIndex = inInstanceIndex;
+
+	gl_Position = viewProjection * inInstanceModel * vec4(inVertexPosition, 1.0f);
+}
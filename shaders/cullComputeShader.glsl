@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullComputeShader.glsl
+// ============
+// test every object against the view frustum and the depth pyramid of the
+// previous frame, append the instance values of the objects that pass
+// to the instances of their indirect draw command, and count them
+///////////////////////////////////////////////////////////////////////////////
+#version 450 core
+
+layout (local_size_x = 64) in;
+
+struct CullObject
+{
+	vec3 aabbMin;
+	uint commandIndex;
+	vec3 aabbMax;
+	uint padding;
+};
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 3) readonly buffer CullObjectBuffer
+{
+	CullObject objects[];
+};
+// the instance values are copied as plain words, so the layout of the
+// vertex attributes does not have to match a std430 struct
+layout (std430, binding = 4) readonly buffer SourceInstanceBuffer
+{
+	uint sourceWords[];
+};
+layout (std430, binding = 5) writeonly buffer InstanceBuffer
+{
+	uint instanceWords[];
+};
+layout (std430, binding = 6) buffer WorkingCommandBuffer
+{
+	DrawCommand commands[];
+};
+// objects drawn and objects hidden by the depth pyramid this frame,
+// read back by the CPU once the frame has finished
+layout (std430, binding = 11) buffer CullCountBuffer
+{
+	uint visibleCount;
+	uint occludedCount;
+};
+
+// farthest depth of each texel, one mip level per halving, on
+// the texture unit set by GpuCulling from TextureUnits.h
+uniform sampler2D depthPyramid;
+
+uniform uint objectCount;
+uniform uint wordsPerInstance;
+// frustum planes with normals pointing into the frustum
+uniform vec4 frustumPlanes[6];
+// view-projection matrix the depth pyramid was drawn with
+uniform mat4 previousViewProjection;
+uniform bool bDepthPyramidValid;
+uniform int depthPyramidLevels;
+
+// counts of the work group, added to the buffer once per group
+shared uint groupVisible;
+shared uint groupOccluded;
+
+/***********************************************************
+ *  IsInsideFrustum()
+ *
+ *  A box is outside when its corner farthest along a plane
+ *  normal is still behind that plane.
+ ***********************************************************/
+bool IsInsideFrustum(vec3 aabbMin, vec3 aabbMax)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		vec3 farCorner = mix(aabbMin, aabbMax, greaterThanEqual(frustumPlanes[i].xyz, vec3(0.0f)));
+		if (dot(frustumPlanes[i].xyz, farCorner) + frustumPlanes[i].w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  The screen rectangle of the box picks the pyramid level
+ *  where it covers at most a few texels.  The box is hidden
+ *  when its nearest depth is behind the farthest depth of
+ *  all of them.
+ ***********************************************************/
+bool IsOccluded(vec3 aabbMin, vec3 aabbMax)
+{
+	if (bDepthPyramidValid == false)
+	{
+		return false;
+	}
+
+	vec2 ndcMin = vec2(1.0f);
+	vec2 ndcMax = vec2(-1.0f);
+	float nearestDepth = 1.0f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		vec3 position = vec3(
+			((corner & 1) != 0) ? aabbMax.x : aabbMin.x,
+			((corner & 2) != 0) ? aabbMax.y : aabbMin.y,
+			((corner & 4) != 0) ? aabbMax.z : aabbMin.z);
+		vec4 clipPosition = previousViewProjection * vec4(position, 1.0f);
+
+		// a box crossing the camera plane cannot be projected
+		if (clipPosition.w <= 0.0f)
+		{
+			return false;
+		}
+
+		vec3 ndcPosition = clipPosition.xyz / clipPosition.w;
+		ndcMin = min(ndcMin, ndcPosition.xy);
+		ndcMax = max(ndcMax, ndcPosition.xy);
+		nearestDepth = min(nearestDepth, ndcPosition.z * 0.5f + 0.5f);
+	}
+
+	vec2 uvMin = clamp(ndcMin * 0.5f + 0.5f, 0.0f, 1.0f);
+	vec2 uvMax = clamp(ndcMax * 0.5f + 0.5f, 0.0f, 1.0f);
+	vec2 pixelSize = (uvMax - uvMin) * vec2(textureSize(depthPyramid, 0));
+	int level = int(ceil(log2(max(max(pixelSize.x, pixelSize.y), 1.0f))));
+	level = clamp(level, 0, depthPyramidLevels - 1);
+
+	// the size of the level is worked out from the first one, as
+	// textureSize() with a level that differs between invocations
+	// returns the size of the wrong level on llvmpipe
+	ivec2 levelSize = max(textureSize(depthPyramid, 0) >> level, ivec2(1));
+	ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+	ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+	float farthestDepth = 0.0f;
+	for (int y = texelMin.y; y <= texelMax.y; y++)
+	{
+		for (int x = texelMin.x; x <= texelMax.x; x++)
+		{
+			farthestDepth = max(farthestDepth, texelFetch(depthPyramid, ivec2(x, y), level).r);
+		}
+	}
+
+	return nearestDepth > farthestDepth;
+}
+
+/***********************************************************
+ *  AppendInstance()
+ *
+ *  Take the next free instance of the object's command and
+ *  copy the object's instance values into it.
+ ***********************************************************/
+void AppendInstance(uint objectIndex, uint commandIndex)
+{
+	uint slot = atomicAdd(commands[commandIndex].instanceCount, 1u);
+	uint target = (commands[commandIndex].baseInstance + slot) * wordsPerInstance;
+	uint source = objectIndex * wordsPerInstance;
+	for (uint word = 0u; word < wordsPerInstance; word++)
+	{
+		instanceWords[target + word] = sourceWords[source + word];
+	}
+}
+
+void main()
+{
+	if (gl_LocalInvocationIndex == 0u)
+	{
+		groupVisible = 0u;
+		groupOccluded = 0u;
+	}
+	memoryBarrierShared();
+	barrier();
+
+	// every invocation has to reach the barrier below, so the
+	// ones past the last object only skip the test
+	uint objectIndex = gl_GlobalInvocationID.x;
+	if (objectIndex < objectCount)
+	{
+		CullObject object = objects[objectIndex];
+		if (IsInsideFrustum(object.aabbMin, object.aabbMax) == true)
+		{
+			if (IsOccluded(object.aabbMin, object.aabbMax) == true)
+			{
+				atomicAdd(groupOccluded, 1u);
+			}
+			else
+			{
+				atomicAdd(groupVisible, 1u);
+				AppendInstance(objectIndex, object.commandIndex);
+			}
+		}
+	}
+
+	memoryBarrierShared();
+	barrier();
+	if (gl_LocalInvocationIndex == 0u)
+	{
+		atomicAdd(visibleCount, groupVisible);
+		atomicAdd(occludedCount, groupOccluded);
+	}
+}
@@ -0,0 +1,10 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthFragmentShader.glsl
+// ============
+// write nothing but depth for the depth pre-pass
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+void main()
+{
+}
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthPyramidComputeShader.glsl
+// ============
+// build one level of the depth pyramid, where every texel holds the
+// farthest depth of the texels it covers in the level above
+///////////////////////////////////////////////////////////////////////////////
+#version 450 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// copy of the depth buffer, read for the first level, on the
+// texture unit set by GpuCulling from TextureUnits.h
+uniform sampler2D depthTexture;
+layout (r32f, binding = 0) readonly uniform image2D sourceLevel;
+layout (r32f, binding = 1) writeonly uniform image2D targetLevel;
+
+uniform bool bFromDepth;
+uniform ivec2 targetSize;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(texel, targetSize)))
+	{
+		return;
+	}
+
+	float farthestDepth = 0.0f;
+	if (bFromDepth == true)
+	{
+		farthestDepth = texelFetch(depthTexture, texel, 0).r;
+	}
+	else
+	{
+		// an odd source size leaves one more row or column for
+		// the last texel of the target to cover
+		ivec2 sourceSize = imageSize(sourceLevel);
+		ivec2 first = texel * 2;
+		ivec2 last = first + 1 + ivec2(equal(texel, targetSize - 1)) * (sourceSize & 1);
+		last = min(last, sourceSize - 1);
+
+		for (int y = first.y; y <= last.y; y++)
+		{
+			for (int x = first.x; x <= last.x; x++)
+			{
+				farthestDepth = max(farthestDepth, imageLoad(sourceLevel, ivec2(x, y)).r);
+			}
+		}
+	}
+
+	imageStore(targetLevel, texel, vec4(farthestDepth));
+}
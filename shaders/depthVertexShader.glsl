@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthVertexShader.glsl
+// ============
+// transform the packed positions of the opaque scene meshes for the depth
+// pre-pass, exactly as the scene vertex shader does
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+layout (location = 0) in vec3 inVertexPosition;
+// per-instance model matrix, taking locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// the lit pass tests for an equal depth, so both passes have to
+// come to the very same position
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = inInstanceModel * vec4(inVertexPosition, 1.0f);
+
+	gl_Position = projection * view * worldPosition;
+}
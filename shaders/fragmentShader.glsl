@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////
+// fragmentShader.glsl
+// ============
+// shade the scene meshes with the texture of their indirect draw command,
+// the material of their instance and up to four Phong light sources
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+// the texture arrays are read through bindless handles when the
+// driver supports them, otherwise through one texture unit each
+#ifdef GL_ARB_bindless_texture
+#extension GL_ARB_bindless_texture : require
+#endif
+
+#define TOTAL_LIGHTS 4
+#define TOTAL_TEXTURE_ARRAYS 16
+
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+// material values as packed in the material buffer
+struct MaterialData
+{
+	vec4 ambientColorStrength;
+	vec4 diffuseColor;
+	vec4 specularColorShininess;
+};
+
+// per-draw values, indexed by the draw command
+struct DrawData
+{
+	vec2 uvScale;
+	int textureArray;
+	int textureLayer;
+};
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+in vec4 fragmentColor;
+flat in int fragmentDrawID;
+flat in int fragmentMaterialIndex;
+
+layout (location = 0) out vec4 outFragmentColor;
+// transparency of the fragment, only written to a target while the
+// translucent draws are accumulated for weighted blending
+layout (location = 1) out float outRevealage;
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+	DrawData drawData[];
+};
+
+layout(std430, binding = 2) readonly buffer MaterialBuffer
+{
+	MaterialData materials[];
+};
+
+#ifdef GL_ARB_bindless_texture
+layout(std430, binding = 1) readonly buffer TextureHandleBuffer
+{
+	uvec2 textureHandles[];
+};
+#else
+uniform sampler2DArray textureArrays[TOTAL_TEXTURE_ARRAYS];
+#endif
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// true while the translucent draws are accumulated for weighted
+// blended order-independent transparency
+uniform bool bWeightedBlended = false;
+
+// sample a layer of one of the texture arrays
+vec4 SampleTexture(int textureArray, vec3 textureCoordinate)
+{
+#ifdef GL_ARB_bindless_texture
+	return(texture(sampler2DArray(textureHandles[textureArray]), textureCoordinate));
+#else
+	return(texture(textureArrays[textureArray], textureCoordinate));
+#endif
+}
+
+// calculate the Phong contribution of one light source
+vec3 CalculateLightSource(LightSource lightSource, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+
+	// ambient lighting
+	ambient = lightSource.ambientColor * material.ambientColor * material.ambientStrength;
+
+	// diffuse lighting
+	vec3 lightDirection = normalize(lightSource.position - vertexPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	diffuse = impact * lightSource.diffuseColor * material.diffuseColor;
+
+	// specular lighting - the light's focal strength and the
+	// material's shininess both tighten the highlight
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), lightSource.focalStrength + material.shininess);
+	specular = lightSource.specularIntensity * specularComponent * lightSource.specularColor * material.specularColor;
+
+	return(ambient + diffuse + specular);
+}
+
+void main()
+{
+	DrawData draw = drawData[fragmentDrawID];
+	vec4 baseColor = fragmentColor;
+
+	// the texture array is the same for the whole draw, so it
+	// can select the sampler
+	if (draw.textureArray >= 0)
+	{
+		baseColor = SampleTexture(draw.textureArray, vec3(fragmentTextureCoordinate * draw.uvScale, draw.textureLayer));
+	}
+
+	// the material opacity is packed in the diffuse alpha
+	if (fragmentMaterialIndex >= 0)
+	{
+		baseColor.a *= materials[fragmentMaterialIndex].diffuseColor.a;
+	}
+
+	if (bUseLighting == true)
+	{
+		vec3 lightNormal = normalize(fragmentVertexNormal);
+		vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+		vec3 phongResult = vec3(0.0f);
+
+		// an instance without a material is lit with zeroed values
+		Material material = Material(vec3(0.0f), 0.0f, vec3(0.0f), vec3(0.0f), 0.0f);
+		if (fragmentMaterialIndex >= 0)
+		{
+			MaterialData materialData = materials[fragmentMaterialIndex];
+			material.ambientColor = materialData.ambientColorStrength.rgb;
+			material.ambientStrength = materialData.ambientColorStrength.a;
+			material.diffuseColor = materialData.diffuseColor.rgb;
+			material.specularColor = materialData.specularColorShininess.rgb;
+			material.shininess = materialData.specularColorShininess.a;
+		}
+
+		for (int i = 0; i < TOTAL_LIGHTS; i++)
+		{
+			phongResult += CalculateLightSource(lightSources[i], material, lightNormal, fragmentPosition, viewDirection);
+		}
+
+		outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+	}
+	else
+	{
+		outFragmentColor = baseColor;
+	}
+
+	// weight the premultiplied color so nearer and more opaque
+	// fragments count for more in the average, the weight curve
+	// is the depth based one of McGuire and Bavoil
+	outRevealage = outFragmentColor.a;
+	if (bWeightedBlended == true)
+	{
+		float alpha = outFragmentColor.a;
+		float weight = clamp(
+			pow(min(1.0f, alpha * 10.0f) + 0.01f, 3.0f) * 1e8 * pow(1.0f - gl_FragCoord.z * 0.9f, 3.0f),
+			1e-2, 3e3);
+		outFragmentColor = vec4(outFragmentColor.rgb * alpha, alpha) * weight;
+	}
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorBakeFragmentShader.glsl
+// ============
+// write the unlit color and the normal of an object into one view of its
+// impostor, the lighting is left to the impostor shaders
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+// the texture arrays are read through bindless handles when the
+// driver supports them, otherwise through one texture unit each
+#ifdef GL_ARB_bindless_texture
+#extension GL_ARB_bindless_texture : require
+#endif
+
+#define TOTAL_TEXTURE_ARRAYS 16
+
+// per-draw values, indexed by the draw command
+struct DrawData
+{
+	vec2 uvScale;
+	int textureArray;
+	int textureLayer;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+in vec4 fragmentColor;
+flat in int fragmentDrawID;
+flat in int fragmentMaterialIndex;
+
+layout (location = 0) out vec4 outColor;
+// normal in the frame the object was baked in, from 0 to 1
+layout (location = 1) out vec4 outNormal;
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+	DrawData drawData[];
+};
+
+#ifdef GL_ARB_bindless_texture
+layout(std430, binding = 1) readonly buffer TextureHandleBuffer
+{
+	uvec2 textureHandles[];
+};
+#else
+uniform sampler2DArray textureArrays[TOTAL_TEXTURE_ARRAYS];
+#endif
+
+// sample a layer of one of the texture arrays
+vec4 SampleTexture(int textureArray, vec3 textureCoordinate)
+{
+#ifdef GL_ARB_bindless_texture
+	return(texture(sampler2DArray(textureHandles[textureArray]), textureCoordinate));
+#else
+	return(texture(textureArrays[textureArray], textureCoordinate));
+#endif
+}
+
+void main()
+{
+	DrawData draw = drawData[fragmentDrawID];
+	vec4 baseColor = fragmentColor;
+
+	if (draw.textureArray >= 0)
+	{
+		baseColor = SampleTexture(draw.textureArray, vec3(fragmentTextureCoordinate * draw.uvScale, draw.textureLayer));
+	}
+
+	// only opaque objects get impostors, so every covered
+	// texel is marked fully opaque
+	outColor = vec4(baseColor.rgb, 1.0f);
+	outNormal = vec4(normalize(fragmentVertexNormal) * 0.5f + 0.5f, 1.0f);
+}
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorFragmentShader.glsl
+// ============
+// shade the impostor quads from the baked color and normal views, with the
+// material of their instance and up to four Phong light sources
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+#define TOTAL_LIGHTS 4
+
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+// material values as packed in the material buffer
+struct MaterialData
+{
+	vec4 ambientColorStrength;
+	vec4 diffuseColor;
+	vec4 specularColorShininess;
+};
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentAtlasCoordinate;
+flat in vec4 fragmentRotation;
+flat in int fragmentMaterialIndex;
+
+out vec4 outFragmentColor;
+
+layout(std430, binding = 2) readonly buffer MaterialBuffer
+{
+	MaterialData materials[];
+};
+
+uniform sampler2DArray colorAtlas;
+uniform sampler2DArray normalAtlas;
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// turn a vector by a quaternion
+vec3 Rotate(vec4 rotation, vec3 v)
+{
+	return(v + 2.0f * cross(rotation.xyz, cross(rotation.xyz, v) + rotation.w * v));
+}
+
+// calculate the Phong contribution of one light source
+vec3 CalculateLightSource(LightSource lightSource, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+
+	// ambient lighting
+	ambient = lightSource.ambientColor * material.ambientColor * material.ambientStrength;
+
+	// diffuse lighting
+	vec3 lightDirection = normalize(lightSource.position - vertexPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	diffuse = impact * lightSource.diffuseColor * material.diffuseColor;
+
+	// specular lighting - the light's focal strength and the
+	// material's shininess both tighten the highlight
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), lightSource.focalStrength + material.shininess);
+	specular = lightSource.specularIntensity * specularComponent * lightSource.specularColor * material.specularColor;
+
+	return(ambient + diffuse + specular);
+}
+
+void main()
+{
+	vec4 baseColor = texture(colorAtlas, fragmentAtlasCoordinate);
+
+	// the quad is larger than the object, and the filtered
+	// edge of the silhouette is cut at half coverage
+	if (baseColor.a < 0.5f)
+	{
+		discard;
+	}
+
+	if (bUseLighting == true)
+	{
+		// the normals were baked in the frame of the object
+		vec3 bakedNormal = texture(normalAtlas, fragmentAtlasCoordinate).xyz * 2.0f - 1.0f;
+		vec3 lightNormal = normalize(Rotate(fragmentRotation, bakedNormal));
+		vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+		vec3 phongResult = vec3(0.0f);
+
+		// an instance without a material is lit with zeroed values
+		Material material = Material(vec3(0.0f), 0.0f, vec3(0.0f), vec3(0.0f), 0.0f);
+		if (fragmentMaterialIndex >= 0)
+		{
+			MaterialData materialData = materials[fragmentMaterialIndex];
+			material.ambientColor = materialData.ambientColorStrength.rgb;
+			material.ambientStrength = materialData.ambientColorStrength.a;
+			material.diffuseColor = materialData.diffuseColor.rgb;
+			material.specularColor = materialData.specularColorShininess.rgb;
+			material.shininess = materialData.specularColorShininess.a;
+		}
+
+		for (int i = 0; i < TOTAL_LIGHTS; i++)
+		{
+			phongResult += CalculateLightSource(lightSources[i], material, lightNormal, fragmentPosition, viewDirection);
+		}
+
+		outFragmentColor = vec4(phongResult * baseColor.rgb, 1.0f);
+	}
+	else
+	{
+		outFragmentColor = vec4(baseColor.rgb, 1.0f);
+	}
+}
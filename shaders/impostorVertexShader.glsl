@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorVertexShader.glsl
+// ============
+// turn the quad of each impostor instance to the baked view nearest the
+// direction of the camera and place it over the bounds of the object
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+// views baked per impostor on each side of the grid
+#define VIEW_GRID 8
+#define TOTAL_LIGHTS 4
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+layout (location = 0) in vec2 inCorner;
+// per-instance values of the impostor
+layout (location = 1) in vec4 inCenterRadius;
+layout (location = 2) in vec4 inRotation;
+layout (location = 3) in int inLayer;
+layout (location = 4) in int inMaterial;
+
+out vec3 fragmentPosition;
+out vec3 fragmentAtlasCoordinate;
+flat out vec4 fragmentRotation;
+flat out int fragmentMaterialIndex;
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// turn a vector by a quaternion
+vec3 Rotate(vec4 rotation, vec3 v)
+{
+	return(v + 2.0f * cross(rotation.xyz, cross(rotation.xyz, v) + rotation.w * v));
+}
+
+// fold a direction onto the octahedral square, from -1 to 1
+vec2 EncodeOctahedral(vec3 direction)
+{
+	direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+	vec2 octahedral = direction.xz;
+	if (direction.y < 0.0f)
+	{
+		vec2 signs = vec2((octahedral.x >= 0.0f) ? 1.0f : -1.0f, (octahedral.y >= 0.0f) ? 1.0f : -1.0f);
+		octahedral = (1.0f - abs(octahedral.yx)) * signs;
+	}
+	return(octahedral);
+}
+
+// unfold a point of the octahedral square back into a direction
+vec3 DecodeOctahedral(vec2 octahedral)
+{
+	vec3 direction = vec3(octahedral.x, 1.0f - abs(octahedral.x) - abs(octahedral.y), octahedral.y);
+	if (direction.y < 0.0f)
+	{
+		vec2 signs = vec2((octahedral.x >= 0.0f) ? 1.0f : -1.0f, (octahedral.y >= 0.0f) ? 1.0f : -1.0f);
+		direction.xz = (1.0f - abs(octahedral.yx)) * signs;
+	}
+	return(normalize(direction));
+}
+
+void main()
+{
+	vec3 center = inCenterRadius.xyz;
+	float radius = inCenterRadius.w;
+	// the inverse of a unit quaternion turns the world back
+	// into the frame the views were baked in
+	vec4 inverseRotation = vec4(-inRotation.xyz, inRotation.w);
+
+	// every corner picks the same view, from the center
+	vec3 toCamera = Rotate(inverseRotation, normalize(viewPosition - center));
+	vec2 octahedral = EncodeOctahedral(toCamera);
+	ivec2 cell = clamp(ivec2((octahedral * 0.5f + 0.5f) * VIEW_GRID), ivec2(0), ivec2(VIEW_GRID - 1));
+
+	// the quad faces the direction the view was baked from,
+	// with the same right and up vectors as the bake camera
+	vec3 viewDirection = DecodeOctahedral((vec2(cell) + 0.5f) * (2.0f / VIEW_GRID) - 1.0f);
+	vec3 up = (abs(viewDirection.y) > 0.999f) ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+	vec3 right = normalize(cross(up, viewDirection));
+	up = cross(viewDirection, right);
+
+	vec3 corner = (right * inCorner.x + up * inCorner.y) * radius;
+	vec3 worldPosition = center + Rotate(inRotation, corner);
+
+	fragmentPosition = worldPosition;
+	fragmentAtlasCoordinate = vec3((vec2(cell) + inCorner * 0.5f + 0.5f) / VIEW_GRID, inLayer);
+	fragmentRotation = inRotation;
+	fragmentMaterialIndex = inMaterial;
+
+	gl_Position = projection * view * vec4(worldPosition, 1.0f);
+}
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// oitCompositeFragmentShader.glsl
+// ============
+// resolve the weighted blended translucent color of each pixel, with the
+// revealage as the alpha the scene behind it is kept by
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+out vec4 outFragmentColor;
+
+uniform sampler2D accumulationTexture;
+uniform sampler2D revealageTexture;
+// the targets start at the corner of the viewport, not the window
+uniform vec2 viewportOrigin;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy - viewportOrigin);
+	float revealage = texelFetch(revealageTexture, texel, 0).r;
+
+	// nothing translucent covered this pixel
+	if (revealage >= 1.0f)
+	{
+		discard;
+	}
+
+	vec4 accumulation = texelFetch(accumulationTexture, texel, 0);
+	vec3 averageColor = accumulation.rgb / max(accumulation.a, 0.00001f);
+
+	outFragmentColor = vec4(averageColor, revealage);
+}
@@ -0,0 +1,15 @@
+///////////////////////////////////////////////////////////////////////////////
+// oitCompositeVertexShader.glsl
+// ============
+// make up one triangle that covers the whole viewport, for blending the
+// accumulated translucent color over the scene
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+void main()
+{
+	// corners at (-1, -1), (3, -1) and (-1, 3)
+	vec2 position = vec2((gl_VertexID == 1) ? 3.0f : -1.0f, (gl_VertexID == 2) ? 3.0f : -1.0f);
+
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
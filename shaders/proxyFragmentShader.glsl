@@ -0,0 +1,11 @@
+///////////////////////////////////////////////////////////////////////////////
+// proxyFragmentShader.glsl
+// ============
+// the proxy boxes only need to be depth tested for the occlusion queries,
+// so nothing is written
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+void main()
+{
+}
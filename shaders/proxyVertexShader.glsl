@@ -0,0 +1,21 @@
+///////////////////////////////////////////////////////////////////////////////
+// proxyVertexShader.glsl
+// ============
+// stretch the unit cube over the bounding box of each drawn instance, for
+// the occlusion queries that test the scene objects
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+layout (location = 0) in vec3 inVertexPosition;
+// per-instance corners of the bounding box
+layout (location = 1) in vec3 inProxyMin;
+layout (location = 2) in vec3 inProxyMax;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+	vec3 worldPosition = mix(inProxyMin, inProxyMax, inVertexPosition);
+
+	gl_Position = viewProjection * vec4(worldPosition, 1.0f);
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationControlShader.glsl
+// ============
+// subdivide every edge of a surface patch by its length on screen, so the
+// shapes get as many triangles as their size in pixels calls for
+///////////////////////////////////////////////////////////////////////////////
+
+// the most a patch edge can be subdivided
+#define MAX_TESSELLATION_LEVEL 64.0f
+#define TOTAL_LIGHTS 4
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+layout (vertices = 4) out;
+
+in vec3 controlPatchCorner[];
+in mat4 controlModel[];
+in vec4 controlColor[];
+flat in int controlMaterialIndex[];
+
+out vec3 evaluationPatchCorner[];
+// the instance values are the same for the whole patch
+patch out mat4 patchModel;
+patch out vec4 patchColor;
+patch out int patchMaterialIndex;
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+uniform vec2 viewportSize;
+// length in pixels the edges are subdivided down to
+uniform float targetEdgePixels;
+
+// position of a surface point in pixels
+vec2 ToScreen(mat4 modelViewProjection, int surface, vec2 surfaceUV)
+{
+	vec3 position;
+	vec3 normal;
+	vec2 textureCoordinate;
+	EvaluateSurface(surface, surfaceUV, position, normal, textureCoordinate);
+
+	// points behind the camera are clamped, the level is
+	// capped at the maximum either way
+	vec4 clipPosition = modelViewProjection * vec4(position, 1.0f);
+	return(clipPosition.xy / max(clipPosition.w, 0.0001f) * 0.5f * viewportSize);
+}
+
+// subdivision of the edge between two patch corners, measured through
+// its midpoint so curved edges are not underestimated - both patches
+// sharing an edge measure it from the same points and agree on it
+float EdgeLevel(mat4 modelViewProjection, int surface, vec2 cornerA, vec2 cornerB)
+{
+	vec2 screenA = ToScreen(modelViewProjection, surface, cornerA);
+	vec2 screenMiddle = ToScreen(modelViewProjection, surface, 0.5f * (cornerA + cornerB));
+	vec2 screenB = ToScreen(modelViewProjection, surface, cornerB);
+	float pixels = length(screenMiddle - screenA) + length(screenB - screenMiddle);
+
+	return(clamp(pixels / targetEdgePixels, 1.0f, MAX_TESSELLATION_LEVEL));
+}
+
+void main()
+{
+	evaluationPatchCorner[gl_InvocationID] = controlPatchCorner[gl_InvocationID];
+
+	if (gl_InvocationID == 0)
+	{
+		patchModel = controlModel[0];
+		patchColor = controlColor[0];
+		patchMaterialIndex = controlMaterialIndex[0];
+
+		mat4 modelViewProjection = projection * view * controlModel[0];
+		int surface = int(controlPatchCorner[0].z + 0.5f);
+		vec2 corner0 = controlPatchCorner[0].xy;
+		vec2 corner1 = controlPatchCorner[1].xy;
+		vec2 corner2 = controlPatchCorner[2].xy;
+		vec2 corner3 = controlPatchCorner[3].xy;
+
+		// outer levels for the edges at U = 0, V = 0, U = 1, V = 1
+		gl_TessLevelOuter[0] = EdgeLevel(modelViewProjection, surface, corner0, corner3);
+		gl_TessLevelOuter[1] = EdgeLevel(modelViewProjection, surface, corner0, corner1);
+		gl_TessLevelOuter[2] = EdgeLevel(modelViewProjection, surface, corner1, corner2);
+		gl_TessLevelOuter[3] = EdgeLevel(modelViewProjection, surface, corner3, corner2);
+		gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+		gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+	}
+}
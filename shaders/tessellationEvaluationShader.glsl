@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationEvaluationShader.glsl
+// ============
+// place the subdivided patch points on their surface and pass them on to
+// the scene fragment shader like the vertices of the precomputed meshes
+///////////////////////////////////////////////////////////////////////////////
+
+#define TOTAL_LIGHTS 4
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+layout (quads, fractional_even_spacing, ccw) in;
+
+in vec3 evaluationPatchCorner[];
+patch in mat4 patchModel;
+patch in vec4 patchColor;
+patch in int patchMaterialIndex;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+out vec4 fragmentColor;
+flat out int fragmentDrawID;
+flat out int fragmentMaterialIndex;
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// index of the per-draw values, the patches are not drawn indirectly
+uniform int drawIndex;
+
+void main()
+{
+	int surface = int(evaluationPatchCorner[0].z + 0.5f);
+	vec2 surfaceUV = mix(
+		mix(evaluationPatchCorner[0].xy, evaluationPatchCorner[1].xy, gl_TessCoord.x),
+		mix(evaluationPatchCorner[3].xy, evaluationPatchCorner[2].xy, gl_TessCoord.x),
+		gl_TessCoord.y);
+
+	vec3 position;
+	vec3 normal;
+	vec2 textureCoordinate;
+	EvaluateSurface(surface, surfaceUV, position, normal, textureCoordinate);
+
+	vec4 worldPosition = patchModel * vec4(position, 1.0f);
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(patchModel))) * normal;
+	fragmentTextureCoordinate = textureCoordinate;
+	fragmentColor = patchColor;
+	fragmentDrawID = drawIndex;
+	fragmentMaterialIndex = patchMaterialIndex;
+
+	gl_Position = projection * view * worldPosition;
+}
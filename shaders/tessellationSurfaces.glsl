@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationSurfaces.glsl
+// ============
+// parametric surfaces of the tessellated torus, cylinder and cone, compiled
+// ahead of the tessellation control and evaluation shaders
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+// surface ids stored with the patch corners
+#define SURFACE_TORUS 0
+#define SURFACE_CYLINDER_SIDE 1
+#define SURFACE_CYLINDER_BOTTOM 2
+#define SURFACE_CYLINDER_TOP 3
+#define SURFACE_CONE_SIDE 4
+#define SURFACE_CONE_BOTTOM 5
+
+const float PI = 3.14159265358979;
+
+// tube thickness of the torus, matching the precomputed torus mesh
+uniform float torusThickness;
+
+// position, normal and texture coordinate of a point on a surface, in
+// the same model space and layout as the precomputed meshes - U runs
+// around every shape, V along the torus tube, up the sides, or out from
+// the center of the caps
+void EvaluateSurface(
+	int surface,
+	vec2 surfaceUV,
+	out vec3 position,
+	out vec3 normal,
+	out vec2 textureCoordinate)
+{
+	float angle = 2.0f * PI * surfaceUV.x;
+	float x = cos(angle);
+	float z = sin(angle);
+
+	if (surface == SURFACE_TORUS)
+	{
+		float tubeAngle = 2.0f * PI * surfaceUV.y;
+		float ringRadius = 1.0f + torusThickness * cos(tubeAngle);
+		position = vec3(ringRadius * x, ringRadius * z, torusThickness * sin(tubeAngle));
+		normal = vec3(cos(tubeAngle) * x, cos(tubeAngle) * z, sin(tubeAngle));
+		textureCoordinate = surfaceUV;
+	}
+	else if (surface == SURFACE_CYLINDER_SIDE)
+	{
+		position = vec3(x, surfaceUV.y, z);
+		normal = vec3(x, 0.0f, z);
+		textureCoordinate = surfaceUV;
+	}
+	else if (surface == SURFACE_CONE_SIDE)
+	{
+		// the side slopes at 45 degrees from the base to the apex
+		float radius = 1.0f - surfaceUV.y;
+		position = vec3(radius * x, surfaceUV.y, radius * z);
+		normal = normalize(vec3(x, 1.0f, z));
+		textureCoordinate = surfaceUV;
+	}
+	else
+	{
+		// the caps are discs, V is the distance from the center
+		float height = (surface == SURFACE_CYLINDER_TOP) ? 1.0f : 0.0f;
+		position = vec3(surfaceUV.y * x, height, surfaceUV.y * z);
+		normal = vec3(0.0f, (surface == SURFACE_CYLINDER_TOP) ? 1.0f : -1.0f, 0.0f);
+		textureCoordinate = vec2(0.5f) + 0.5f * position.xz;
+	}
+}
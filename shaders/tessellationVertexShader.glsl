@@ -0,0 +1,27 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationVertexShader.glsl
+// ============
+// pass the patch corners of the tessellated shapes through, along with the
+// model matrix, color and material of each drawn instance
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+// surface U and V, and the surface id
+layout (location = 0) in vec3 inPatchCorner;
+// per-instance values, the model matrix takes locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in int inInstanceMaterial;
+
+out vec3 controlPatchCorner;
+out mat4 controlModel;
+out vec4 controlColor;
+flat out int controlMaterialIndex;
+
+void main()
+{
+	controlPatchCorner = inPatchCorner;
+	controlModel = inInstanceModel;
+	controlColor = inInstanceColor;
+	controlMaterialIndex = inInstanceMaterial;
+}
@@ -0,0 +1,18 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureBenchmarkFragmentShader.glsl
+// ============
+// sample the first layer of a texture array and nothing else, so the
+// time taken follows the texture bandwidth
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+in vec2 fragmentTextureCoordinate;
+
+out vec4 fragmentColor;
+
+uniform sampler2DArray textureArray;
+
+void main()
+{
+	fragmentColor = texture(textureArray, vec3(fragmentTextureCoordinate, 0.0f));
+}
@@ -0,0 +1,21 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureBenchmarkVertexShader.glsl
+// ============
+// make up one triangle that covers the whole viewport, with texture
+// coordinates repeating the texture across it a given number of times
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+out vec2 fragmentTextureCoordinate;
+
+// texture coordinates at the far corner of the viewport
+uniform vec2 uvScale;
+
+void main()
+{
+	// corners at (-1, -1), (3, -1) and (-1, 3)
+	vec2 position = vec2((gl_VertexID == 1) ? 3.0f : -1.0f, (gl_VertexID == 2) ? 3.0f : -1.0f);
+
+	fragmentTextureCoordinate = (position * 0.5f + 0.5f) * uvScale;
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexShader.glsl
+// ============
+// transform the scene meshes, reading the model matrix, color and material
+// of each drawn instance from the instance attributes, and pass the index
+// of the per-draw values on to the fragment shader
+///////////////////////////////////////////////////////////////////////////////
+#version 460 core
+
+#define TOTAL_LIGHTS 4
+
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance values, the model matrix takes locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in int inInstanceMaterial;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+out vec4 fragmentColor;
+// index of the indirect draw command, the same for every vertex of a draw
+flat out int fragmentDrawID;
+flat out int fragmentMaterialIndex;
+
+// view and light values shared by every program that draws the
+// scene, written by the application once a frame
+layout (std140, binding = 0) uniform SceneUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPosition;
+	bool bUseLighting;
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// index of the per-draw values of the first command drawn, since
+// gl_DrawID counts from 0 in every indirect draw call
+uniform int firstDrawID = 0;
+
+// the depth pre-pass has to come to the very same position
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = inInstanceModel * vec4(inVertexPosition, 1.0f);
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(inInstanceModel))) * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate;
+	fragmentColor = inInstanceColor;
+	fragmentDrawID = firstDrawID + gl_DrawID;
+	fragmentMaterialIndex = inInstanceMaterial;
+
+	gl_Position = projection * view * worldPosition;
+}